@@ -17,6 +17,7 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -108,6 +109,25 @@ class EngineOptions {
         return enable_window_column_pruning_;
     }
 
+    /// Set `true` to rewrite the literals compared with the columns in where clauses into parameters in batch
+    /// mode, so the queries different only in these literals share one compiling result, default `false`.
+    inline EngineOptions* SetEnableParameterizeLiteral(bool flag) {
+        enable_parameterize_literal_ = flag;
+        return this;
+    }
+    /// Return if the engine rewrites the literals into parameters
+    inline bool IsEnableParameterizeLiteral() const { return enable_parameterize_literal_; }
+
+    /// Set the times a batch mode sql is got from the cache before it's recompiled with the optimizations in the
+    /// background, the sql is compiled without the optimizations at first, so a query running once takes less time
+    /// to compile. Default `0` means the sqls are always compiled with the optimizations.
+    inline EngineOptions* SetTieredCompileThreshold(uint32_t threshold) {
+        tiered_compile_threshold_ = threshold;
+        return this;
+    }
+    /// Return the times a batch mode sql is got from the cache before it's recompiled with the optimizations
+    inline uint32_t GetTieredCompileThreshold() const { return tiered_compile_threshold_; }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void SetMaxSqlCacheSize(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -127,10 +147,28 @@ class EngineOptions {
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
     bool enable_window_column_pruning_;
+    bool enable_parameterize_literal_;
+    uint32_t tiered_compile_threshold_;
     uint32_t max_sql_cache_size_;
     JitOptions jit_options_;
 };
 
+/// \brief Statistics of the compiling result cache of Engine.
+struct EngineCacheStat {
+    uint64_t hit = 0;
+    uint64_t miss = 0;
+    /// the compilations which reuse the result of a concurrent compilation of the same sql
+    uint64_t shared = 0;
+    uint64_t compile_cnt = 0;
+    uint64_t compile_time_us = 0;
+    /// the fast compiled sqls recompiled with the optimizations in the background after they are hot
+    uint64_t recompile_cnt = 0;
+};
+
+struct EngineCacheShard;
+class TieredCompileWorker;
+class SqlCompileInfo;
+
 /// \brief A RunSession maintain SQL running context, including compile information, procedure name.
 ///
 class RunSession {
@@ -213,6 +251,9 @@ class BatchRunSession : public RunSession {
     virtual const Schema& GetParameterSchema() const { return parameter_schema_; }
  private:
     codec::Schema parameter_schema_;
+    // the literals rewritten into parameters by the engine, it's used instead of the empty parameter row in Run
+    Row literal_parameter_row_;
+    friend Engine;
 };
 
 /// \brief MockRequestRunSession is a kind of mock RuSession design for request query
@@ -420,6 +461,9 @@ class Engine {
     /// \brief Clear engine's compiling result cache
     void ClearCacheLocked(const std::string& db);
 
+    /// \brief Get the statistics of engine's compiling result cache
+    EngineCacheStat GetCacheStat() const;
+
     /// \brief Get engine's options
     EngineOptions GetEngineOptions();
 
@@ -435,12 +479,26 @@ class Engine {
     // error even request rows is empty, instead checks should performed at the very beginning of Compute.
     static absl::Status ExtractRequestRowsInSQL(SqlContext* ctx);
 
-    std::shared_ptr<CompileInfo> GetCacheLocked(const std::string& db,
-                                                const std::string& sql,
-                                                EngineMode engine_mode);
-    bool SetCacheLocked(const std::string& db, const std::string& sql,
-                        EngineMode engine_mode,
-                        std::shared_ptr<CompileInfo> info);
+    // the caches of a db and an engine mode are split into the shards by the sql, so the sqls of one db don't contend
+    // for one lock. the caller should hold the lock of the shard to access its cache
+    EngineCacheShard* GetCacheShard(const std::string& db, EngineMode engine_mode, const std::string& sql);
+    std::shared_ptr<CompileInfo> GetCache(EngineCacheShard* shard, const std::string& db, const std::string& sql,
+                                          EngineMode engine_mode);
+    bool SetCache(EngineCacheShard* shard, const std::string& db, const std::string& sql, EngineMode engine_mode,
+                  std::shared_ptr<CompileInfo> info);
+
+    bool GetOrCompile(const std::string& sql, const std::string& db, RunSession& session,  // NOLINT
+                      base::Status& status);  // NOLINT
+    // compile the sql with the literals rewritten into parameters, false if it's not rewritten or fails to compile
+    bool GetParameterized(const std::string& sql, const std::string& db, BatchRunSession* session);
+
+    // compile the sql without the cache, fast_compile skips the optimizations of the jit
+    bool Compile(const std::string& sql, const std::string& db, RunSession& session,  // NOLINT
+                 bool fast_compile, std::shared_ptr<CompileInfo>* info, base::Status& status);  // NOLINT
+    // return the optimized result of the fast compiled one got from the cache if it's ready, the optimized one is
+    // compiled in the background once the fast compiled one is hot
+    std::shared_ptr<CompileInfo> TierUp(std::shared_ptr<CompileInfo> info);
+    void CompileOptimized(std::shared_ptr<SqlCompileInfo> info);
 
     bool IsCompatibleCache(RunSession& session,  // NOLINT
                            std::shared_ptr<CompileInfo> info,
@@ -452,8 +510,14 @@ class Engine {
                  ExplainOutput* explain_output, base::Status* status);
     std::shared_ptr<Catalog> cl_;
     EngineOptions options_;
-    base::SpinMutex mu_;
-    EngineLRUCache lru_cache_;
+    std::vector<std::unique_ptr<EngineCacheShard>> cache_shards_;
+    // (engine mode, db) -> the number of the sqls cached in all the shards. the shards share max_sql_cache_size of a
+    // db and an engine mode, so a shard holds more sqls if the others hold less. it's locked after the shard lock
+    base::SpinMutex cache_budget_mu_;
+    std::map<std::pair<EngineMode, std::string>, uint32_t> cached_sql_num_;
+    // nullptr if the tiered compilation is disabled. it's destroyed first, so the running compilation finishes
+    // before the other members are destroyed
+    std::unique_ptr<TieredCompileWorker> tiered_compile_worker_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -119,11 +119,29 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    // the directory to keep the compiled object code, the modules compiled before are loaded from it instead of
+    // running the codegen again. empty means the object code is not cached
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    // the max total size in bytes of the cached object code, the least recently used objects are removed beyond it.
+    // 0 means no limit
+    uint64_t GetObjectCacheMaxSize() const { return object_cache_max_size_; }
+    void SetObjectCacheMaxSize(uint64_t size) { object_cache_max_size_ = size; }
+
+    // compile the module without the ir optimization passes and with the lowest codegen optimization level, it takes
+    // less time to compile but the code runs slower
+    bool IsEnableFastCompile() const { return enable_fast_compile_; }
+    void SetEnableFastCompile(bool flag) { enable_fast_compile_ = flag; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    bool enable_fast_compile_ = false;
+    std::string object_cache_dir_;
+    uint64_t object_cache_max_size_ = 0;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -16,18 +16,30 @@
 
 #include "vm/engine.h"
 
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/ascii.h"
 #include "absl/time/clock.h"
-#include "boost/none.hpp"
 #include "codec/fe_row_codec.h"
 #include "gflags/gflags.h"
 #include "llvm-c/Target.h"
 #include "plan/plan_api.h"
 #include "udf/default_udf_library.h"
 #include "vm/internal/node_helper.h"
+#include "vm/literal_parameterizer.h"
 #include "vm/local_tablet_handler.h"
 #include "vm/mem_catalog.h"
 #include "vm/runner_ctx.h"
@@ -50,15 +62,145 @@ EngineOptions::EngineOptions()
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
       enable_window_column_pruning_(false),
+      enable_parameterize_literal_(false),
+      tiered_compile_threshold_(0),
       max_sql_cache_size_(50) {
 }
 
 static absl::Status ExtractRows(const node::ExprNode* expr, const codec::Schema* sc, std::vector<codec::Row>* out)
     ABSL_ATTRIBUTE_NONNULL();
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+static constexpr uint32_t CACHE_SHARD_NUM = 16;
+// the hot sqls waiting to be recompiled, the ones beyond it keep the fast compiled result
+static constexpr uint32_t MAX_PENDING_RECOMPILE_NUM = 64;
+
+// a running compilation, the concurrent compilations of the same sql wait for its result
+struct CompileFlight {
+    std::mutex mu;
+    std::condition_variable cv;
+    bool done = false;
+    // nullptr if the compilation fails
+    std::shared_ptr<CompileInfo> info;
+};
+
+// the sqls of a db and an engine mode cached in a shard, from the most recently used one
+class SqlLRUCache {
+ public:
+    // nullptr if the sql is not cached
+    std::shared_ptr<CompileInfo> Get(const std::string& sql) {
+        auto it = map_.find(sql);
+        if (it == map_.end()) {
+            return nullptr;
+        }
+        list_.splice(list_.begin(), list_, it->second);
+        return it->second->second;
+    }
+    bool Contains(const std::string& sql) const { return map_.count(sql) > 0; }
+    // the sql should not be cached yet
+    void Insert(const std::string& sql, std::shared_ptr<CompileInfo> info) {
+        list_.emplace_front(sql, std::move(info));
+        map_.emplace(sql, list_.begin());
+    }
+    void EvictOldest() {
+        map_.erase(list_.back().first);
+        list_.pop_back();
+    }
+    size_t Size() const { return map_.size(); }
+    bool Empty() const { return map_.empty(); }
+
+ private:
+    std::list<std::pair<std::string, std::shared_ptr<CompileInfo>>> list_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::shared_ptr<CompileInfo>>>::iterator> map_;
+};
+
+struct EngineCacheShard {
+    base::SpinMutex mu;
+    // the max number of the sqls in parameterize_failed
+    uint32_t capacity = 0;
+    // engine mode -> db -> the cached sqls
+    std::map<EngineMode, std::map<std::string, SqlLRUCache>> lru_cache;
+    // (engine mode, db, sql) -> the running compilation
+    std::map<std::tuple<EngineMode, std::string, std::string>, std::shared_ptr<CompileFlight>> flights;
+    // increased when the cache is cleared, the compilation started before doesn't fill the cache
+    uint64_t version = 0;
+    // (db, parameterized sql) failed to compile, e.g. the parameter is not supported where the literal is, the sql
+    // is compiled with the literals without trying the parameterized one again
+    std::set<std::pair<std::string, std::string>> parameterize_failed;
+    std::atomic<uint64_t> hit{0};
+    std::atomic<uint64_t> miss{0};
+    std::atomic<uint64_t> shared{0};
+    std::atomic<uint64_t> compile_cnt{0};
+    std::atomic<uint64_t> compile_time_us{0};
+    std::atomic<uint64_t> recompile_cnt{0};
+};
+
+// TieredCompileWorker recompiles the hot sqls with the optimizations in a background thread one by one
+class TieredCompileWorker {
+ public:
+    TieredCompileWorker() : thread_(&TieredCompileWorker::Run, this) {}
+    ~TieredCompileWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    // return false if there are too many pending tasks
+    bool Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (tasks_.size() >= MAX_PENDING_RECOMPILE_NUM) {
+                return false;
+            }
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+ private:
+    void Run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::deque<std::function<void()>> tasks_;
+    std::thread thread_;
+};
+
+// the sqls different only in the leading and trailing whitespaces share the cache
+static std::string NormalizeSql(const std::string& sql) { return std::string(absl::StripAsciiWhitespace(sql)); }
+
+Engine::Engine(const std::shared_ptr<Catalog>& catalog) : Engine(catalog, EngineOptions()) {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
+    : cl_(catalog), options_(options) {
+    uint32_t cache_size = options_.GetMaxSqlCacheSize();
+    uint32_t shard_num = std::max(1u, std::min(CACHE_SHARD_NUM, cache_size));
+    for (uint32_t i = 0; i < shard_num; i++) {
+        auto shard = std::make_unique<EngineCacheShard>();
+        shard->capacity = cache_size / shard_num + (i < cache_size % shard_num ? 1 : 0);
+        cache_shards_.push_back(std::move(shard));
+    }
+    if (options_.GetTieredCompileThreshold() > 0) {
+        tiered_compile_worker_ = std::make_unique<TieredCompileWorker>();
+    }
+}
 Engine::~Engine() {}
 
 static bool InitializeLLVM() {
@@ -148,7 +290,86 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
-    std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
+    if (options_.IsEnableParameterizeLiteral() && session.engine_mode() == kBatchMode) {
+        auto batch_sess = dynamic_cast<BatchRunSession*>(&session);
+        if (!batch_sess->literal_parameter_row_.empty()) {
+            // the session is reused, the parameters are the literals of the last sql
+            batch_sess->SetParameterSchema(codec::Schema());
+            batch_sess->literal_parameter_row_ = Row();
+        }
+        if (batch_sess->GetParameterSchema().empty() && GetParameterized(sql, db, batch_sess)) {
+            status = base::Status::OK();
+            return true;
+        }
+    }
+    return GetOrCompile(sql, db, session, status);
+}
+
+bool Engine::GetParameterized(const std::string& sql, const std::string& db, BatchRunSession* session) {
+    std::string parameterized_sql;
+    codec::Schema parameter_schema;
+    Row parameter_row;
+    if (!ParameterizeLiterals(sql, &parameterized_sql, &parameter_schema, &parameter_row)) {
+        return false;
+    }
+    auto key = std::make_pair(db, NormalizeSql(parameterized_sql));
+    auto shard = GetCacheShard(db, kBatchMode, key.second);
+    {
+        std::lock_guard<base::SpinMutex> lock(shard->mu);
+        if (shard->parameterize_failed.count(key) > 0) {
+            return false;
+        }
+    }
+    session->SetParameterSchema(parameter_schema);
+    base::Status status;
+    if (!GetOrCompile(parameterized_sql, db, *session, status)) {
+        DLOG(INFO) << "fail to compile parameterized sql " << parameterized_sql << ": " << status.msg;
+        session->SetParameterSchema(codec::Schema());
+        std::lock_guard<base::SpinMutex> lock(shard->mu);
+        if (shard->parameterize_failed.size() >= shard->capacity) {
+            shard->parameterize_failed.clear();
+        }
+        shard->parameterize_failed.insert(key);
+        return false;
+    }
+    session->literal_parameter_row_ = parameter_row;
+    return true;
+}
+
+bool Engine::GetOrCompile(const std::string& sql, const std::string& db, RunSession& session,
+                          base::Status& status) {  // NOLINT (runtime/references)
+    const EngineMode engine_mode = session.engine_mode();
+    const std::string key = NormalizeSql(sql);
+    auto shard = GetCacheShard(db, engine_mode, key);
+    std::shared_ptr<CompileInfo> cached_info;
+    std::shared_ptr<CompileFlight> flight;
+    bool leader = false;
+    uint64_t version = 0;
+    {
+        std::lock_guard<base::SpinMutex> lock(shard->mu);
+        cached_info = GetCache(shard, db, key, engine_mode);
+        if (!cached_info) {
+            auto& running = shard->flights[std::make_tuple(engine_mode, db, key)];
+            if (!running) {
+                running = std::make_shared<CompileFlight>();
+                leader = true;
+            }
+            flight = running;
+            version = shard->version;
+        }
+    }
+    if (cached_info) {
+        shard->hit.fetch_add(1, std::memory_order_relaxed);
+        cached_info = TierUp(cached_info);
+    } else if (!leader) {
+        // wait for the concurrent compilation of the same sql instead of compiling it again
+        std::unique_lock<std::mutex> lock(flight->mu);
+        flight->cv.wait(lock, [&flight] { return flight->done; });
+        cached_info = flight->info;
+        if (cached_info) {
+            shard->shared.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
         session.SetCompileInfo(cached_info);
         return true;
@@ -158,6 +379,91 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         LOG(WARNING) << status;
         status = base::Status::OK();
     }
+    shard->miss.fetch_add(1, std::memory_order_relaxed);
+    absl::Time start = absl::Now();
+    std::shared_ptr<CompileInfo> info;
+    // only the batch mode queries, which are mostly ad-hoc, are compiled fast at first. the deployments run in the
+    // request mode are hot from the beginning
+    bool fast_compile = tiered_compile_worker_ != nullptr && engine_mode == kBatchMode;
+    bool ok = Compile(sql, db, session, fast_compile, &info, status);
+    shard->compile_cnt.fetch_add(1, std::memory_order_relaxed);
+    shard->compile_time_us.fetch_add(absl::ToInt64Microseconds(absl::Now() - start), std::memory_order_relaxed);
+    {
+        std::lock_guard<base::SpinMutex> lock(shard->mu);
+        if (ok && (!leader || version == shard->version)) {
+            SetCache(shard, db, key, engine_mode, info);
+        }
+        if (leader) {
+            shard->flights.erase(std::make_tuple(engine_mode, db, key));
+        }
+    }
+    if (leader) {
+        std::lock_guard<std::mutex> lock(flight->mu);
+        flight->done = true;
+        if (ok) {
+            flight->info = info;
+        }
+        flight->cv.notify_all();
+    }
+    if (!ok) {
+        return false;
+    }
+    session.SetCompileInfo(info);
+    if (session.is_debug_) {
+        auto& sql_context = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+        std::ostringstream plan_oss;
+        if (nullptr != sql_context.physical_plan) {
+            sql_context.physical_plan->Print(plan_oss, "");
+            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
+        }
+        std::ostringstream runner_oss;
+        sql_context.cluster_job->Print(runner_oss, "");
+        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
+    }
+    return true;
+}
+
+std::shared_ptr<CompileInfo> Engine::TierUp(std::shared_ptr<CompileInfo> info) {
+    if (!tiered_compile_worker_) {
+        return info;
+    }
+    auto sql_info = std::dynamic_pointer_cast<SqlCompileInfo>(info);
+    if (!sql_info || !sql_info->get_sql_context().jit_options.IsEnableFastCompile()) {
+        return info;
+    }
+    auto optimized = sql_info->GetOptimized();
+    if (optimized) {
+        return optimized;
+    }
+    // the hit count passes the threshold only once, so the sql is recompiled once
+    if (sql_info->IncreaseHitCount() == options_.GetTieredCompileThreshold()) {
+        if (!tiered_compile_worker_->Submit([this, sql_info]() { CompileOptimized(sql_info); })) {
+            DLOG(INFO) << "too many sqls waiting to be recompiled, skip " << sql_info->GetSql();
+        }
+    }
+    return info;
+}
+
+void Engine::CompileOptimized(std::shared_ptr<SqlCompileInfo> info) {
+    auto& ctx = info->get_sql_context();
+    BatchRunSession session;
+    session.SetParameterSchema(ctx.parameter_types);
+    session.SetOptions(ctx.options);
+    session.SetIndexHintsHandler(ctx.index_hints);
+    base::Status status;
+    std::shared_ptr<CompileInfo> optimized;
+    absl::Time start = absl::Now();
+    if (!Compile(ctx.sql, ctx.db, session, false, &optimized, status)) {
+        LOG(WARNING) << "fail to recompile sql with the optimizations: " << status.msg;
+        return;
+    }
+    DLOG(INFO) << "recompile sql with the optimizations takes " << absl::Now() - start << ": " << ctx.sql;
+    GetCacheShard(ctx.db, kBatchMode, NormalizeSql(ctx.sql))->recompile_cnt.fetch_add(1, std::memory_order_relaxed);
+    info->SetOptimized(optimized);
+}
+
+bool Engine::Compile(const std::string& sql, const std::string& db, RunSession& session, bool fast_compile,
+                     std::shared_ptr<CompileInfo>* compile_info, base::Status& status) {
     DLOG(INFO) << "Compile Engine ...";
     status = base::Status::OK();
     std::shared_ptr<SqlCompileInfo> info = std::make_shared<SqlCompileInfo>();
@@ -171,6 +477,7 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
+    sql_context.jit_options.SetEnableFastCompile(fast_compile);
     sql_context.options = session.GetOptions();
     sql_context.index_hints = session.index_hints_;
     if (session.engine_mode() == kBatchMode) {
@@ -202,19 +509,7 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
             return false;
         }
     }
-
-    SetCacheLocked(db, sql, session.engine_mode(), info);
-    session.SetCompileInfo(info);
-    if (session.is_debug_) {
-        std::ostringstream plan_oss;
-        if (nullptr != sql_context.physical_plan) {
-            sql_context.physical_plan->Print(plan_oss, "");
-            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
-        }
-        std::ostringstream runner_oss;
-        sql_context.cluster_job->Print(runner_oss, "");
-        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
-    }
+    *compile_info = info;
     return true;
 }
 
@@ -326,27 +621,60 @@ bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode e
 }
 
 void Engine::ClearCacheLocked(const std::string& db) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
-    if (db.empty()) {
-        lru_cache_.clear();
-        return;
-    }
-    for (auto& cache : lru_cache_) {
-        auto& mode_cache = cache.second;
-        mode_cache.erase(db);
+    for (auto& shard : cache_shards_) {
+        std::lock_guard<base::SpinMutex> lock(shard->mu);
+        shard->version++;
+        shard->parameterize_failed.clear();
+        std::lock_guard<base::SpinMutex> budget_lock(cache_budget_mu_);
+        for (auto& cache : shard->lru_cache) {
+            auto& mode_cache = cache.second;
+            for (auto it = mode_cache.begin(); it != mode_cache.end();) {
+                if (!db.empty() && it->first != db) {
+                    ++it;
+                    continue;
+                }
+                auto num_it = cached_sql_num_.find({cache.first, it->first});
+                if (num_it != cached_sql_num_.end()) {
+                    num_it->second -= std::min<uint32_t>(num_it->second, it->second.Size());
+                    if (num_it->second == 0) {
+                        cached_sql_num_.erase(num_it);
+                    }
+                }
+                it = mode_cache.erase(it);
+            }
+        }
     }
 }
 
+EngineCacheStat Engine::GetCacheStat() const {
+    EngineCacheStat stat;
+    for (const auto& shard : cache_shards_) {
+        stat.hit += shard->hit.load(std::memory_order_relaxed);
+        stat.miss += shard->miss.load(std::memory_order_relaxed);
+        stat.shared += shard->shared.load(std::memory_order_relaxed);
+        stat.compile_cnt += shard->compile_cnt.load(std::memory_order_relaxed);
+        stat.compile_time_us += shard->compile_time_us.load(std::memory_order_relaxed);
+        stat.recompile_cnt += shard->recompile_cnt.load(std::memory_order_relaxed);
+    }
+    return stat;
+}
+
 EngineOptions Engine::GetEngineOptions() {
     return options_;
 }
 
-std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const std::string& sql,
-                                                    EngineMode engine_mode) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
+EngineCacheShard* Engine::GetCacheShard(const std::string& db, EngineMode engine_mode, const std::string& sql) {
+    size_t hash = std::hash<std::string>()(db);
+    hash = hash * 31 + static_cast<size_t>(engine_mode);
+    hash = hash * 31 + std::hash<std::string>()(sql);
+    return cache_shards_[hash % cache_shards_.size()].get();
+}
+
+std::shared_ptr<CompileInfo> Engine::GetCache(EngineCacheShard* shard, const std::string& db, const std::string& sql,
+                                              EngineMode engine_mode) {
     // Check mode
-    auto mode_iter = lru_cache_.find(engine_mode);
-    if (mode_iter == lru_cache_.end()) {
+    auto mode_iter = shard->lru_cache.find(engine_mode);
+    if (mode_iter == shard->lru_cache.end()) {
         return nullptr;
     }
     auto& mode_cache = mode_iter->second;
@@ -355,37 +683,34 @@ std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const
     if (db_iter == mode_cache.end()) {
         return nullptr;
     }
-    auto& lru = db_iter->second;
-
     // Check SQL
-    auto value = lru.get(sql);
-    if (value == boost::none) {
-        return nullptr;
-    } else {
-        return value.value();
-    }
+    return db_iter->second.Get(sql);
 }
 
-bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
-                            std::shared_ptr<CompileInfo> info) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
-
-    auto& mode_cache = lru_cache_[engine_mode];
-    using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>;
-    std::map<std::string, BoostLRU>::iterator db_iter = mode_cache.find(db);
-    if (db_iter == mode_cache.end()) {
-        db_iter = mode_cache.insert(db_iter, {db, BoostLRU(options_.GetMaxSqlCacheSize())});
-    }
-    auto& lru = db_iter->second;
-    auto value = lru.get(sql);
-    if (value == boost::none || engine_mode == kBatchRequestMode) {
-        lru.insert(sql, info);
-        return true;
-    } else {
+bool Engine::SetCache(EngineCacheShard* shard, const std::string& db, const std::string& sql, EngineMode engine_mode,
+                      std::shared_ptr<CompileInfo> info) {
+    auto& lru = shard->lru_cache[engine_mode][db];
+    if (lru.Contains(sql)) {
+        if (engine_mode == kBatchRequestMode) {
+            return true;
+        }
         // TODO(xxx): Ensure compile result is stable
         DLOG(INFO) << "Engine cache already exists: " << engine_mode << " " << db << "\n" << sql;
         return false;
     }
+    {
+        std::lock_guard<base::SpinMutex> lock(cache_budget_mu_);
+        auto& sql_num = cached_sql_num_[{engine_mode, db}];
+        // only the sqls of this shard are evicted, so the lock of another shard is not required. a shard holds one sql
+        // at least, the total may exceed max_sql_cache_size by the number of the shards minus one
+        if (sql_num >= options_.GetMaxSqlCacheSize() && !lru.Empty()) {
+            lru.EvictOldest();
+        } else {
+            sql_num++;
+        }
+    }
+    lru.Insert(sql, std::move(info));
+    return true;
 }
 
 RunSession::RunSession(EngineMode engine_mode) : engine_mode_(engine_mode), is_debug_(false), sp_name_("") {}
@@ -540,7 +865,8 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
 }
 int32_t BatchRunSession::Run(const Row& parameter_row, std::vector<Row>& rows, uint64_t limit) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)->get_sql_context();
-    RunnerContext ctx(sql_ctx.cluster_job, parameter_row, is_debug_);
+    RunnerContext ctx(sql_ctx.cluster_job, literal_parameter_row_.empty() ? parameter_row : literal_parameter_row_,
+                      is_debug_);
     auto output = sql_ctx.cluster_job->GetTask(0).GetRoot()->RunWithCache(ctx);
     if (!output) {
         DLOG(INFO) << "Run batch plan output is empty";
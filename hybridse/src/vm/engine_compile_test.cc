@@ -14,12 +14,16 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
 #include "absl/strings/str_join.h"
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "testing/engine_test_base.h"
 #include "udf/openmldb_udf.h"
+#include "vm/sql_compiler.h"
 
 using namespace llvm;       // NOLINT (build/namespaces)
 using namespace llvm::orc;  // NOLINT (build/namespaces)
@@ -84,6 +88,203 @@ TEST_F(EngineCompileTest, EngineLRUCacheTest) {
     }
 }
 
+TEST_F(EngineCompileTest, EngineShardedLRUCacheTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    // the sqls are spread over the shards, the shards hold max_sql_cache_size sqls in total, and one more sql at most
+    // for each of the other 15 shards
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    options.SetMaxSqlCacheSize(20);
+    Engine engine(catalog, options);
+    const int sql_num = 40;
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < sql_num; i++) {
+            base::Status get_status;
+            BatchRunSession session;
+            std::string sql = "select col1, col2 + " + std::to_string(i) + " from t1;";
+            ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        }
+    }
+    auto stat = engine.GetCacheStat();
+    ASSERT_EQ(static_cast<uint64_t>(sql_num * 2), stat.hit + stat.miss);
+    ASSERT_LE(stat.hit, 20u + 15u);
+}
+
+TEST_F(EngineCompileTest, EngineShardedLRUCacheHotSqlTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    // the hot sqls fit in max_sql_cache_size are all cached, whichever shards they are in
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    options.SetMaxSqlCacheSize(20);
+    Engine engine(catalog, options);
+    const int sql_num = 20;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < sql_num; i++) {
+            base::Status get_status;
+            BatchRunSession session;
+            std::string sql = "select col1, col2 + " + std::to_string(i) + " from t1;";
+            ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        }
+    }
+    auto stat = engine.GetCacheStat();
+    ASSERT_EQ(static_cast<uint64_t>(sql_num), stat.miss);
+    ASSERT_EQ(static_cast<uint64_t>(sql_num * 2), stat.hit);
+}
+
+TEST_F(EngineCompileTest, EngineCacheSingleFlightTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    std::string sql = "select col1, col2 from t1;";
+    const int thread_num = 8;
+    std::vector<std::shared_ptr<CompileInfo>> infos(thread_num);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&engine, &sql, &infos, i]() {
+            base::Status get_status;
+            BatchRunSession session;
+            ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+            infos[i] = session.GetCompileInfo();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 1; i < thread_num; i++) {
+        ASSERT_EQ(infos[0].get(), infos[i].get());
+    }
+    // the concurrent gets share one compilation
+    auto stat = engine.GetCacheStat();
+    ASSERT_EQ(1u, stat.compile_cnt);
+    ASSERT_EQ(1u, stat.miss);
+    ASSERT_EQ(static_cast<uint64_t>(thread_num - 1), stat.hit + stat.shared);
+
+    // the leading and trailing whitespaces don't change the cache key
+    base::Status get_status;
+    BatchRunSession session;
+    ASSERT_TRUE(engine.Get("  " + sql + "\n", "simple_db", session, get_status)) << get_status;
+    ASSERT_EQ(infos[0].get(), session.GetCompileInfo().get());
+    ASSERT_EQ(1u, engine.GetCacheStat().compile_cnt);
+
+    engine.ClearCacheLocked("");
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+    ASSERT_NE(infos[0].get(), session.GetCompileInfo().get());
+    ASSERT_EQ(2u, engine.GetCacheStat().compile_cnt);
+}
+
+TEST_F(EngineCompileTest, EngineParameterizeLiteralTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    options.SetEnableParameterizeLiteral(true);
+    Engine engine(catalog, options);
+
+    base::Status get_status;
+    BatchRunSession session1;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 = 10 and col0 = 'a';", "simple_db", session1,
+                           get_status))
+        << get_status;
+    ASSERT_EQ(2, session1.GetParameterSchema().size());
+    ASSERT_EQ(hybridse::type::kInt32, session1.GetParameterSchema().Get(0).type());
+    ASSERT_EQ(hybridse::type::kVarchar, session1.GetParameterSchema().Get(1).type());
+
+    // the sql different only in the literals reuses the compiling result
+    BatchRunSession session2;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 = 20 and col0 = 'bb';", "simple_db", session2,
+                           get_status))
+        << get_status;
+    ASSERT_EQ(session1.GetCompileInfo().get(), session2.GetCompileInfo().get());
+    ASSERT_EQ(1u, engine.GetCacheStat().compile_cnt);
+
+    // the sql with the parameters is not rewritten
+    codec::Schema parameter_schema;
+    parameter_schema.Add()->set_type(hybridse::type::kInt32);
+    BatchRunSession session3;
+    session3.SetParameterSchema(parameter_schema);
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1 where col1 = ?;", "simple_db", session3, get_status))
+        << get_status;
+    ASSERT_EQ(1, session3.GetParameterSchema().size());
+    ASSERT_EQ(2u, engine.GetCacheStat().compile_cnt);
+}
+
+TEST_F(EngineCompileTest, EngineTieredCompileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    options.SetTieredCompileThreshold(2);
+    Engine engine(catalog, options);
+    auto is_fast_compiled = [](const std::shared_ptr<CompileInfo>& info) {
+        return std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context().jit_options.IsEnableFastCompile();
+    };
+
+    std::string sql = "select col1, col2 + 1 from t1 where col1 > 10;";
+    base::Status get_status;
+    BatchRunSession session1;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session1, get_status)) << get_status;
+    ASSERT_TRUE(is_fast_compiled(session1.GetCompileInfo()));
+    // the sql is recompiled in the background after it's got from the cache twice
+    for (int i = 0; i < 2; i++) {
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        ASSERT_EQ(session1.GetCompileInfo().get(), session.GetCompileInfo().get());
+    }
+    for (int i = 0; i < 100 && engine.GetCacheStat().recompile_cnt == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_EQ(1u, engine.GetCacheStat().recompile_cnt);
+    BatchRunSession session2;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session2, get_status)) << get_status;
+    ASSERT_NE(session1.GetCompileInfo().get(), session2.GetCompileInfo().get());
+    ASSERT_FALSE(is_fast_compiled(session2.GetCompileInfo()));
+    ASSERT_EQ(1u, engine.GetCacheStat().compile_cnt);
+
+    // the request mode sql is compiled with the optimizations at first
+    RequestRunSession request_session;
+    ASSERT_TRUE(engine.Get("select col1, col2 from t1;", "simple_db", request_session, get_status)) << get_status;
+    ASSERT_FALSE(is_fast_compiled(request_session.GetCompileInfo()));
+}
 
 TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
     // Build Simple Catalog
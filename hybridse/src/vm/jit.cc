@@ -33,6 +33,7 @@ extern "C" {
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/ExecutionEngine/Orc/IRTransformLayer.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/DataLayout.h"
@@ -190,6 +191,32 @@ bool HybridSeLlvmJitWrapper::Init() {
         //         return ObjLinkingLayer;
         //     });
     }
+    if (jit_options_.IsEnableFastCompile()) {
+        auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!jtmb) {
+            LOG(WARNING) << "fail to detect host for jit: " << LlvmToString(jtmb.takeError());
+            return false;
+        }
+        jtmb->setCodeGenOptLevel(::llvm::CodeGenOpt::None);
+        builder.setJITTargetMachineBuilder(std::move(*jtmb));
+    }
+    if (!jit_options_.GetObjectCacheDir().empty()) {
+        object_cache_ = std::make_unique<JitObjectCache>(
+            jit_options_.GetObjectCacheDir(), jit_options_.GetObjectCacheMaxSize(),
+            jit_options_.IsEnableFastCompile() ? ::llvm::CodeGenOpt::None : ::llvm::CodeGenOpt::Default);
+        auto cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                ::llvm::orc::TMOwningSimpleCompiler compiler(std::move(*tm));
+                compiler.setObjectCache(cache);
+                return ::llvm::orc::IRCompileLayer::CompileFunction(std::move(compiler));
+            });
+    }
     auto jit = builder.create();
     {
         ::llvm::Error e = jit.takeError();
@@ -218,6 +245,10 @@ bool HybridSeLlvmJitWrapper::Init() {
 
 bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
     EnsureInitialized();
+    if (jit_options_.IsEnableFastCompile()) {
+        // the data layout is applied when the module is added
+        return true;
+    }
     return jit_->OptModule(module);
 }
 
@@ -267,6 +298,9 @@ bool HybridSeMcJitWrapper::Init() {
 
 bool HybridSeMcJitWrapper::OptModule(::llvm::Module* module) {
     EnsureInitialized();
+    if (jit_options_.IsEnableFastCompile()) {
+        return true;
+    }
 
     DLOG(INFO) << "Module before opt:\n" << LlvmToString(*module);
     RunDefaultOptPasses(module);
@@ -298,7 +332,8 @@ bool HybridSeMcJitWrapper::AddModule(
             engine_builder.setEngineKind(llvm::EngineKind::JIT)
                 .setErrorStr(&err_str_)
                 .setVerifyModules(true)
-                .setOptLevel(::llvm::CodeGenOpt::Level::Default)
+                .setOptLevel(jit_options_.IsEnableFastCompile() ? ::llvm::CodeGenOpt::Level::None
+                                                                 : ::llvm::CodeGenOpt::Level::Default)
                 .setSymbolResolver(
                     std::unique_ptr<::llvm::LegacyJITSymbolResolver>(
                         ::llvm::cast<::llvm::LegacyJITSymbolResolver>(
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -100,6 +101,8 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
 
  private:
     const JitOptions jit_options_;
+    // nullptr if the object code is not cached, it's used by jit_ so it's released after jit_
+    std::unique_ptr<JitObjectCache> object_cache_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "glog/logging.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+JitObjectCache::JitObjectCache(const std::string& dir, uint64_t max_size, ::llvm::CodeGenOpt::Level opt_level)
+    : dir_(dir), max_size_(max_size) {
+    // the cpus with the same name may have different features, e.g. in the vms, the object code must not use the
+    // instructions not supported by the host
+    std::vector<std::string> features;
+    ::llvm::StringMap<bool> host_features;
+    if (::llvm::sys::getHostCPUFeatures(host_features)) {
+        for (const auto& feature : host_features) {
+            features.push_back((feature.second ? "+" : "-") + feature.first().str());
+        }
+        std::sort(features.begin(), features.end());
+    }
+    target_ = absl::StrCat(LLVM_VERSION_STRING, ";", ::llvm::sys::getProcessTriple(), ";",
+                           ::llvm::sys::getHostCPUName().str(), ";", absl::StrJoin(features, ","), ";O",
+                           static_cast<int>(opt_level));
+    auto ec = ::llvm::sys::fs::create_directories(dir_);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir_ << ": " << ec.message();
+        return;
+    }
+    dir_ready_ = true;
+}
+
+std::string JitObjectCache::GetKey(const ::llvm::Module& module) const {
+    std::string ir;
+    ::llvm::raw_string_ostream os(ir);
+    module.print(os, nullptr);
+    os.flush();
+    ::llvm::MD5 md5;
+    md5.update(target_);
+    md5.update(ir);
+    ::llvm::MD5::MD5Result result;
+    md5.final(result);
+    ::llvm::SmallString<32> key;
+    ::llvm::MD5::stringifyResult(result, key);
+    return key.str().str();
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(const ::llvm::Module* module) {
+    if (!dir_ready_) {
+        return nullptr;
+    }
+    std::string key = GetKey(*module);
+    std::string path = GetPath(key);
+    std::unique_ptr<::llvm::MemoryBuffer> obj;
+    int fd = -1;
+    if (!::llvm::sys::fs::openFileForRead(path, fd)) {
+        auto buf = ::llvm::MemoryBuffer::getOpenFile(fd, path, -1, false);
+        // the file loaded recently is removed later than the others
+        ::llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+        ::llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+        if (buf) {
+            obj = std::move(buf.get());
+        }
+    }
+    if (!obj) {
+        DLOG(INFO) << "jit object cache miss " << path;
+        std::lock_guard<std::mutex> lock(mu_);
+        keys_[module] = key;
+        return nullptr;
+    }
+    DLOG(INFO) << "load object from jit object cache " << path;
+    return obj;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* module, ::llvm::MemoryBufferRef obj) {
+    if (!dir_ready_) {
+        return;
+    }
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = keys_.find(module);
+        if (it != keys_.end()) {
+            key = std::move(it->second);
+            keys_.erase(it);
+        }
+    }
+    if (key.empty()) {
+        key = GetKey(*module);
+    }
+    std::string path = GetPath(key);
+    // write to a temporary file and rename it, so the readers never see a partial object
+    int fd = -1;
+    ::llvm::SmallString<128> tmp_path;
+    auto ec = ::llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd, tmp_path);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache file for " << path << ": " << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os.write(obj.getBufferStart(), obj.getBufferSize());
+        os.close();
+        if (os.has_error()) {
+            LOG(WARNING) << "fail to write jit object cache file " << tmp_path.str().str();
+            os.clear_error();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    ec = ::llvm::sys::fs::rename(tmp_path, path);
+    if (ec) {
+        LOG(WARNING) << "fail to rename jit object cache file to " << path << ": " << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    DLOG(INFO) << "save object to jit object cache " << path;
+    if (max_size_ > 0) {
+        RemoveOldFiles(path);
+    }
+}
+
+void JitObjectCache::RemoveOldFiles(const std::string& keep_path) {
+    struct ObjectFile {
+        ::llvm::sys::TimePoint<> mtime;
+        uint64_t size;
+        std::string path;
+    };
+    std::vector<ObjectFile> files;
+    uint64_t total_size = 0;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string& path = it->path();
+        // the temporary files are being written by the others
+        if (::llvm::sys::path::extension(path) != ".o") {
+            continue;
+        }
+        auto status = it->status();
+        if (!status) {
+            continue;
+        }
+        total_size += status->getSize();
+        if (path != keep_path) {
+            files.push_back({status->getLastModificationTime(), status->getSize(), path});
+        }
+    }
+    if (total_size <= max_size_) {
+        return;
+    }
+    std::sort(files.begin(), files.end(),
+              [](const ObjectFile& a, const ObjectFile& b) { return a.mtime < b.mtime; });
+    for (const auto& file : files) {
+        if (total_size <= max_size_) {
+            break;
+        }
+        // the file removed by another tablet sharing the dir is counted as removed too
+        ::llvm::sys::fs::remove(file.path);
+        total_size -= file.size;
+        DLOG(INFO) << "remove old object from jit object cache " << file.path;
+    }
+}
+
+}  // namespace vm
+}  // namespace hybridse
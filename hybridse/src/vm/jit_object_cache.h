@@ -0,0 +1,73 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace hybridse {
+namespace vm {
+
+// JitObjectCache keeps the object code of the compiled modules in a directory, so the same module compiled again,
+// e.g. a deployment compiled after the restart or by another tablet sharing the directory, is loaded from the file
+// instead of running the codegen of llvm. The file is named by the hash of the module ir, the llvm version, the host
+// cpu with its features and the codegen optimization level, the external symbols are resolved by name when the object
+// is linked.
+//
+// The modification time of a file is refreshed when it's loaded, and the least recently used files are removed once
+// the total size of the files exceeds max_size after an object is saved
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    // max_size is in bytes, 0 means no limit. opt_level is the codegen optimization level of the jit
+    JitObjectCache(const std::string& dir, uint64_t max_size, ::llvm::CodeGenOpt::Level opt_level);
+    ~JitObjectCache() override {}
+
+    void notifyObjectCompiled(const ::llvm::Module* module, ::llvm::MemoryBufferRef obj) override;
+    // nullptr if the module is not compiled before
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(const ::llvm::Module* module) override;
+
+    std::string GetKey(const ::llvm::Module& module) const;
+
+ private:
+    std::string GetPath(const std::string& key) const { return dir_ + "/" + key + ".o"; }
+    // remove the least recently used files until the total size is not more than max_size_, except the file kept
+    void RemoveOldFiles(const std::string& keep_path);
+
+    const std::string dir_;
+    const uint64_t max_size_;
+    // the target the object code is generated for, it's a part of the key
+    std::string target_;
+    bool dir_ready_ = false;
+    std::mutex mu_;
+    // the key computed in getObject is reused in notifyObjectCompiled of the same module, it's only kept if the
+    // object is not found, notifyObjectCompiled is not called if getObject returns the object
+    std::map<const ::llvm::Module*, std::string> keys_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
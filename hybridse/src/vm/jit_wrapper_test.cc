@@ -17,6 +17,7 @@
 #include "vm/jit_wrapper.h"
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
 #include "vm/simple_catalog.h"
@@ -117,6 +118,94 @@ TEST_F(JitWrapperTest, test) {
     simple_test(options);
 }
 
+TEST_F(JitWrapperTest, test_object_cache) {
+    char dir_template[] = "/tmp/jit_object_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir_template) != nullptr);
+    std::string dir = dir_template;
+    auto count_files = [&dir]() {
+        uint32_t cnt = 0;
+        std::error_code ec;
+        for (llvm::sys::fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            cnt++;
+        }
+        return cnt;
+    };
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info = Compile("select col_1, col_2 from t1;", options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto &sql_context = compile_info->get_sql_context();
+    std::string ir_str = sql_context.ir;
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+
+    JitOptions jit_options;
+    jit_options.SetObjectCacheDir(dir);
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    // the first jit saves the object code and the second one loads it
+    for (int i = 0; i < 2; i++) {
+        std::unique_ptr<HybridSeJitWrapper> jit(HybridSeJitWrapper::Create(jit_options));
+        ASSERT_TRUE(jit->Init());
+        base::RawBuffer ir_buf(const_cast<char *>(ir_str.data()), ir_str.size());
+        ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+        auto fn = jit->FindFunction(fn_name);
+        ASSERT_TRUE(fn != nullptr);
+        ASSERT_EQ(1u, count_files());
+
+        hybridse::codec::Row output = CoreAPI::RowProject(fn, row, empty_parameter);
+        codec::RowView row_view(*schema, output.buf(), output.size());
+        double c1;
+        int64_t c2;
+        ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+        ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+        ASSERT_EQ(c1, 3.14);
+        ASSERT_EQ(c2, 42);
+    }
+    llvm::sys::fs::remove_directories(dir);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_max_size) {
+    char dir_template[] = "/tmp/jit_object_cache_XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir_template) != nullptr);
+    std::string dir = dir_template;
+    auto count_files = [&dir]() {
+        uint32_t cnt = 0;
+        std::error_code ec;
+        for (llvm::sys::fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            cnt++;
+        }
+        return cnt;
+    };
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    JitOptions jit_options;
+    jit_options.SetObjectCacheDir(dir);
+    // only the object saved last is kept
+    jit_options.SetObjectCacheMaxSize(1);
+    for (const auto &sql : {"select col_1, col_2 from t1;", "select col_2 from t1;", "select col_1, col_2 from t1;"}) {
+        auto compile_info = Compile(sql, options, catalog);
+        ASSERT_TRUE(compile_info != nullptr);
+        auto &sql_context = compile_info->get_sql_context();
+        std::string ir_str = sql_context.ir;
+        auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+        std::unique_ptr<HybridSeJitWrapper> jit(HybridSeJitWrapper::Create(jit_options));
+        ASSERT_TRUE(jit->Init());
+        base::RawBuffer ir_buf(const_cast<char *>(ir_str.data()), ir_str.size());
+        ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+        ASSERT_TRUE(jit->FindFunction(fn_name) != nullptr);
+        ASSERT_EQ(1u, count_files());
+    }
+    llvm::sys::fs::remove_directories(dir);
+}
+
 #ifdef LLVM_EXT_ENABLE
 TEST_F(JitWrapperTest, test_mcjit) {
     EngineOptions options;
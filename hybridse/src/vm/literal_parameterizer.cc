@@ -0,0 +1,350 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/literal_parameterizer.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+
+namespace hybridse {
+namespace vm {
+
+namespace {
+
+enum class TokenType { kWord, kNumber, kString, kSymbol };
+
+struct Token {
+    TokenType type;
+    size_t begin;
+    size_t end;
+    // the quoted identifier is never a keyword
+    bool quoted = false;
+    // the number with a suffix, e.g. 1L, 1.0f, 0x1F, or the string with escapes, they are never rewritten
+    bool unsupported = false;
+};
+
+struct Literal {
+    type::Type type;
+    int64_t int_value = 0;
+    double double_value = 0.0;
+    std::string str_value;
+};
+
+bool IsWordChar(char c) { return absl::ascii_isalnum(c) || c == '_'; }
+
+// split the sql into tokens, return false if the sql has the parameters or the tokens not recognized
+bool Tokenize(const std::string& sql, std::vector<Token>* tokens) {
+    size_t i = 0;
+    const size_t n = sql.size();
+    while (i < n) {
+        char c = sql[i];
+        if (absl::ascii_isspace(c)) {
+            i++;
+        } else if (c == '#' || (c == '-' && i + 1 < n && sql[i + 1] == '-')) {
+            while (i < n && sql[i] != '\n') {
+                i++;
+            }
+        } else if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+            size_t end = sql.find("*/", i + 2);
+            if (end == std::string::npos) {
+                return false;
+            }
+            i = end + 2;
+        } else if (c == '\'' || c == '"') {
+            if (i + 2 < n && sql[i + 1] == c && sql[i + 2] == c) {
+                // triple quoted string
+                return false;
+            }
+            Token token{TokenType::kString, i, 0};
+            i++;
+            while (i < n && sql[i] != c) {
+                if (sql[i] == '\\') {
+                    token.unsupported = true;
+                    i++;
+                }
+                i++;
+            }
+            if (i >= n) {
+                return false;
+            }
+            token.end = ++i;
+            tokens->push_back(token);
+        } else if (c == '`') {
+            size_t end = sql.find('`', i + 1);
+            if (end == std::string::npos) {
+                return false;
+            }
+            Token token{TokenType::kWord, i, end + 1};
+            token.quoted = true;
+            tokens->push_back(token);
+            i = end + 1;
+        } else if (absl::ascii_isdigit(c) || (c == '.' && i + 1 < n && absl::ascii_isdigit(sql[i + 1]))) {
+            Token token{TokenType::kNumber, i, 0};
+            while (i < n && absl::ascii_isdigit(sql[i])) {
+                i++;
+            }
+            if (i < n && sql[i] == '.') {
+                i++;
+                while (i < n && absl::ascii_isdigit(sql[i])) {
+                    i++;
+                }
+            }
+            if (i + 1 < n && (sql[i] == 'e' || sql[i] == 'E') &&
+                (absl::ascii_isdigit(sql[i + 1]) ||
+                 ((sql[i + 1] == '+' || sql[i + 1] == '-') && i + 2 < n && absl::ascii_isdigit(sql[i + 2])))) {
+                i += 2;
+                while (i < n && absl::ascii_isdigit(sql[i])) {
+                    i++;
+                }
+            }
+            while (i < n && IsWordChar(sql[i])) {
+                token.unsupported = true;
+                i++;
+            }
+            token.end = i;
+            tokens->push_back(token);
+        } else if (IsWordChar(c)) {
+            Token token{TokenType::kWord, i, 0};
+            while (i < n && IsWordChar(sql[i])) {
+                i++;
+            }
+            token.end = i;
+            tokens->push_back(token);
+        } else if (c == '?' || c == '@') {
+            return false;
+        } else {
+            Token token{TokenType::kSymbol, i, i + 1};
+            if (i + 1 < n) {
+                std::string two = sql.substr(i, 2);
+                if (two == "==" || two == "!=" || two == "<>" || two == "<=" || two == ">=") {
+                    token.end = i + 2;
+                }
+            }
+            i = token.end;
+            tokens->push_back(token);
+        }
+    }
+    return true;
+}
+
+class LiteralRewriter {
+ public:
+    LiteralRewriter(const std::string& sql, const std::vector<Token>& tokens) : sql_(sql), tokens_(tokens) {}
+
+    bool Rewrite(std::string* parameterized_sql, std::vector<Literal>* literals) {
+        if (tokens_.empty() || !(IsKeyword(0, "select") || IsKeyword(0, "with") || IsSymbol(0, "("))) {
+            return false;
+        }
+        // whether the tokens are in a where clause, one for each level of the parentheses
+        std::vector<bool> in_where = {false};
+        size_t copied = 0;
+        for (size_t i = 0; i < tokens_.size(); i++) {
+            if (IsSymbol(i, "(")) {
+                in_where.push_back(in_where.back());
+            } else if (IsSymbol(i, ")")) {
+                if (in_where.size() <= 1) {
+                    return false;
+                }
+                in_where.pop_back();
+            } else if (IsKeyword(i, "select")) {
+                in_where.back() = false;
+            } else if (IsKeyword(i, "where")) {
+                in_where.back() = true;
+            } else if (IsClauseEnd(i)) {
+                in_where.back() = false;
+            } else if (in_where.back() && (tokens_[i].type == TokenType::kNumber ||
+                                           tokens_[i].type == TokenType::kString)) {
+                size_t begin = 0;
+                Literal literal;
+                if (IsComparedWithColumn(i, &begin) && ParseLiteral(begin, i, &literal)) {
+                    parameterized_sql->append(sql_, copied, tokens_[begin].begin - copied);
+                    parameterized_sql->append("?");
+                    copied = tokens_[i].end;
+                    literals->push_back(literal);
+                }
+            }
+        }
+        if (literals->empty()) {
+            return false;
+        }
+        parameterized_sql->append(sql_, copied, std::string::npos);
+        return true;
+    }
+
+ private:
+    std::string Text(size_t i) const { return sql_.substr(tokens_[i].begin, tokens_[i].end - tokens_[i].begin); }
+
+    bool IsKeyword(size_t i, const char* keyword) const {
+        return tokens_[i].type == TokenType::kWord && !tokens_[i].quoted &&
+               absl::EqualsIgnoreCase(Text(i), keyword);
+    }
+
+    bool IsSymbol(size_t i, const char* symbol) const {
+        return tokens_[i].type == TokenType::kSymbol && Text(i) == symbol;
+    }
+
+    bool IsClauseEnd(size_t i) const {
+        static const std::set<std::string> keywords = {"group",  "having",    "order",  "limit",   "window", "union",
+                                                       "except", "intersect", "config", "options", "into",   "qualify"};
+        return tokens_[i].type == TokenType::kWord && !tokens_[i].quoted &&
+               keywords.count(absl::AsciiStrToLower(Text(i))) > 0;
+    }
+
+    bool IsComparison(size_t i) const {
+        if (tokens_[i].type != TokenType::kSymbol) {
+            return false;
+        }
+        std::string op = Text(i);
+        return op == "=" || op == "==" || op == "!=" || op == "<>" || op == "<" || op == "<=" || op == ">" ||
+               op == ">=";
+    }
+
+    // `column op literal` and the literal is the whole right operand, begin is the first token of the literal
+    bool IsComparedWithColumn(size_t i, size_t* begin) const {
+        if (tokens_[i].unsupported) {
+            return false;
+        }
+        *begin = i;
+        if (i >= 1 && tokens_[i].type == TokenType::kNumber && IsSymbol(i - 1, "-")) {
+            *begin = i - 1;
+        }
+        if (*begin < 2 || !IsComparison(*begin - 1)) {
+            return false;
+        }
+        size_t column = *begin - 2;
+        if (tokens_[column].type != TokenType::kWord || IsKeyword(column, "null") || IsKeyword(column, "true") ||
+            IsKeyword(column, "false")) {
+            return false;
+        }
+        if (i + 1 == tokens_.size()) {
+            return true;
+        }
+        return IsSymbol(i + 1, ")") || IsSymbol(i + 1, ";") || IsKeyword(i + 1, "and") || IsKeyword(i + 1, "or") ||
+               IsClauseEnd(i + 1);
+    }
+
+    // the types are the same as the ones of the literals in the plan
+    bool ParseLiteral(size_t begin, size_t i, Literal* literal) const {
+        std::string text = Text(i);
+        if (tokens_[i].type == TokenType::kString) {
+            literal->type = type::kVarchar;
+            literal->str_value = text.substr(1, text.size() - 2);
+            return true;
+        }
+        bool negative = begin != i;
+        errno = 0;
+        if (text.find_first_of(".eE") == std::string::npos) {
+            char* end = nullptr;
+            int64_t value = std::strtoll(text.c_str(), &end, 10);
+            if (errno != 0 || *end != '\0') {
+                return false;
+            }
+            value = negative ? -value : value;
+            literal->type = (value <= INT32_MAX && value >= INT32_MIN) ? type::kInt32 : type::kInt64;
+            literal->int_value = value;
+            return true;
+        }
+        char* end = nullptr;
+        double value = std::strtod(text.c_str(), &end);
+        if (errno != 0 || *end != '\0') {
+            return false;
+        }
+        literal->type = type::kDouble;
+        literal->double_value = negative ? -value : value;
+        return true;
+    }
+
+    const std::string& sql_;
+    const std::vector<Token>& tokens_;
+};
+
+bool BuildParameterRow(const std::vector<Literal>& literals, codec::Schema* schema, codec::Row* row) {
+    uint32_t str_size = 0;
+    for (size_t i = 0; i < literals.size(); i++) {
+        auto column = schema->Add();
+        column->set_name("literal_" + std::to_string(i));
+        column->set_type(literals[i].type);
+        if (literals[i].type == type::kVarchar) {
+            str_size += literals[i].str_value.size();
+        }
+    }
+    codec::RowBuilder builder(*schema);
+    uint32_t size = builder.CalTotalLength(str_size);
+    int8_t* buf = static_cast<int8_t*>(malloc(size));
+    // the row owns the buffer from now on
+    *row = codec::Row(base::RefCountedSlice::CreateManaged(buf, size));
+    if (!builder.SetBuffer(buf, size)) {
+        return false;
+    }
+    for (const auto& literal : literals) {
+        bool ok = false;
+        switch (literal.type) {
+            case type::kInt32:
+                ok = builder.AppendInt32(static_cast<int32_t>(literal.int_value));
+                break;
+            case type::kInt64:
+                ok = builder.AppendInt64(literal.int_value);
+                break;
+            case type::kDouble:
+                ok = builder.AppendDouble(literal.double_value);
+                break;
+            case type::kVarchar:
+                ok = builder.AppendString(literal.str_value.c_str(), literal.str_value.size());
+                break;
+            default:
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool ParameterizeLiterals(const std::string& sql, std::string* parameterized_sql, codec::Schema* parameter_schema,
+                          codec::Row* parameter_row) {
+    std::vector<Token> tokens;
+    if (!Tokenize(sql, &tokens)) {
+        return false;
+    }
+    std::string rewritten;
+    std::vector<Literal> literals;
+    LiteralRewriter rewriter(sql, tokens);
+    if (!rewriter.Rewrite(&rewritten, &literals)) {
+        return false;
+    }
+    codec::Schema schema;
+    codec::Row row;
+    if (!BuildParameterRow(literals, &schema, &row)) {
+        return false;
+    }
+    *parameterized_sql = std::move(rewritten);
+    *parameter_schema = std::move(schema);
+    *parameter_row = row;
+    return true;
+}
+
+}  // namespace vm
+}  // namespace hybridse
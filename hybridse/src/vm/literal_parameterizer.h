@@ -0,0 +1,39 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_LITERAL_PARAMETERIZER_H_
+#define HYBRIDSE_SRC_VM_LITERAL_PARAMETERIZER_H_
+
+#include <string>
+
+#include "codec/fe_row_codec.h"
+
+namespace hybridse {
+namespace vm {
+
+// Rewrite the literals compared with a column in the where clauses of a select, e.g. `where id = 123`, into the
+// parameters, so the queries different only in these literals share one compiled plan. The literals are returned as
+// the parameter schema and the parameter row.
+//
+// Only the integer, float and string literals in `column op literal` are rewritten, op is one of = == != <> < <= >
+// >=. The other literals, e.g. the ones in the select list, limit, window frames and options, change the plan and
+// are kept. Return false if nothing is rewritten or the sql has the parameters already
+bool ParameterizeLiterals(const std::string& sql, std::string* parameterized_sql, codec::Schema* parameter_schema,
+                          codec::Row* parameter_row);
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_LITERAL_PARAMETERIZER_H_
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/literal_parameterizer.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace vm {
+
+class LiteralParameterizerTest : public ::testing::Test {};
+
+TEST_F(LiteralParameterizerTest, RewriteWhereLiterals) {
+    std::string sql =
+        "select col1, col2 + 1 from t1 where col1 = 123 and col2 > -2.5 or t1.col3 != 'abc' and col4 <= 3000000000 "
+        "limit 10;";
+    std::string parameterized_sql;
+    codec::Schema schema;
+    codec::Row row;
+    ASSERT_TRUE(ParameterizeLiterals(sql, &parameterized_sql, &schema, &row));
+    ASSERT_EQ("select col1, col2 + 1 from t1 where col1 = ? and col2 > ? or t1.col3 != ? and col4 <= ? limit 10;",
+              parameterized_sql);
+    ASSERT_EQ(4, schema.size());
+    ASSERT_EQ(type::kInt32, schema.Get(0).type());
+    ASSERT_EQ(type::kDouble, schema.Get(1).type());
+    ASSERT_EQ(type::kVarchar, schema.Get(2).type());
+    ASSERT_EQ(type::kInt64, schema.Get(3).type());
+
+    codec::RowView row_view(schema);
+    ASSERT_TRUE(row_view.Reset(row.buf(), row.size()));
+    ASSERT_EQ(123, row_view.GetInt32Unsafe(0));
+    ASSERT_EQ(-2.5, row_view.GetDoubleUnsafe(1));
+    ASSERT_EQ("abc", row_view.GetStringUnsafe(2));
+    ASSERT_EQ(3000000000L, row_view.GetInt64Unsafe(3));
+
+    // the sqls different only in the literals are rewritten into the same sql
+    std::string other_sql;
+    ASSERT_TRUE(ParameterizeLiterals(
+        "select col1, col2 + 1 from t1 where col1 = 1 and col2 > 0.1 or t1.col3 != '' and col4 <= 5 limit 10;",
+        &other_sql, &schema, &row));
+    ASSERT_EQ(parameterized_sql, other_sql);
+}
+
+TEST_F(LiteralParameterizerTest, RewriteSubQuery) {
+    std::string parameterized_sql;
+    codec::Schema schema;
+    codec::Row row;
+    ASSERT_TRUE(ParameterizeLiterals(
+        "select * from (select * from t1 where (col1 = 1 or col1 = 2) and col2 < 5) as t where col3 = 'x' "
+        "group by col1",
+        &parameterized_sql, &schema, &row));
+    ASSERT_EQ(
+        "select * from (select * from t1 where (col1 = ? or col1 = ?) and col2 < ?) as t where col3 = ? group by col1",
+        parameterized_sql);
+    ASSERT_EQ(4, schema.size());
+}
+
+TEST_F(LiteralParameterizerTest, KeepLiterals) {
+    std::string parameterized_sql;
+    codec::Schema schema;
+    codec::Row row;
+    // the literals not in the where clause
+    ASSERT_FALSE(ParameterizeLiterals("select col1 = 1, 'a' from t1 limit 10", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals(
+        "select sum(col1) over w from t1 window w as (partition by col2 order by col3 rows between 3 preceding and "
+        "current row)",
+        &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 last join t2 order by t2.col3 on t1.col1 = 1",
+                                      &parameterized_sql, &schema, &row));
+    // the literals not compared with a column directly
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where col1 = 1 + col2", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where col1 in (1, 2)", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(
+        ParameterizeLiterals("select * from t1 where col1 between 1 and 2", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where f(col1) = 1", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(
+        ParameterizeLiterals("select * from t1 where col1 = date '2020-01-01'", &parameterized_sql, &schema, &row));
+    // the literals with suffixes or escapes
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where col1 = 1L", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where col1 = 1.0f", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("select * from t1 where col1 = 'a\\'b'", &parameterized_sql, &schema, &row));
+    // the sqls with parameters or not a query
+    ASSERT_FALSE(
+        ParameterizeLiterals("select * from t1 where col1 = ? and col2 = 1", &parameterized_sql, &schema, &row));
+    ASSERT_FALSE(ParameterizeLiterals("delete from t1 where col1 = 1", &parameterized_sql, &schema, &row));
+    // the literals in comments and quoted identifiers are not tokens
+    ASSERT_TRUE(ParameterizeLiterals("select `where` from t1 -- where col1 = 1\n where `limit` = 'where'",
+                                     &parameterized_sql, &schema, &row));
+    ASSERT_EQ("select `where` from t1 -- where col1 = 1\n where `limit` = ?", parameterized_sql);
+    ASSERT_EQ(1, schema.size());
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::GTEST_FLAG(color) = "yes";
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
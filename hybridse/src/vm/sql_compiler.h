@@ -17,6 +17,7 @@
 #ifndef HYBRIDSE_SRC_VM_SQL_COMPILER_H_
 #define HYBRIDSE_SRC_VM_SQL_COMPILER_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -74,8 +75,17 @@ class SqlCompileInfo : public CompileInfo {
     }
     static SqlCompileInfo* CastFrom(CompileInfo* node) { return dynamic_cast<SqlCompileInfo*>(node); }
 
+    // return the times the result is got from the cache of the engine, including this one
+    uint32_t IncreaseHitCount() { return hit_cnt_.fetch_add(1, std::memory_order_relaxed) + 1; }
+    // the result compiled with the optimizations in the background after the fast compiled one is hot, nullptr if
+    // it's not ready
+    std::shared_ptr<CompileInfo> GetOptimized() const { return std::atomic_load(&optimized_); }
+    void SetOptimized(const std::shared_ptr<CompileInfo>& info) { std::atomic_store(&optimized_, info); }
+
  private:
     hybridse::vm::SqlContext sql_ctx;
+    std::atomic<uint32_t> hit_cnt_{0};
+    std::shared_ptr<CompileInfo> optimized_;
 };
 
 class SqlCompiler {
@@ -84,7 +84,8 @@ class TraverseKvIterator : public KvIterator {
         : KvIterator(response),
           last_pk_(response->pk()),
           ts_pos_(response->ts_pos()),
-          last_ts_(response->ts()) {
+          last_ts_(response->ts()),
+          cursor_id_(response->cursor_id()) {
         buffer_ = reinterpret_cast<char*>(&((*response->mutable_pairs())[0]));
         is_finish_ = response->is_finish();
         tsize_ = response->pairs().size();
@@ -105,6 +106,9 @@ class TraverseKvIterator : public KvIterator {
 
     uint32_t GetTSPos() const { return ts_pos_; }
 
+    // the cursor to continue the traverse in the tablet, 0 if the tablet doesn't keep it
+    uint64_t GetCursorId() const { return cursor_id_; }
+
  private:
     void Reset();
 
@@ -112,6 +116,7 @@ class TraverseKvIterator : public KvIterator {
     std::string last_pk_;
     uint32_t ts_pos_;
     uint64_t last_ts_;
+    uint64_t cursor_id_;
 };
 
 }  // namespace base
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/numa_util.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+
+namespace openmldb::base {
+
+#if defined(__linux__)
+// the memory policies in linux/mempolicy.h, numaif.h is not required
+constexpr int MEMPOLICY_DEFAULT = 0;
+constexpr int MEMPOLICY_PREFERRED = 1;
+constexpr const char* NUMA_NODE_PATH = "/sys/devices/system/node/";
+// the max number of nodes in the node mask of the memory policy
+constexpr int MAX_NUMA_NODE_NUM = 1024;
+constexpr int NODE_MASK_BITS = sizeof(unsigned long) * 8;  // NOLINT
+#endif
+
+bool ParseCpuList(const std::string& cpu_list, std::vector<int>* cpus) {
+    cpus->clear();
+    for (absl::string_view item : absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+        item = absl::StripAsciiWhitespace(item);
+        std::vector<absl::string_view> range = absl::StrSplit(item, '-');
+        int begin = 0;
+        int end = 0;
+        if (range.size() > 2 || !absl::SimpleAtoi(range[0], &begin)) {
+            return false;
+        }
+        end = begin;
+        if (range.size() == 2 && !absl::SimpleAtoi(range[1], &end)) {
+            return false;
+        }
+        if (begin < 0 || end < begin) {
+            return false;
+        }
+        for (int cpu = begin; cpu <= end; cpu++) {
+            cpus->push_back(cpu);
+        }
+    }
+    return true;
+}
+
+bool GetNumaNodeCpus(std::vector<std::vector<int>>* node_cpus) {
+    node_cpus->clear();
+#if defined(__linux__)
+    auto read_line = [](const std::string& path, std::string* line) {
+        std::ifstream file(path);
+        return file.is_open() && static_cast<bool>(std::getline(file, *line));
+    };
+    std::string line;
+    std::vector<int> nodes;
+    if (!read_line(std::string(NUMA_NODE_PATH) + "online", &line) || !ParseCpuList(line, &nodes) ||
+        nodes.empty()) {
+        return false;
+    }
+    node_cpus->resize(nodes.back() + 1);
+    for (int node : nodes) {
+        std::string path = std::string(NUMA_NODE_PATH) + "node" + std::to_string(node) + "/cpulist";
+        if (!read_line(path, &line) || !ParseCpuList(line, &(*node_cpus)[node])) {
+            node_cpus->clear();
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool GetThreadNumaState(ThreadNumaState* state) {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        return false;
+    }
+    state->cpus.clear();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpu_set)) {
+            state->cpus.push_back(cpu);
+        }
+    }
+    state->node_mask.assign(MAX_NUMA_NODE_NUM / NODE_MASK_BITS, 0);
+    int mode = MEMPOLICY_DEFAULT;
+    if (syscall(SYS_get_mempolicy, &mode, state->node_mask.data(), MAX_NUMA_NODE_NUM, nullptr, 0) != 0) {
+        return false;
+    }
+    state->mem_policy = mode;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SetThreadNumaState(const ThreadNumaState& state) {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : state.cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    bool ok = sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+    if (state.mem_policy == MEMPOLICY_DEFAULT || state.node_mask.empty()) {
+        ok = syscall(SYS_set_mempolicy, state.mem_policy, nullptr, 0) == 0 && ok;
+    } else {
+        ok = syscall(SYS_set_mempolicy, state.mem_policy, state.node_mask.data(),
+                     state.node_mask.size() * NODE_MASK_BITS) == 0 && ok;
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+bool BindThreadToNumaNode(int node, const std::vector<int>& cpus) {
+#if defined(__linux__)
+    if (node < 0 || node >= MAX_NUMA_NODE_NUM || cpus.empty()) {
+        return false;
+    }
+    cpu_set_t old_cpu_set;
+    CPU_ZERO(&old_cpu_set);
+    if (sched_getaffinity(0, sizeof(old_cpu_set), &old_cpu_set) != 0) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        return false;
+    }
+    std::vector<unsigned long> node_mask(MAX_NUMA_NODE_NUM / NODE_MASK_BITS, 0);  // NOLINT
+    node_mask[node / NODE_MASK_BITS] |= 1UL << (node % NODE_MASK_BITS);
+    if (syscall(SYS_set_mempolicy, MEMPOLICY_PREFERRED, node_mask.data(), MAX_NUMA_NODE_NUM) != 0) {
+        // don't leave the thread half bound
+        sched_setaffinity(0, sizeof(old_cpu_set), &old_cpu_set);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+}  // namespace openmldb::base
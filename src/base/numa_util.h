@@ -0,0 +1,50 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_NUMA_UTIL_H_
+#define SRC_BASE_NUMA_UTIL_H_
+
+#include <string>
+#include <vector>
+
+namespace openmldb::base {
+
+// parse the cpu list like "0-3,8,10-11" in sysfs
+bool ParseCpuList(const std::string& cpu_list, std::vector<int>* cpus);
+
+// the cpus of each numa node, the index is the node id. return false if the topology can't be read, e.g. not linux
+bool GetNumaNodeCpus(std::vector<std::vector<int>>* node_cpus);
+
+// the cpu affinity and the memory policy of a thread
+struct ThreadNumaState {
+    std::vector<int> cpus;
+    int mem_policy = 0;
+    std::vector<unsigned long> node_mask;  // NOLINT
+};
+
+// save the cpu affinity and the memory policy of the current thread
+bool GetThreadNumaState(ThreadNumaState* state);
+
+// restore the cpu affinity and the memory policy saved by GetThreadNumaState
+bool SetThreadNumaState(const ThreadNumaState& state);
+
+// run the current thread on the cpus of the node and allocate its new pages from the node preferably. the thread is
+// left unchanged if it fails, e.g. set_mempolicy is not permitted in the container
+bool BindThreadToNumaNode(int node, const std::vector<int>& cpus);
+
+}  // namespace openmldb::base
+
+#endif  // SRC_BASE_NUMA_UTIL_H_
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/numa_util.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class NumaUtilTest : public ::testing::Test {
+ public:
+    NumaUtilTest() {}
+    ~NumaUtilTest() {}
+};
+
+TEST_F(NumaUtilTest, ParseCpuList) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(ParseCpuList("0-3,8,10-11\n", &cpus));
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), cpus);
+    ASSERT_TRUE(ParseCpuList("5", &cpus));
+    ASSERT_EQ(std::vector<int>({5}), cpus);
+    ASSERT_TRUE(ParseCpuList("", &cpus));
+    ASSERT_TRUE(cpus.empty());
+    ASSERT_FALSE(ParseCpuList("3-1", &cpus));
+    ASSERT_FALSE(ParseCpuList("a", &cpus));
+    ASSERT_FALSE(ParseCpuList("1-2-3", &cpus));
+}
+
+TEST_F(NumaUtilTest, BindThread) {
+    std::vector<std::vector<int>> node_cpus;
+    if (!GetNumaNodeCpus(&node_cpus)) {
+        GTEST_SKIP() << "numa topology is not available";
+    }
+    ASSERT_FALSE(node_cpus.empty());
+    ThreadNumaState old_state;
+    if (!GetThreadNumaState(&old_state)) {
+        GTEST_SKIP() << "get_mempolicy is not permitted";
+    }
+    for (size_t node = 0; node < node_cpus.size(); node++) {
+        if (node_cpus[node].empty()) {
+            continue;
+        }
+        if (BindThreadToNumaNode(node, node_cpus[node])) {
+            ThreadNumaState state;
+            ASSERT_TRUE(GetThreadNumaState(&state));
+            // MPOL_PREFERRED
+            ASSERT_EQ(1, state.mem_policy);
+            ASSERT_TRUE(SetThreadNumaState(old_state));
+        }
+        // the thread is restored, or left unchanged if it fails to bind
+        ThreadNumaState state;
+        ASSERT_TRUE(GetThreadNumaState(&state));
+        ASSERT_EQ(old_state.cpus, state.cpus);
+        ASSERT_EQ(old_state.mem_policy, state.mem_policy);
+    }
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <vector>
 
 #include "base/random.h"
 
@@ -362,6 +363,35 @@ class Skiplist {
     // delete the iterator after it's used
     Iterator* NewIterator() { return new Iterator(this); }
 
+    // Appender builds the list from sorted input. It links the node after the
+    // last one on every level without comparing keys. The list must be empty
+    // when the appender is created and the keys must be appended in the order
+    // of comparator. Need external synchronized
+    class Appender {
+     public:
+        explicit Appender(Skiplist<K, V, Comparator>* list) : list_(list), pre_(list->MaxHeight, list->head_) {}
+        ~Appender() {}
+
+        uint8_t Append(const K& key, V& value) {  // NOLINT
+            uint8_t height = list_->RandomHeight();
+            if (height > list_->GetMaxHeight()) {
+                list_->max_height_.store(height, std::memory_order_relaxed);
+            }
+            Node<K, V>* node = list_->NewNode(key, value, height);
+            for (uint8_t i = 0; i < height; i++) {
+                node->SetNextNoBarrier(i, NULL);
+                pre_[i]->SetNext(i, node);
+                pre_[i] = node;
+            }
+            list_->tail_.store(node, std::memory_order_release);
+            return height;
+        }
+
+     private:
+        Skiplist<K, V, Comparator>* const list_;
+        std::vector<Node<K, V>*> pre_;
+    };
+
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
         Node<K, V>* node = new Node<K, V>(key, value, height);
@@ -468,6 +498,7 @@ class Skiplist {
     Node<K, V>* head_;
     std::atomic<Node<K, V>*> tail_;
     friend Iterator;
+    friend Appender;
 };
 
 }  // namespace base
@@ -16,6 +16,7 @@
 
 #include "base/skiplist.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -663,6 +664,45 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, Appender) {
+    Comparator cmp;
+    for (auto height : vec) {
+        Skiplist<uint32_t, uint32_t, Comparator> sl(height, 4, cmp);
+        {
+            Skiplist<uint32_t, uint32_t, Comparator>::Appender appender(&sl);
+            for (uint32_t idx = 0; idx < 1000; idx++) {
+                uint32_t value = idx * 2;
+                ASSERT_LE(appender.Append(idx, value), height);
+            }
+        }
+        ASSERT_EQ(999u, sl.GetLast()->GetKey());
+        std::unique_ptr<Skiplist<uint32_t, uint32_t, Comparator>::Iterator> it(sl.NewIterator());
+        it->SeekToFirst();
+        for (uint32_t idx = 0; idx < 1000; idx++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(idx, it->GetKey());
+            ASSERT_EQ(idx * 2, it->GetValue());
+            it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+        // the list built by appender can be searched and modified as usual
+        for (uint32_t idx = 0; idx < 1000; idx += 7) {
+            it->Seek(idx);
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(idx, it->GetKey());
+        }
+        uint32_t key = 1000;
+        uint32_t value = 1;
+        sl.Insert(key, value);
+        ASSERT_EQ(1000u, sl.GetLast()->GetKey());
+        auto node = sl.Remove(500);
+        ASSERT_TRUE(node != NULL);
+        delete node;
+        it->Seek(500);
+        ASSERT_EQ(501u, it->GetKey());
+    }
+}
+
 }  // namespace base
 }  // namespace openmldb
 
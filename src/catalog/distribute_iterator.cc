@@ -144,8 +144,9 @@ bool FullTableIterator::NextFromRemote() {
         uint32_t count = 0;
         if (kv_it_) {
             if (!kv_it_->IsFinish()) {
+                // the tablet continues from the cursor if it's kept, or seeks the last pk otherwise
                 kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
-                            FLAGS_traverse_cnt_limit, false, kv_it_->GetTSPos(), count);
+                            FLAGS_traverse_cnt_limit, false, kv_it_->GetTSPos(), count, true, kv_it_->GetCursorId());
                 DLOG(INFO) << "pid " << cur_pid_ << " last pk " << last_pk_ <<
                     " key " << last_ts_ << " ts_pos " << kv_it_->GetTSPos() << " count " << count;
             } else {
@@ -154,7 +155,7 @@ bool FullTableIterator::NextFromRemote() {
                 continue;
             }
         } else {
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, 0, count);
+            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, 0, count, true);
             DVLOG(1) << "count " << count;
         }
         if (kv_it_ && kv_it_->Valid()) {
@@ -939,7 +939,8 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
                                                                            const std::string& idx_name,
                                                                            const std::string& pk, uint64_t ts,
                                                                            uint32_t limit, bool skip_current_pk,
-                                                                           uint32_t ts_pos, uint32_t& count) {
+                                                                           uint32_t ts_pos, uint32_t& count,
+                                                                           bool keep_cursor, uint64_t cursor_id) {
     ::openmldb::api::TraverseRequest request;
     auto response = std::make_shared<openmldb::api::TraverseResponse>();
     request.set_tid(tid);
@@ -954,6 +955,10 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
         request.set_ts_pos(ts_pos);
     }
     request.set_skip_current_pk(skip_current_pk);
+    request.set_keep_cursor(keep_cursor);
+    if (cursor_id > 0) {
+        request.set_cursor_id(cursor_id);
+    }
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, &request, response.get(),
                                   FLAGS_request_timeout_ms, FLAGS_request_max_retry);
     if (!ok || response->code() != 0) {
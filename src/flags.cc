@@ -88,8 +88,17 @@ DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview")
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_string(binlog_sync_compress_type, "off", "the compress type of sync binlog batch, can be off or snappy");
+DEFINE_uint32(binlog_sync_compress_min_size, 4096,
+              "the min bytes size of a sync binlog batch to be compressed. smaller batch is sent without compression");
+DEFINE_int32(binlog_apply_pool_size, 4,
+             "the size of the thread pool in which the follower uncompresses and applies the compressed binlog batch");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
-DEFINE_bool(binlog_enable_crc, false, "enable crc");
+DEFINE_uint32(binlog_semi_sync_ack_num, 0,
+              "the number of followers which should ack before put returns, 0 means async replication");
+DEFINE_uint32(binlog_semi_sync_timeout_ms, 10,
+              "the max time to wait for followers ack in semi-sync replication, fall back to async if timeout");
+DEFINE_bool(binlog_enable_crc, true, "verify the crc of records when reading binlog and snapshot files");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time. unit is milliseconds");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time. unit is milliseconds");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000,
@@ -97,6 +106,8 @@ DEFINE_int32(binlog_sync_to_disk_interval, 20000,
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog. unit is milliseconds");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset. unit is milliseconds");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
+DEFINE_uint32(binlog_index_interval, 1024 * 1024,
+              "the interval in bytes of the sparse index of binlog file, 0 means no index is written");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
@@ -129,6 +140,10 @@ DEFINE_int32(retry_send_file_wait_time_ms, 3000, "conf the wait time when retry
 DEFINE_int32(stream_close_wait_time_ms, 1000, "the wait time before close stream. unit is milliseconds");
 DEFINE_uint32(stream_block_size, 1 * 1204 * 1024, "config the write/read block size in streaming");
 DEFINE_int32(stream_bandwidth_limit, 10 * 1204 * 1024, "the limit bandwidth. Byte/Second");
+DEFINE_uint32(stream_send_window, 8, "the max number of blocks in flight when sending a file");
+DEFINE_uint32(stream_send_file_concurrency, 4, "the number of files sent in parallel when sending a directory");
+DEFINE_uint32(stream_checkpoint_interval, 64 * 1024 * 1024,
+              "the receiver checkpoints the progress every this bytes, so a broken transfer can be resumed");
 
 // if set 23, the task will execute 23:00 every day
 DEFINE_int32(make_snapshot_time, 23, "config the time to make snapshot");
@@ -136,10 +151,85 @@ DEFINE_int32(make_snapshot_check_interval, 1000 * 60 * 10,
              "config the interval to check making snapshot time. unit is milliseconds");
 DEFINE_int32(make_snapshot_threshold_offset, 100000, "config the offset to reach the threshold");
 DEFINE_uint32(make_snapshot_max_deleted_keys, 1000000, "config the max deleted keys store when make snapshot");
+DEFINE_uint32(make_snapshot_max_pending_rows, 1000000,
+              "config the max rows in several inner indexes held when make snapshot from memory, "
+              "the snapshot is made by replaying binlog if it's exceeded");
 DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "config tablet self makesnapshot when how long time do not "
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
+DEFINE_bool(make_snapshot_image, false,
+            "dump a memory image of the memory table after making snapshot, it's used to speed up the restart");
+DEFINE_bool(make_snapshot_from_memory, false,
+            "make snapshot of the memory table by dumping its rows instead of replaying the old snapshot and binlog");
+DEFINE_bool(snapshot_image_mapped, false,
+            "write the rows of memory image into a separate file which is mapped when loading the image, "
+            "the rows stay in page cache instead of being copied into heap");
+DEFINE_uint32(snapshot_read_ahead_size, 0,
+              "the size of each read when reading snapshot and index files, the next block is read ahead in "
+              "background while the current one is decoded. unit is byte, 0 means disable read ahead");
+DEFINE_uint32(index_data_thread_num, 4,
+              "the number of threads to extract and load the data of new index when adding index");
+DEFINE_bool(stream_load_snapshot, false,
+            "load the snapshot files of memory table into the table while they are received from other tablet, "
+            "instead of reading them again after the transfer");
+DEFINE_uint32(recover_thread_num, 3,
+              "the number of partitions recovered at the same time when loading tables, the leader partitions and "
+              "the partitions used by deployments are recovered first");
+DEFINE_uint32(recover_memory_budget_mb, 0,
+              "the max estimated size of data being recovered at the same time when loading tables, a partition "
+              "larger than it is recovered alone. unit is MB, 0 means no limit");
+DEFINE_uint32(procedure_result_cache_size_mb, 0,
+              "the max size of the cached output rows of deployments in request mode, the identical request rows "
+              "get the cached output if the tables used are not changed. unit is MB, 0 means disable the cache");
+DEFINE_uint32(procedure_result_cache_ttl_ms, 1000,
+              "the max time an output row is cached, it bounds the staleness of the data in the other tablets. "
+              "unit is milliseconds, 0 means no expiration");
+DEFINE_uint32(request_coalesce_window_us, 0,
+              "the max time a request row of a deployment waits for the concurrent rows of the same deployment, "
+              "the rows are run together in batch request mode. unit is microseconds, 0 means disable coalescing");
+DEFINE_uint32(request_coalesce_max_batch_size, 64, "the max number of request rows run together in a batch");
+DEFINE_bool(numa_mode, false,
+            "bind each partition to a numa node, the data of the partition is loaded and the put requests of it "
+            "are run by the workers pinned to the node");
+DEFINE_uint32(numa_thread_num_per_node, 8, "the number of the workers pinned to each numa node in numa mode");
+DEFINE_uint32(numa_max_pending_task_num, 1024,
+              "the max number of the tasks waiting for the workers of each numa node, the put request is run by "
+              "the rpc thread if the queue is full");
+DEFINE_uint32(online_latency_slo_ms, 0,
+              "the target p99 latency of the online queries, the background work like snapshot, gc and sending data "
+              "is throttled when it's exceeded. unit is milliseconds, 0 means the background work is not throttled");
+DEFINE_uint32(background_io_limit_mb, 0,
+              "the max bytes per second sent by the background work when the online latency is normal, it's lowered "
+              "when the online latency exceeds online_latency_slo_ms. unit is MB, 0 means no limit");
+DEFINE_uint32(resource_governor_interval_ms, 1000,
+              "the interval to adjust the budget of the background work by the online latency");
+DEFINE_uint32(traverse_cursor_max_num, 1024,
+              "the max number of the traverse cursors kept in the tablet, the next request of a traverse continues "
+              "from the cursor instead of seeking the last key. 0 means the cursors are disabled");
+DEFINE_uint32(traverse_cursor_idle_timeout_ms, 60000, "the traverse cursor not used in the time is dropped");
+DEFINE_string(jit_object_cache_dir, "",
+              "the directory to keep the object code compiled from the sql, the deployments compiled before are "
+              "loaded from it after the restart. it can be shared by the tablets in the same host. empty means the "
+              "object code is not cached");
+DEFINE_uint32(jit_object_cache_max_size_mb, 1024,
+              "the max total size of the object code in jit_object_cache_dir, the least recently used object code is "
+              "removed beyond it. unit is MB, 0 means no limit");
+DEFINE_uint32(procedure_compile_thread_num, 4,
+              "the max number of the threads to compile the procedures and deployments loaded from zookeeper");
+DEFINE_bool(enable_parameterize_literal, false,
+            "rewrite the literals compared with the columns in the where clauses of the batch queries into "
+            "parameters, so the queries different only in these literals share one compiled plan");
+DEFINE_uint32(tiered_compile_threshold, 0,
+              "the batch queries are compiled without the jit optimizations at first, and recompiled with the "
+              "optimizations in the background after they run the times. 0 means the queries are always compiled "
+              "with the optimizations");
+DEFINE_uint32(snapshot_shard_num, 1,
+              "the number of files the snapshot of memory table is sharded into by segment, "
+              "the shards are written and loaded in parallel");
+DEFINE_uint32(snapshot_max_delta_num, 0,
+              "the max number of delta files after the base snapshot of memory table, the binlog since last snapshot "
+              "is written to a delta instead of rewriting the whole snapshot. 0 means disable");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000,
@@ -30,8 +30,15 @@ namespace log {
 // Return the crc32c of concat(A, data[0,n-1]) where init_crc is the
 // crc32c of some string A.  Extend() is often used to maintain the
 // crc32c of a stream of data.
+// It uses the SSE4.2 crc32 instruction if the cpu supports it.
 extern uint32_t Extend(uint32_t init_crc, const char* data, size_t n);
 
+// The table-driven implementation of Extend() which runs on any cpu
+extern uint32_t ExtendPortable(uint32_t init_crc, const char* data, size_t n);
+
+// Return true if Extend() uses the crc32 instruction
+extern bool IsHardwareAccelerated();
+
 // Return the crc32c of data[0,n-1]
 inline uint32_t Value(const char* data, size_t n) { return Extend(0, data, n); }
 
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// crc32c throughput of the portable and the hardware accelerated implementation
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "log/crc32c.h"
+
+namespace openmldb {
+namespace log {
+
+static void BM_Crc32cPortable(benchmark::State& state) {  // NOLINT
+    std::string data(state.range(0), 'a');
+    uint32_t crc = 0;
+    for (auto _ : state) {
+        crc = ExtendPortable(crc, data.data(), data.size());
+        benchmark::DoNotOptimize(crc);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_Crc32cExtend(benchmark::State& state) {  // NOLINT
+    std::string data(state.range(0), 'a');
+    uint32_t crc = 0;
+    for (auto _ : state) {
+        crc = Extend(crc, data.data(), data.size());
+        benchmark::DoNotOptimize(crc);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.SetLabel(IsHardwareAccelerated() ? "hardware accelerated" : "portable");
+}
+
+// 4096 is the size of a binlog block
+BENCHMARK(BM_Crc32cPortable)->Arg(64)->Arg(4096)->Arg(64 << 10);
+BENCHMARK(BM_Crc32cExtend)->Arg(64)->Arg(4096)->Arg(64 << 10);
+
+}  // namespace log
+}  // namespace openmldb
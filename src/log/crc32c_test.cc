@@ -0,0 +1,74 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log/crc32c.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <string>
+
+namespace openmldb {
+namespace log {
+
+class Crc32cTest : public ::testing::Test {
+ public:
+    Crc32cTest() {}
+    ~Crc32cTest() {}
+};
+
+TEST_F(Crc32cTest, StandardResults) {
+    // From rfc3720 section B.4.
+    char buf[32];
+    memset(buf, 0, sizeof(buf));
+    ASSERT_EQ(0x8a9136aaU, Value(buf, sizeof(buf)));
+    ASSERT_EQ(0x8a9136aaU, ExtendPortable(0, buf, sizeof(buf)));
+    memset(buf, 0xff, sizeof(buf));
+    ASSERT_EQ(0x62a8ab43U, Value(buf, sizeof(buf)));
+    for (int i = 0; i < 32; i++) {
+        buf[i] = i;
+    }
+    ASSERT_EQ(0x46dd794eU, Value(buf, sizeof(buf)));
+    ASSERT_EQ(0xe3069283U, Value("123456789", 9));
+}
+
+TEST_F(Crc32cTest, Extend) {
+    ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
+}
+
+TEST_F(Crc32cTest, SameAsPortable) {
+    std::string data(3 * 8192 * 2 + 100, '\0');
+    for (auto& c : data) {
+        c = static_cast<char>(rand());  // NOLINT
+    }
+    // cover the unaligned head, the long and short interleaved streams and the tail
+    for (size_t len : {0, 1, 7, 8, 63, 767, 768, 769, 3 * 8192 - 1, 3 * 8192, 3 * 8192 * 2 + 37}) {
+        for (size_t offset = 0; offset < 16; offset++) {
+            uint32_t init = rand();  // NOLINT
+            ASSERT_EQ(ExtendPortable(init, data.data() + offset, len), Extend(init, data.data() + offset, len))
+                << "len " << len << " offset " << offset;
+        }
+    }
+}
+
+}  // namespace log
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    srand(time(NULL));
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
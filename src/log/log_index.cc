@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log/log_index.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <vector>
+
+#include "base/endianconv.h"
+#include "base/glog_wrapper.h"
+
+namespace openmldb {
+namespace log {
+
+std::string GetLogIndexPath(const std::string& log_file_path) {
+    std::string path = log_file_path;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".log") == 0) {
+        path.resize(path.size() - 4);
+    }
+    return path + ".idx";
+}
+
+LogIndexWriter::LogIndexWriter(const std::string& fname, FILE* fd, uint32_t block_size, uint64_t interval)
+    : fname_(fname), fd_(fd), block_size_(block_size), interval_(interval), next_offset_(0), failed_(false) {}
+
+LogIndexWriter::~LogIndexWriter() {
+    if (fd_ != NULL) {
+        fclose(fd_);
+    }
+}
+
+bool LogIndexWriter::Add(uint64_t log_index, uint64_t file_offset) {
+    if (failed_ || file_offset < next_offset_) {
+        return true;
+    }
+    uint64_t block_offset = file_offset - file_offset % block_size_;
+    char buf[kLogIndexItemSize];
+    memcpy(buf, &log_index, sizeof(uint64_t));
+    memrev64ifbe(buf);
+    memcpy(buf + sizeof(uint64_t), &block_offset, sizeof(uint64_t));
+    memrev64ifbe(buf + sizeof(uint64_t));
+    // the item is flushed immediately, so readers can use the index of the binlog being written
+    if (fwrite(buf, 1, kLogIndexItemSize, fd_) != kLogIndexItemSize || fflush(fd_) != 0) {
+        PDLOG(WARNING, "fail to write log index %s, errno %d. stop indexing this file", fname_.c_str(), errno);
+        failed_ = true;
+        return false;
+    }
+    next_offset_ = block_offset + interval_;
+    return true;
+}
+
+LogIndexWriter* NewLogIndexWriter(const std::string& log_file_path, uint32_t block_size, uint64_t interval) {
+    if (interval == 0) {
+        return nullptr;
+    }
+    std::string index_path = GetLogIndexPath(log_file_path);
+    FILE* fd = fopen(index_path.c_str(), "wb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create log index %s, errno %d", index_path.c_str(), errno);
+        return nullptr;
+    }
+    return new LogIndexWriter(index_path, fd, block_size, interval);
+}
+
+uint64_t SeekLogIndex(const std::string& log_file_path, uint64_t log_index) {
+    std::string index_path = GetLogIndexPath(log_file_path);
+    FILE* fd = fopen(index_path.c_str(), "rb");
+    if (fd == NULL) {
+        return 0;
+    }
+    std::vector<char> data;
+    char buf[4096];
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), fd)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fd);
+    // ignore the incomplete item at the tail
+    size_t cnt = data.size() / kLogIndexItemSize;
+    auto get_item = [&data](size_t pos, uint64_t* cur_index, uint64_t* cur_offset) {
+        const char* item = data.data() + pos * kLogIndexItemSize;
+        memcpy(cur_index, item, sizeof(uint64_t));
+        memrev64ifbe(cur_index);
+        memcpy(cur_offset, item + sizeof(uint64_t), sizeof(uint64_t));
+        memrev64ifbe(cur_offset);
+    };
+    // find the last item whose log index is not greater than log_index
+    size_t left = 0;
+    size_t right = cnt;
+    uint64_t offset = 0;
+    while (left < right) {
+        size_t mid = left + (right - left) / 2;
+        uint64_t cur_index = 0;
+        uint64_t cur_offset = 0;
+        get_item(mid, &cur_index, &cur_offset);
+        if (cur_index <= log_index) {
+            offset = cur_offset;
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return offset;
+}
+
+}  // namespace log
+}  // namespace openmldb
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_LOG_LOG_INDEX_H_
+#define SRC_LOG_LOG_INDEX_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+namespace openmldb {
+namespace log {
+
+// Sparse index of a binlog file. It maps the log index of a record to the offset
+// of the block the record starts in, so LogReader can skip the blocks before the
+// offset it wants instead of reading the file from the beginning.
+//
+// The index file is a sequence of items, each item is
+// log_index(8 bytes) + block_offset(8 bytes) in little endian
+static const uint32_t kLogIndexItemSize = 8 + 8;
+
+// 00000001.log -> 00000001.idx
+std::string GetLogIndexPath(const std::string& log_file_path);
+
+class LogIndexWriter {
+ public:
+    // add an item every `interval` bytes of the binlog file
+    LogIndexWriter(const std::string& fname, FILE* fd, uint32_t block_size, uint64_t interval);
+    ~LogIndexWriter();
+
+    // call it before the record with `log_index` is written at `file_offset` of binlog file
+    bool Add(uint64_t log_index, uint64_t file_offset);
+
+    LogIndexWriter(const LogIndexWriter&) = delete;
+    LogIndexWriter& operator=(const LogIndexWriter&) = delete;
+
+ private:
+    std::string fname_;
+    FILE* fd_;
+    uint32_t block_size_;
+    uint64_t interval_;
+    // the file offset from which the next item will be added
+    uint64_t next_offset_;
+    bool failed_;
+};
+
+// create the index file for binlog `log_file_path`. return nullptr if interval is 0 or fail to create
+LogIndexWriter* NewLogIndexWriter(const std::string& log_file_path, uint32_t block_size, uint64_t interval);
+
+// get the block offset from which the record with `log_index` can be reached by
+// reading forward. return 0 if the index file does not exist or has no suitable item
+uint64_t SeekLogIndex(const std::string& log_file_path, uint64_t log_index);
+
+}  // namespace log
+}  // namespace openmldb
+
+#endif  // SRC_LOG_LOG_INDEX_H_
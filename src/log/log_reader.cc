@@ -32,6 +32,7 @@
 #include "log/coding.h"
 #include "log/crc32c.h"
 #include "log/log_format.h"
+#include "log/log_index.h"
 #include "log/status.h"
 
 DECLARE_bool(binlog_enable_crc);
@@ -268,6 +269,9 @@ void Reader::GoBackToLastBlock() {
 void Reader::GoBackToStart() {
     uint64_t block_start_location = 0;
     PDLOG(WARNING, "go back block to start");
+    // the initial offset may come from a stale log index, so read the whole file again
+    initial_offset_ = 0;
+    resyncing_ = false;
     end_of_buffer_offset_ = block_start_location;
     buffer_.clear();
     file_->Seek(block_start_location);
@@ -531,7 +535,10 @@ int LogReader::RollRLogFile() {
     it->SeekToFirst();
     // use log entry offset to find the log part file
     int index = -1;
+    // only the first file is opened from the middle
+    bool seek_by_index = false;
     if (log_part_index_ < 0) {
+        seek_by_index = true;
         while (it->Valid()) {
             DEBUGLOG("log index[%u] and start offset %lld", it->GetKey(), it->GetValue());
             if (it->GetValue() <= start_offset_) {
@@ -573,8 +580,17 @@ int LogReader::RollRLogFile() {
             return -1;
         }
         delete reader_;
+        uint64_t initial_offset = 0;
+        if (seek_by_index && !compressed_) {
+            // the block offset in the index of compressed file is not the physical offset
+            initial_offset = SeekLogIndex(full_path, start_offset_ + 1);
+            if (initial_offset > 0) {
+                PDLOG(INFO, "seek log file %s to block offset %lu by index for log offset %lu", full_path.c_str(),
+                      initial_offset, start_offset_);
+            }
+        }
         // roll a new log part file, reset status
-        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, 0, compressed_);
+        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, initial_offset, compressed_);
         PDLOG(INFO, "roll log file from index[%d] to index[%d]", log_part_index_, index);
         log_part_index_ = index;
         return 0;
@@ -22,6 +22,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "base/file_util.h"
@@ -29,8 +30,10 @@
 #include "config.h"  // NOLINT
 #include "log/coding.h"
 #include "log/crc32c.h"
+#include "log/log_index.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
+#include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
 
 using ::openmldb::base::Slice;
@@ -410,6 +413,122 @@ TEST_F(LogWRTest, TestInit) {
     ASSERT_EQ(compressed_, reader.GetCompressed());
 }
 
+TEST_F(LogWRTest, TestLogIndex) {
+    if (FLAGS_snapshot_compression != "off") {
+        return;
+    }
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "00000001.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    std::unique_ptr<LogIndexWriter> index_writer(NewLogIndexWriter(full_path, kBlockSize, 8 * 1024));
+    ASSERT_TRUE(index_writer);
+    ASSERT_EQ(log_dir + "/00000001.idx", GetLogIndexPath(full_path));
+    for (uint64_t i = 1; i <= 1000; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(i);
+        entry.set_pk("key" + std::to_string(i));
+        entry.set_value(std::string(1000, 'a'));
+        std::string val;
+        ASSERT_TRUE(entry.SerializeToString(&val));
+        ASSERT_TRUE(index_writer->Add(i, wf->GetSize()));
+        ASSERT_TRUE(writer.AddRecord(val).ok());
+    }
+    wf->Flush();
+    ASSERT_EQ(0u, SeekLogIndex(full_path, 0));
+    ASSERT_EQ(0u, SeekLogIndex(log_dir + "/00000002.log", 500));
+    uint64_t offset = SeekLogIndex(full_path, 500);
+    ASSERT_GT(offset, 0u);
+    ASSERT_EQ(0u, offset % kBlockSize);
+
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    std::unique_ptr<SequentialFile> rf(NewSeqFile(fname, fd_r));
+    Reader reader(rf.get(), NULL, true, offset, false);
+    std::string scratch;
+    Slice value;
+    uint32_t read_cnt = 0;
+    uint64_t first_index = 0;
+    while (true) {
+        Status status = reader.ReadRecord(&value, &scratch);
+        ASSERT_TRUE(status.ok()) << status.ToString();
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(value.ToString()));
+        if (first_index == 0) {
+            first_index = entry.log_index();
+        }
+        read_cnt++;
+        if (entry.log_index() == 500) {
+            break;
+        }
+    }
+    ASSERT_LE(first_index, 500u);
+    ASSERT_LT(read_cnt, 20u);
+    // go back to start reads the whole file
+    reader.GoBackToStart();
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+    ::openmldb::api::LogEntry entry;
+    ASSERT_TRUE(entry.ParseFromString(value.ToString()));
+    ASSERT_EQ(1u, entry.log_index());
+}
+
+TEST_F(LogWRTest, TestReadAhead) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    std::vector<std::string> values;
+    for (int i = 0; i < 1000; i++) {
+        values.push_back(std::string(i % 100 * 100 + 1, 'a' + i % 26));
+        ASSERT_TRUE(writer.AddRecord(values.back()).ok());
+    }
+    writer.EndLog();
+    delete wf;
+    for (uint32_t read_size : {1u, 4096u, 100000u}) {
+        FILE* fd_r = fopen(full_path.c_str(), "rb");
+        ASSERT_TRUE(fd_r != NULL);
+        std::unique_ptr<SequentialFile> rf(NewReadAheadSeqFile(fname, fd_r, read_size));
+        Reader reader(rf.get(), NULL, true, 0, compressed_);
+        std::string scratch;
+        Slice value;
+        for (const auto& expect : values) {
+            Status status = reader.ReadRecord(&value, &scratch);
+            ASSERT_TRUE(status.ok()) << status.ToString();
+            ASSERT_EQ(expect, value.ToString());
+        }
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsEof());
+        // seek back and read again
+        reader.GoBackToStart();
+        ASSERT_TRUE(reader.ReadRecord(&value, &scratch).ok());
+        ASSERT_EQ(values[0], value.ToString());
+    }
+    // skip to the middle of file
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    std::unique_ptr<SequentialFile> rf(NewReadAheadSeqFile(fname, fd_r, 4096));
+    std::string expect(100, 0);
+    std::string buf(100, 0);
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    ASSERT_EQ(0, fseek(fd, 5000, SEEK_SET));
+    ASSERT_EQ(100u, fread(&expect[0], 1, 100, fd));
+    fclose(fd);
+    ASSERT_TRUE(rf->Skip(5000).ok());
+    Slice result;
+    ASSERT_TRUE(rf->Read(100, &result, &buf[0]).ok());
+    ASSERT_EQ(expect, result.ToString());
+    uint64_t pos = 0;
+    ASSERT_TRUE(rf->Tell(&pos).ok());
+    ASSERT_EQ(5100u, pos);
+}
+
 }  // namespace log
 }  // namespace openmldb
 
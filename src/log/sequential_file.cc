@@ -21,7 +21,17 @@
 #include "log/sequential_file.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
 
 #include "base/glog_wrapper.h"
 #include "base/slice.h"
@@ -91,7 +101,186 @@ class PosixSequentialFile : public SequentialFile {
     }
 };
 
+constexpr uint64_t kReadAheadAlign = 4096;
+
+// ReadAheadSequentialFile keeps two blocks, the current one is consumed by Read and the next one is filled by
+// the background thread with pread. The thread is started by the first Read and restarted by Seek
+class ReadAheadSequentialFile : public SequentialFile {
+ public:
+    ReadAheadSequentialFile(const std::string& fname, FILE* f, uint32_t read_size)
+        : filename_(fname),
+          file_(f),
+          fd_(fileno(f)),
+          read_size_((read_size + kReadAheadAlign - 1) / kReadAheadAlign * kReadAheadAlign) {
+#if __linux__
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    ~ReadAheadSequentialFile() override {
+        StopReadAhead();
+        fclose(file_);
+    }
+
+    Status Read(size_t n, Slice* result, char* scratch) override {
+        if (!started_) {
+            StartReadAhead();
+        }
+        size_t read = 0;
+        while (read < n) {
+            if (cur_pos_ < cur_.size()) {
+                size_t len = std::min(n - read, cur_.size() - cur_pos_);
+                memcpy(scratch + read, cur_.data() + cur_pos_, len);
+                cur_pos_ += len;
+                read += len;
+                continue;
+            }
+            if (cur_eof_) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return next_ready_; });
+            cur_.swap(next_);
+            cur_pos_ = 0;
+            cur_eof_ = next_eof_;
+            cur_status_ = next_status_;
+            next_ready_ = false;
+            cv_.notify_all();
+        }
+        pos_ += read;
+        *result = Slice(scratch, read);
+        // the error is returned after the data read before it is consumed
+        return read < n ? cur_status_ : Status::OK();
+    }
+
+    Status Skip(uint64_t n) override { return Seek(pos_ + n); }
+
+    Status Tell(uint64_t* pos) override {
+        if (pos == NULL) {
+            return Status::InvalidArgument("invalid pos arg");
+        }
+        *pos = pos_;
+        return Status::OK();
+    }
+
+    Status Seek(uint64_t pos) override {
+        StopReadAhead();
+        pos_ = pos;
+        return Status::OK();
+    }
+
+ private:
+    void StartReadAhead() {
+        // the reads start at the aligned offset and the bytes before pos_ are skipped
+        cur_pos_ = pos_ % kReadAheadAlign;
+        cur_eof_ = false;
+        cur_status_ = Status::OK();
+        next_ready_ = false;
+        stop_ = false;
+        uint64_t offset = pos_ - cur_pos_;
+        // the first block is read in the caller thread, then the thread reads ahead from the next one
+        if (!ReadBlock(offset, &cur_, &cur_eof_, &cur_status_)) {
+            cur_eof_ = true;
+        }
+        cur_pos_ = std::min(cur_pos_, cur_.size());
+        if (!cur_eof_) {
+            thread_ = std::thread(&ReadAheadSequentialFile::ReadAhead, this, offset + cur_.size());
+        }
+        started_ = true;
+    }
+
+    void StopReadAhead() {
+        if (!started_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+            cv_.notify_all();
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        started_ = false;
+    }
+
+    void ReadAhead(uint64_t offset) {
+        std::string block;
+        while (true) {
+            bool eof = false;
+            Status status;
+            ReadBlock(offset, &block, &eof, &status);
+            offset += block.size();
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return !next_ready_ || stop_; });
+            if (stop_) {
+                return;
+            }
+            next_.swap(block);
+            next_eof_ = eof || !status.ok();
+            next_status_ = status;
+            next_ready_ = true;
+            cv_.notify_all();
+            if (next_eof_) {
+                return;
+            }
+        }
+    }
+
+    // read a block at offset, eof is set if the block is not full
+    bool ReadBlock(uint64_t offset, std::string* block, bool* eof, Status* status) {
+        block->resize(read_size_);
+        size_t size = 0;
+        while (size < read_size_) {
+            ssize_t ret = pread(fd_, &(*block)[size], read_size_ - size, offset + size);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                *status = Status::IOError(filename_, strerror(errno));
+                break;
+            }
+            if (ret == 0) {
+                *eof = true;
+                break;
+            }
+            size += ret;
+        }
+        block->resize(size);
+        return status->ok();
+    }
+
+ private:
+    std::string filename_;
+    FILE* file_;
+    int fd_;
+    uint64_t read_size_;
+    uint64_t pos_ = 0;
+    bool started_ = false;
+    // the block consumed by Read
+    std::string cur_;
+    size_t cur_pos_ = 0;
+    bool cur_eof_ = false;
+    Status cur_status_;
+    // the block filled by the thread
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::string next_;
+    bool next_ready_ = false;
+    bool next_eof_ = false;
+    Status next_status_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
 SequentialFile* NewSeqFile(const std::string& fname, FILE* f) { return new PosixSequentialFile(fname, f); }
 
+SequentialFile* NewReadAheadSeqFile(const std::string& fname, FILE* f, uint32_t read_size) {
+    if (read_size == 0) {
+        return NewSeqFile(fname, f);
+    }
+    return new ReadAheadSequentialFile(fname, f, read_size);
+}
+
 }  // namespace log
 }  // namespace openmldb
@@ -18,6 +18,7 @@
 #define SRC_LOG_SEQUENTIAL_FILE_H_
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <string>
 
@@ -66,6 +67,11 @@ class SequentialFile {
 
 SequentialFile* NewSeqFile(const std::string& fname, FILE* f);
 
+// The file is read ahead by a background thread in blocks of read_size bytes aligned to the page size,
+// the next block is read while the current one is consumed. It's for the files which are not appended
+// while reading, e.g. snapshot. Return the file of NewSeqFile if read_size is 0
+SequentialFile* NewReadAheadSeqFile(const std::string& fname, FILE* f, uint32_t read_size);
+
 }  // namespace log
 }  // namespace openmldb
 #endif  // SRC_LOG_SEQUENTIAL_FILE_H_
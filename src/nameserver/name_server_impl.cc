@@ -2955,6 +2955,13 @@ void NameServerImpl::ShowOPStatus(RpcController* controller, const ShowOPStatusR
         } else {
             std::shared_ptr<Task> task = kv.second->task_list_.front();
             op_status->set_task_type(::openmldb::api::TaskType_Name(task->task_info_->task_type()));
+            uint64_t processed_cnt = 0;
+            uint64_t records_per_second = 0;
+            task->GetProgress(&processed_cnt, &records_per_second);
+            if (processed_cnt > 0) {
+                op_status->set_processed_cnt(processed_cnt);
+                op_status->set_records_per_second(records_per_second);
+            }
         }
         op_status->set_start_time(kv.second->op_info_.start_time());
         op_status->set_end_time(kv.second->op_info_.end_time());
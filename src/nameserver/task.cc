@@ -73,12 +73,31 @@ bool Task::UpdateStatus(const ::openmldb::api::TaskInfo& task, const std::string
                 task_info_->set_status(task.status());
             }
         }
+        if (task.has_processed_cnt()) {
+            task_info_->set_processed_cnt(task.processed_cnt());
+            task_info_->set_records_per_second(task.records_per_second());
+        }
         traversed_ = true;
         return true;
     }
     return false;
 }
 
+void Task::GetProgress(uint64_t* processed_cnt, uint64_t* records_per_second) const {
+    if (!seq_task_.empty()) {
+        seq_task_.front()->GetProgress(processed_cnt, records_per_second);
+        return;
+    }
+    if (sub_task_.empty()) {
+        *processed_cnt += task_info_->processed_cnt();
+        *records_per_second += task_info_->records_per_second();
+        return;
+    }
+    for (const auto& cur_task : sub_task_) {
+        cur_task->GetProgress(processed_cnt, records_per_second);
+    }
+}
+
 void Task::SetState(const std::string& endpoint, bool is_recover) {
     if (IsFinished()) {
         return;
@@ -55,6 +55,8 @@ class Task {
     std::string GetReadableOpType() const { return ::openmldb::api::OPType_Name(task_info_->op_type()); }
     std::string GetAdditionalMsg();  // for log info
     static std::string GetAdditionalMsg(const ::openmldb::api::TaskInfo& task_info);
+    // the progress reported by tablets, summed over the running sub tasks
+    void GetProgress(uint64_t* processed_cnt, uint64_t* records_per_second) const;
 
     std::string endpoint_;
     std::shared_ptr<::openmldb::api::TaskInfo> task_info_;
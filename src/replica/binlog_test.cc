@@ -23,6 +23,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "client/tablet_client.h"
@@ -104,14 +107,14 @@ TEST_F(BinlogTest, DeleteBinlog) {
     ASSERT_TRUE(ret);
     for (int i = 0; i < 50; i++) {
         vec.clear();
-        ::openmldb::base::GetFileName(binlog_path, vec);
+        ::openmldb::test::GetBinlogFileName(binlog_path, vec);
         if (vec.size() == 1) {
             break;
         }
         sleep(2);
     }
     vec.clear();
-    ::openmldb::base::GetFileName(binlog_path, vec);
+    ::openmldb::test::GetBinlogFileName(binlog_path, vec);
     ASSERT_EQ(1, (int64_t)vec.size());
     std::string file_name = binlog_path + "/00000004.log";
     ASSERT_STREQ(file_name.c_str(), vec[0].c_str());
@@ -25,16 +25,20 @@
 #include <algorithm>
 #include <chrono>  // NOLINT
 #include <cstring>
+#include <functional>
 #include <utility>
 
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "bthread/unstable.h"
+#include "butil/time.h"
 #include "log/log_format.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(binlog_index_interval);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -42,6 +46,46 @@ namespace replica {
 
 static const ::openmldb::base::DefaultComparator scmp;
 
+struct AckWaiter {
+    AckWaiter(uint64_t index, uint32_t num, ::google::protobuf::Closure* closure)
+        : log_index(index), ack_num(num), done(closure), finished(false), ref(1), timer(0) {}
+
+    // return true only for the first caller, who should run done
+    bool Finish() { return !finished.exchange(true, std::memory_order_acq_rel); }
+
+    void Unref() {
+        if (ref.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    uint64_t log_index;
+    uint32_t ack_num;
+    ::google::protobuf::Closure* done;
+    std::atomic<bool> finished;
+    // referenced by ack_waiters_ and the timer
+    std::atomic<int> ref;
+    bthread_timer_t timer;
+};
+
+static void* RunClosure(void* args) {
+    static_cast<::google::protobuf::Closure*>(args)->Run();
+    return NULL;
+}
+
+static void OnAckTimeout(void* args) {
+    AckWaiter* waiter = static_cast<AckWaiter*>(args);
+    if (waiter->Finish()) {
+        DEBUGLOG("wait follower ack timeout, fall back to async. log index %lu", waiter->log_index);
+        // the timer thread should not be blocked by sending response
+        bthread_t tid;
+        if (bthread_start_background(&tid, NULL, RunClosure, waiter->done) != 0) {
+            waiter->done->Run();
+        }
+    }
+    waiter->Unref();
+}
+
 LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
                              const std::map<std::string, std::string>& real_ep_map,
                              const ReplicatorRole& role)
@@ -68,6 +112,20 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
 
 LogReplicator::~LogReplicator() {
     DelAllReplicateNode();
+    {
+        std::lock_guard<bthread::Mutex> lock(ack_mu_);
+        for (auto& kv : ack_waiters_) {
+            AckWaiter* waiter = kv.second;
+            if (waiter->Finish()) {
+                waiter->done->Run();
+            }
+            if (bthread_timer_del(waiter->timer) == 0) {
+                waiter->Unref();
+            }
+            waiter->Unref();
+        }
+        ack_waiters_.clear();
+    }
     if (logs_ != NULL) {
         logs_->Clear();
     }
@@ -75,6 +133,7 @@ LogReplicator::~LogReplicator() {
     logs_ = NULL;
     delete wh_;
     wh_ = NULL;
+    index_writer_.reset();
     nodes_.clear();
 }
 
@@ -114,6 +173,7 @@ bool LogReplicator::Init() {
                 PDLOG(WARNING, "init replicate node %s error", kv.first.c_str());
                 return false;
             }
+            replicate_node->SetSyncCallback([this] { OnFollowerAck(); });
             nodes_.push_back(replicate_node);
             local_endpoints_.push_back(kv.first);
             PDLOG(INFO, "add replica node with endpoint %s", kv.first.c_str());
@@ -187,6 +247,10 @@ bool LogReplicator::Recover() {
     LogEntry entry;
     for (uint32_t i = 0; i < logs.size(); i++) {
         std::string& full_path = logs[i];
+        if (full_path.size() > 4 && full_path.substr(full_path.length() - 4, 4) == ".idx") {
+            // the sparse index of binlog
+            continue;
+        }
         uint32_t binlog_index = 0;
         bool ok = ParseBinlogIndex(full_path, binlog_index);
         if (!ok) {
@@ -281,6 +345,11 @@ void LogReplicator::DeleteBinlog(bool* deleted) {
             }
             PDLOG(INFO, "delete binlog[%s] success", full_path.c_str());
         }
+        std::string index_path = ::openmldb::log::GetLogIndexPath(full_path);
+        if (unlink(index_path.c_str()) < 0 && errno != ENOENT) {
+            PDLOG(WARNING, "delete binlog index[%s] failed! errno[%d] errinfo[%s]", index_path.c_str(), errno,
+                  strerror(errno));
+        }
         delete tmp_node;
     }
 }
@@ -289,8 +358,11 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
-bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+bool LogReplicator::ApplyEntry(const LogEntry& entry, bool* appended) {
     std::lock_guard<std::mutex> lock(wmu_);
+    if (appended) {
+        *appended = false;
+    }
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         if (!RollWLogFile()) {
@@ -303,6 +375,9 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
                 entry.log_index(), last_log_offset, tid_, pid_);
         return true;
     }
+    if (index_writer_) {
+        index_writer_->Add(entry.log_index(), wh_->GetSize());
+    }
     std::string buffer;
     entry.SerializeToString(&buffer);
     ::openmldb::base::Slice slice(buffer.c_str(), buffer.size());
@@ -312,6 +387,9 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
         return false;
     }
     log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    if (appended) {
+        *appended = true;
+    }
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
     return true;
 }
@@ -353,6 +431,9 @@ int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& re
             PDLOG(WARNING, "init replicate node %s error", endpoint.c_str());
             return -1;
         }
+        if (tid == UINT32_MAX) {
+            replicate_node->SetSyncCallback([this] { OnFollowerAck(); });
+        }
         if (replicate_node->Start() != 0) {
             PDLOG(WARNING, "fail to start sync thread for table #tid %u, #pid %u", tid_, pid_);
             return -1;
@@ -443,6 +524,9 @@ bool LogReplicator::AppendEntry(LogEntry& entry, ::google::protobuf::Closure* do
     }
     uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
     entry.set_log_index(1 + cur_offset);
+    if (index_writer_) {
+        index_writer_->Add(entry.log_index(), wh_->GetSize());
+    }
     std::string buffer;
     entry.SerializeToString(&buffer);
     ::openmldb::base::Slice slice(buffer);
@@ -468,6 +552,7 @@ bool LogReplicator::RollWLogFile() {
         delete wh_;
         wh_ = NULL;
     }
+    index_writer_.reset();
     std::string name =
         ::openmldb::base::FormatToString(binlog_index_.load(std::memory_order_relaxed), FLAGS_binlog_name_length) +
         ".log";
@@ -482,9 +567,88 @@ bool LogReplicator::RollWLogFile() {
     binlog_index_.fetch_add(1, std::memory_order_relaxed);
     PDLOG(INFO, "roll write log for name %s and start offset %lld. tid %u pid %u", name.c_str(), offset, tid_, pid_);
     wh_ = new WriteHandle("off", name, fd);
+    index_writer_.reset(::openmldb::log::NewLogIndexWriter(full_path, ::openmldb::log::kBlockSize,
+                                                             FLAGS_binlog_index_interval));
     return true;
 }
 
+void LogReplicator::WaitForAck(uint64_t log_index, uint32_t ack_num, uint32_t timeout_ms,
+                               ::google::protobuf::Closure* done) {
+    bool has_follower = false;
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        has_follower = role_ == kLeaderNode && !local_endpoints_.empty();
+    }
+    if (ack_num == 0 || timeout_ms == 0 || !has_follower) {
+        done->Run();
+        return;
+    }
+    AckWaiter* waiter = new AckWaiter(log_index, ack_num, done);
+    {
+        std::lock_guard<bthread::Mutex> lock(ack_mu_);
+        // remove the waiters finished by timeout
+        auto it = ack_waiters_.begin();
+        while (it != ack_waiters_.end() && it->second->finished.load(std::memory_order_acquire)) {
+            it->second->Unref();
+            it = ack_waiters_.erase(it);
+        }
+        waiter->ref.fetch_add(1, std::memory_order_relaxed);
+        if (bthread_timer_add(&waiter->timer, butil::milliseconds_from_now(timeout_ms), OnAckTimeout, waiter) != 0) {
+            PDLOG(WARNING, "fail to add ack timer. tid %u pid %u", tid_, pid_);
+            waiter->Unref();
+            waiter->Finish();
+            waiter->Unref();
+            done->Run();
+            return;
+        }
+        ack_waiters_.emplace(log_index, waiter);
+    }
+    // the follower may have synced the entry before the waiter is added
+    OnFollowerAck();
+}
+
+void LogReplicator::OnFollowerAck() {
+    std::vector<uint64_t> offsets;
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        for (const auto& node : nodes_) {
+            if (std::find(local_endpoints_.begin(), local_endpoints_.end(), node->GetEndPoint()) !=
+                local_endpoints_.end()) {
+                offsets.push_back(node->GetLastSyncOffset());
+            }
+        }
+    }
+    if (offsets.empty()) {
+        return;
+    }
+    std::sort(offsets.begin(), offsets.end(), std::greater<uint64_t>());
+    std::vector<AckWaiter*> acked;
+    {
+        std::lock_guard<bthread::Mutex> lock(ack_mu_);
+        auto it = ack_waiters_.begin();
+        while (it != ack_waiters_.end() && it->first <= offsets[0]) {
+            AckWaiter* waiter = it->second;
+            // wait for all the followers if there are less than ack_num
+            size_t k = std::min(static_cast<size_t>(waiter->ack_num), offsets.size());
+            if (waiter->finished.load(std::memory_order_acquire) || offsets[k - 1] >= it->first) {
+                acked.push_back(waiter);
+                it = ack_waiters_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (AckWaiter* waiter : acked) {
+        if (waiter->Finish()) {
+            waiter->done->Run();
+        }
+        if (bthread_timer_del(waiter->timer) == 0) {
+            waiter->Unref();
+        }
+        waiter->Unref();
+    }
+}
+
 void LogReplicator::Notify() { cv_.notify_all(); }
 
 }  // namespace replica
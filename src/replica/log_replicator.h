@@ -22,6 +22,7 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,7 @@
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
 #include "common/thread_pool.h"
+#include "log/log_index.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
@@ -48,6 +50,8 @@ using ::openmldb::storage::Table;
 
 enum ReplicatorRole { kLeaderNode = 1, kFollowerNode };
 
+struct AckWaiter;
+
 class LogReplicator {
  public:
     LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
@@ -60,12 +64,28 @@ class LogReplicator {
 
     bool StartSyncing();
 
-    // the slave node receives master log entries
-    bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
+    // the slave node receives master log entries. appended is set to false if the entry has been logged before
+    bool ApplyEntry(const ::openmldb::api::LogEntry& entry, bool* appended = nullptr);
+
+    // held by the slave node while it applies a batch of entries, so that the batches of the partition are applied
+    // one by one and an entry resent by the master is applied once
+    std::mutex& GetApplyMutex() { return apply_mu_; }
+
+    // held shared by a writer from changing the table until the entry is appended to binlog, and held exclusively
+    // to pin the rows of the table which are consistent with the offset
+    std::shared_mutex& GetWriteMutex() { return write_mu_; }
 
     // the master node append entry
     bool AppendEntry(::openmldb::api::LogEntry& entry, ::google::protobuf::Closure* done = nullptr);  // NOLINT
 
+    // run done after ack_num followers have synced the entry of log_index. if they do not ack in
+    // timeout_ms, fall back to async replication and run done too. done is run immediately if
+    // there is no follower. it does not block the caller
+    void WaitForAck(uint64_t log_index, uint32_t ack_num, uint32_t timeout_ms, ::google::protobuf::Closure* done);
+
+    // called by ReplicateNode after entries have been synced to follower
+    void OnFollowerAck();
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -127,6 +147,8 @@ class LogReplicator {
     std::atomic<uint32_t> binlog_index_;
     LogParts* logs_;
     WriteHandle* wh_;
+    // sparse index of the binlog file being written
+    std::unique_ptr<::openmldb::log::LogIndexWriter> index_writer_;
     ReplicatorRole role_;
     std::map<std::string, std::string> real_ep_map_;
     std::vector<std::shared_ptr<ReplicateNode> > nodes_;
@@ -141,6 +163,12 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+    std::mutex apply_mu_;
+    std::shared_mutex write_mu_;
+
+    // the put requests waiting for followers ack, ordered by log index
+    bthread::Mutex ack_mu_;
+    std::multimap<uint64_t, AckWaiter*> ack_waiters_;
 };
 
 }  // namespace replica
@@ -732,6 +732,72 @@ TEST_F(LogReplicatorTest, Leader_Remove_local_follower) {
     }
 }
 
+class CountClosure : public ::google::protobuf::Closure {
+ public:
+    void Run() override { cnt_.fetch_add(1); }
+    int GetCount() { return cnt_.load(); }
+
+ private:
+    std::atomic<int> cnt_{0};
+};
+
+TEST_F(LogReplicatorTest, WaitForAck) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 3, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(3, 1, folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    ::openmldb::api::LogEntry entry;
+    ::openmldb::test::AddDimension(0, "test_pk", &entry);
+    entry.set_value(::openmldb::test::EncodeKV("test_pk", "value1"));
+    entry.set_ts(9527);
+    ASSERT_TRUE(leader.AppendEntry(entry));
+    {
+        // no follower
+        CountClosure closure;
+        leader.WaitForAck(entry.log_index(), 1, 1000, &closure);
+        ASSERT_EQ(1, closure.GetCount());
+    }
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair("127.0.0.1:18531", ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    {
+        // the follower is not started, fall back to async after timeout
+        CountClosure closure;
+        ASSERT_TRUE(leader.AppendEntry(entry));
+        leader.WaitForAck(entry.log_index(), 1, 200, &closure);
+        ASSERT_EQ(0, closure.GetCount());
+        sleep(1);
+        ASSERT_EQ(1, closure.GetCount());
+    }
+    brpc::ServerOptions options;
+    brpc::Server server;
+    {
+        std::string follower_folder = "/tmp/" + GenRand() + "/";
+        MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, follower_folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start("127.0.0.1:18531", &options));
+    }
+    {
+        // acked by the follower before timeout
+        CountClosure closure;
+        ASSERT_TRUE(leader.AppendEntry(entry));
+        leader.Notify();
+        leader.WaitForAck(entry.log_index(), 1, 60000, &closure);
+        for (int i = 0; i < 100 && closure.GetCount() == 0; i++) {
+            usleep(100000);
+        }
+        ASSERT_EQ(1, closure.GetCount());
+    }
+    leader.DelAllReplicateNode();
+    server.Stop(10000);
+    server.Join();
+}
+
 }  // namespace replica
 }  // namespace openmldb
 
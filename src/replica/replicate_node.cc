@@ -17,6 +17,7 @@
 #include "replica/replicate_node.h"
 
 #include <gflags/gflags.h>
+#include <snappy.h>
 
 #include <algorithm>
 
@@ -24,6 +25,8 @@
 #include "base/strings.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_string(binlog_sync_compress_type);
+DECLARE_uint32(binlog_sync_compress_min_size);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -66,7 +69,8 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      compress_type_(::openmldb::type::CompressType::kNoCompress) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -157,6 +161,9 @@ int ReplicateNode::MatchLogOffsetFromNode() {
     request.set_pid(pid_);
     request.set_term(term_->load(std::memory_order_relaxed));
     request.set_pre_log_index(0);
+    if (FLAGS_binlog_sync_compress_type == "snappy") {
+        request.set_compress_type(::openmldb::type::CompressType::kSnappy);
+    }
     ::openmldb::api::AppendEntriesResponse response;
     bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
                                        FLAGS_request_timeout_ms, FLAGS_request_max_retry);
@@ -164,8 +171,10 @@ int ReplicateNode::MatchLogOffsetFromNode() {
         last_sync_offset_ = response.log_offset();
         log_matched_ = true;
         log_reader_.SetOffset(last_sync_offset_);
-        PDLOG(INFO, "match node %s log offset %lu for table tid %u pid %u", endpoint_.c_str(), last_sync_offset_, tid_,
-              pid_);
+        // the follower of old version does not set compress_type, so entries will be sent without compression
+        compress_type_ = response.compress_type();
+        PDLOG(INFO, "match node %s log offset %lu compress type %s for table tid %u pid %u", endpoint_.c_str(),
+              last_sync_offset_, ::openmldb::type::CompressType_Name(compress_type_).c_str(), tid_, pid_);
         return 0;
     }
     PDLOG(WARNING, "match node %s log offset failed. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
@@ -183,6 +192,7 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     uint64_t sync_log_offset = last_sync_offset_;
     bool request_from_cache = false;
     bool need_wait = false;
+    uint64_t raw_size = 0;
     if (cache_.size() > 0) {
         request_from_cache = true;
         request = cache_[0];
@@ -199,6 +209,9 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         }
         PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
         sync_log_offset = entry.log_index();
+        for (const auto& cached_entry : request.entries()) {
+            raw_size += cached_entry.ByteSizeLong();
+        }
     } else {
         request.set_tid(tid_);
         request.set_pid(pid_);
@@ -244,6 +257,7 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
                     break;
                 }
                 sync_log_offset = entry->log_index();
+                raw_size += record.size();
             } else if (status.IsWaitRecord()) {
                 DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
                 need_wait = true;
@@ -270,8 +284,14 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
         }
     }
     if (request.entries_size() > 0) {
-        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
-                                           FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+        // compress in the sync bthread of this node, so the rpc threads of leader are not involved
+        ::openmldb::api::AppendEntriesRequest compressed_request;
+        const ::openmldb::api::AppendEntriesRequest* wire_request = &request;
+        if (CompressEntries(request, raw_size, &compressed_request)) {
+            wire_request = &compressed_request;
+        }
+        bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, wire_request,
+                                           &response, FLAGS_request_timeout_ms, FLAGS_request_max_retry);
         if (ret && response.code() == 0) {
             DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
             last_sync_offset_ = sync_log_offset;
@@ -282,6 +302,9 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             if (request_from_cache) {
                 cache_.clear();
             }
+            if (sync_callback_) {
+                sync_callback_();
+            }
         } else {
             if (!request_from_cache) {
                 cache_.push_back(request);
@@ -296,6 +319,37 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     return 0;
 }
 
+bool ReplicateNode::CompressEntries(const ::openmldb::api::AppendEntriesRequest& request, uint64_t raw_size,
+                                    ::openmldb::api::AppendEntriesRequest* wire_request) {
+    if (compress_type_ != ::openmldb::type::CompressType::kSnappy || raw_size < FLAGS_binlog_sync_compress_min_size) {
+        return false;
+    }
+    ::openmldb::api::LogEntryBatch batch;
+    batch.mutable_entries()->CopyFrom(request.entries());
+    std::string raw;
+    if (!batch.SerializeToString(&raw)) {
+        PDLOG(WARNING, "fail to serialize entries. tid %u pid %u", tid_, pid_);
+        return false;
+    }
+    std::string compressed;
+    ::snappy::Compress(raw.data(), raw.size(), &compressed);
+    // skip the data which is hard to compress, e.g. the value has been compressed by table
+    if (compressed.size() >= raw.size() * 9 / 10) {
+        DEBUGLOG("compress ratio is too low, send raw entries. raw %lu compressed %lu", raw.size(),
+                 compressed.size());
+        return false;
+    }
+    wire_request->set_tid(request.tid());
+    wire_request->set_pid(request.pid());
+    wire_request->set_pre_log_index(request.pre_log_index());
+    if (request.has_term()) {
+        wire_request->set_term(request.term());
+    }
+    wire_request->set_compress_type(::openmldb::type::CompressType::kSnappy);
+    wire_request->set_compressed_entries(std::move(compressed));
+    return true;
+}
+
 void ReplicateNode::Stop() {
     is_running_.store(false, std::memory_order_relaxed);
     if (worker_ == 0) {
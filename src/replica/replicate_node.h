@@ -18,6 +18,7 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -65,6 +66,9 @@ class ReplicateNode {
 
     void Stop();
 
+    // set before Start. it is called after entries have been synced to the node
+    void SetSyncCallback(std::function<void()> callback) { sync_callback_ = std::move(callback); }
+
     ReplicateNode(const ReplicateNode&) = delete;
 
     ReplicateNode& operator=(const ReplicateNode&) = delete;
@@ -72,6 +76,11 @@ class ReplicateNode {
  private:
     int MatchLogOffsetFromNode();
 
+    // compress the entries of request into wire_request as a whole batch. return false if the batch
+    // is not worth compressing and the raw request should be sent
+    bool CompressEntries(const ::openmldb::api::AppendEntriesRequest& request, uint64_t raw_size,
+                         ::openmldb::api::AppendEntriesRequest* wire_request);
+
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
@@ -90,6 +99,9 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    // compress type negotiated with follower in MatchLogOffsetFromNode
+    ::openmldb::type::CompressType compress_type_;
+    std::function<void()> sync_callback_;
 };
 
 }  // namespace replica
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// put throughput of async, semi-sync and sync replication in a mini cluster with 3 tablets
+
+#include <gflags/gflags.h>
+
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "sdk/mini_cluster.h"
+#include "sdk/sql_router.h"
+#include "test/util.h"
+
+DECLARE_bool(enable_distsql);
+DECLARE_bool(binlog_notify_on_put);
+DECLARE_uint32(binlog_semi_sync_ack_num);
+DECLARE_uint32(binlog_semi_sync_timeout_ms);
+
+::openmldb::sdk::MiniCluster* mc;
+std::shared_ptr<::openmldb::sdk::SQLRouter> router;
+const char* DB = "replication_bm";
+
+enum ReplicationMode { kAsync = 0, kSemiSync = 1, kSync = 2 };
+
+static void BM_Put(benchmark::State& state) {  // NOLINT
+    auto mode = static_cast<ReplicationMode>(state.range(0));
+    switch (mode) {
+        case kAsync:
+            FLAGS_binlog_semi_sync_ack_num = 0;
+            break;
+        case kSemiSync:
+            FLAGS_binlog_semi_sync_ack_num = 1;
+            FLAGS_binlog_semi_sync_timeout_ms = 10;
+            break;
+        case kSync:
+            // wait for all the followers, and never fall back in the benchmark
+            FLAGS_binlog_semi_sync_ack_num = 2;
+            FLAGS_binlog_semi_sync_timeout_ms = 60000;
+            break;
+    }
+    std::string table = "t" + std::to_string(state.range(0));
+    hybridse::sdk::Status status;
+    router->ExecuteDDL(DB,
+                       "create table " + table +
+                           " (c1 string, c2 bigint, c3 string, index(key=c1, ts=c2)) "
+                           "options(partitionnum=1, replicanum=3);",
+                       &status);
+    if (!status.IsOK()) {
+        state.SkipWithError(status.ToString().c_str());
+        return;
+    }
+    router->RefreshCatalog();
+    std::string value(100, 'a');
+    int64_t cnt = 0;
+    for (auto _ : state) {
+        std::string sql = "insert into " + table + " values ('key" + std::to_string(cnt % 1000) + "', " +
+                          std::to_string(cnt) + ", '" + value + "');";
+        if (!router->ExecuteInsert(DB, sql, &status)) {
+            state.SkipWithError(status.ToString().c_str());
+            break;
+        }
+        cnt++;
+    }
+    state.SetItemsProcessed(cnt);
+    router->ExecuteDDL(DB, "drop table " + table + ";", &status);
+}
+
+BENCHMARK(BM_Put)->ArgNames({"mode"})->Arg(kAsync)->Arg(kSemiSync)->Arg(kSync)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv) {
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    ::openmldb::base::SetupGlog(true);
+    ::hybridse::vm::Engine::InitializeGlobalLLVM();
+    ::openmldb::test::InitRandomDiskFlags("mini_cluster_replication_bm");
+    FLAGS_enable_distsql = true;
+    FLAGS_binlog_notify_on_put = true;
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::openmldb::sdk::MiniCluster mini_cluster(6181);
+    mc = &mini_cluster;
+    if (!mini_cluster.SetUp(3)) {
+        return 1;
+    }
+    sleep(2);
+    ::openmldb::sdk::SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc->GetZkCluster();
+    sql_opt.zk_path = mc->GetZkPath();
+    router = ::openmldb::sdk::NewClusterSQLRouter(sql_opt);
+    if (!router) {
+        return 1;
+    }
+    hybridse::sdk::Status status;
+    router->CreateDB(DB, &status);
+    ::benchmark::RunSpecifiedBenchmarks();
+    router->DropDB(DB, &status);
+    router.reset();
+    mini_cluster.Close();
+}
@@ -30,14 +30,32 @@ absl::Status DeploymentMetricCollector::Collect(const std::string& db, const std
     return absl::OkStatus();
 }
 
+absl::Status DeploymentMetricCollector::CollectResultCache(const std::string& db, const std::string& deploy_name,
+                                                           bool hit) {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = md_cache_counter_->get_stats({db, deploy_name, hit ? "hit" : "miss"});
+    if (it == nullptr) {
+        LOG(WARNING) << "reach limit size, collect failed";
+        return absl::OutOfRangeError("multi-dimensional counter reaches limit size, please delete old deploy");
+    }
+    *it << 1;
+    return absl::OkStatus();
+}
+
 absl::Status DeploymentMetricCollector::DeleteDeploy(const std::string& db, const std::string& deploy_name) {
     absl::ReaderMutexLock lock(&mutex_);
     md_recorder_->delete_stats({db, deploy_name});
+    md_cache_counter_->delete_stats({db, deploy_name, "hit"});
+    md_cache_counter_->delete_stats({db, deploy_name, "miss"});
     return absl::OkStatus();
 }
 
 void DeploymentMetricCollector::Reset() {
     absl::WriterMutexLock lock(&mutex_);
+    // hide the old variables first, otherwise the new ones can't be exposed with the same names
+    md_recorder_.reset();
+    md_cache_counter_.reset();
     md_recorder_ = make_shared(prefix_);
+    md_cache_counter_ = make_cache_counter(prefix_);
 }
 }  // namespace openmldb::statistics
@@ -33,7 +33,9 @@ namespace openmldb::statistics {
 class DeploymentMetricCollector {
  public:
     typedef typename bvar::MultiDimension<bvar::LatencyRecorder> MDRecorder;
-    explicit DeploymentMetricCollector(const std::string& prefix) : prefix_(prefix), md_recorder_(make_shared(prefix)) {
+    typedef typename bvar::MultiDimension<bvar::Adder<int64_t>> MDCounter;
+    explicit DeploymentMetricCollector(const std::string& prefix)
+        : prefix_(prefix), md_recorder_(make_shared(prefix)), md_cache_counter_(make_cache_counter(prefix)) {
         // already expose_as when MultiDimension ctor
     }
     // collector is not copyable
@@ -43,6 +45,9 @@ class DeploymentMetricCollector {
     // <db>.<deploy_name>
     absl::Status Collect(const std::string& db, const std::string& deploy_name, absl::Duration time)
         LOCKS_EXCLUDED(mutex_);
+    // count the hits and misses of the result cache, labeled by <db>.<deploy_name>.<hit|miss>
+    absl::Status CollectResultCache(const std::string& db, const std::string& deploy_name, bool hit)
+        LOCKS_EXCLUDED(mutex_);
     absl::Status DeleteDeploy(const std::string& db, const std::string& deploy_name) LOCKS_EXCLUDED(mutex_);
     void Reset() LOCKS_EXCLUDED(mutex_);
 
@@ -70,11 +75,17 @@ class DeploymentMetricCollector {
         return std::make_shared<MDRecorder>(prefix, "deployment", labels);
     }
 
+    static std::shared_ptr<MDCounter> make_cache_counter(const std::string& prefix) {
+        MDCounter::key_type labels = {"db", "deployment", "result"};
+        return std::make_shared<MDCounter>(prefix, "deployment_result_cache", labels);
+    }
+
  private:
     std::string prefix_;  // for reset
     // not copyable and can't clear, so use ptr
     // MultiDimension can't define recorder window size by yourself, bvar_dump_interval is the only way
     std::shared_ptr<MDRecorder> md_recorder_ GUARDED_BY(mutex_);
+    std::shared_ptr<MDCounter> md_cache_counter_ GUARDED_BY(mutex_);
     mutable absl::Mutex mutex_;  // protects collectors_
 };
 }  // namespace openmldb::statistics
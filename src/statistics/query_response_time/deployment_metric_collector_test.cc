@@ -123,6 +123,23 @@ TEST_F(CollectorTest, MemoryTest) {
     test(1, 20002, 1, true);
 }
 
+TEST_F(CollectorTest, ResultCacheTest) {
+    DeploymentMetricCollector collector("cache_test");
+    auto stats_count = []() {
+        auto desc = bvar::Variable::describe_exposed("cache_test_deployment_result_cache");
+        auto pos = desc.find("\"stats_count\" : ");
+        return pos == std::string::npos ? -1 : std::stoi(desc.substr(pos + 16));
+    };
+    ASSERT_TRUE(collector.CollectResultCache("db0", "d0", true).ok());
+    ASSERT_TRUE(collector.CollectResultCache("db0", "d0", false).ok());
+    ASSERT_TRUE(collector.CollectResultCache("db0", "d1", false).ok());
+    ASSERT_EQ(3, stats_count());
+    ASSERT_TRUE(collector.DeleteDeploy("db0", "d0").ok());
+    ASSERT_EQ(1, stats_count());
+    collector.Reset();
+    ASSERT_EQ(0, stats_count());
+}
+
 }  // namespace statistics
 }  // namespace openmldb
 
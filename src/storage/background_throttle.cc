@@ -0,0 +1,68 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/background_throttle.h"
+
+#include <chrono>  // NOLINT
+#include <utility>
+
+namespace openmldb {
+namespace storage {
+
+// the busy time reported at a time. the sleep for a slice is below the max throttle time of the governor even if the
+// background work gets 5% of the cpu
+constexpr uint64_t THROTTLE_SLICE_US = 20 * 1000;
+
+static thread_local BackgroundThrottle* current_throttle = nullptr;
+
+static uint64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+BackgroundThrottle::BackgroundThrottle(ThrottleFn throttle_fn)
+    : throttle_fn_(std::move(throttle_fn)), last_time_us_(NowMicros()), prev_(current_throttle) {
+    current_throttle = this;
+}
+
+BackgroundThrottle::~BackgroundThrottle() {
+    current_throttle = prev_;
+    Report();
+}
+
+void BackgroundThrottle::Check() {
+    auto throttle = current_throttle;
+    if (throttle != nullptr && NowMicros() - throttle->last_time_us_ >= THROTTLE_SLICE_US) {
+        throttle->Report();
+    }
+}
+
+BackgroundThrottle::ThrottleFn BackgroundThrottle::GetCurrentFn() {
+    return current_throttle == nullptr ? ThrottleFn() : current_throttle->throttle_fn_;
+}
+
+void BackgroundThrottle::Report() {
+    uint64_t busy_us = NowMicros() - last_time_us_;
+    if (throttle_fn_) {
+        throttle_fn_(busy_us);
+    }
+    // the time blocked in throttle_fn is not busy time
+    last_time_us_ = NowMicros();
+}
+
+}  // namespace storage
+}  // namespace openmldb
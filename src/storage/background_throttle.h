@@ -0,0 +1,56 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_BACKGROUND_THROTTLE_H_
+#define SRC_STORAGE_BACKGROUND_THROTTLE_H_
+
+#include <stdint.h>
+
+#include <functional>
+
+namespace openmldb {
+namespace storage {
+
+// BackgroundThrottle throttles a long background task while it runs instead of after it finishes. The tablet installs
+// it on the thread running the task, e.g. gc and making snapshot, and the loops of the task call Check. The busy time
+// since the last report is passed to throttle_fn once it exceeds a slice, throttle_fn blocks to keep the cpu share of
+// the background work. Check does nothing if no BackgroundThrottle is installed on the thread
+class BackgroundThrottle {
+ public:
+    using ThrottleFn = std::function<void(uint64_t busy_us)>;
+
+    explicit BackgroundThrottle(ThrottleFn throttle_fn);
+    // report the busy time left
+    ~BackgroundThrottle();
+    BackgroundThrottle(const BackgroundThrottle&) = delete;
+    BackgroundThrottle& operator=(const BackgroundThrottle&) = delete;
+
+    static void Check();
+    // the throttle_fn installed on the thread, empty if there is none. the workers of the task install it too
+    static ThrottleFn GetCurrentFn();
+
+ private:
+    void Report();
+
+    ThrottleFn throttle_fn_;
+    uint64_t last_time_us_;
+    // the throttle installed before, it's installed again when this one is destroyed
+    BackgroundThrottle* prev_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_BACKGROUND_THROTTLE_H_
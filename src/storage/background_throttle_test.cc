@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/background_throttle.h"
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace storage {
+
+class BackgroundThrottleTest : public ::testing::Test {};
+
+void BusyFor(std::chrono::milliseconds time) {
+    auto end = std::chrono::steady_clock::now() + time;
+    while (std::chrono::steady_clock::now() < end) {
+        BackgroundThrottle::Check();
+    }
+}
+
+TEST_F(BackgroundThrottleTest, ReportInSlices) {
+    // no throttle is installed
+    BackgroundThrottle::Check();
+    ASSERT_FALSE(BackgroundThrottle::GetCurrentFn());
+    uint32_t report_cnt = 0;
+    uint64_t total_busy_us = 0;
+    {
+        BackgroundThrottle throttle([&](uint64_t busy_us) {
+            report_cnt++;
+            total_busy_us += busy_us;
+            // the sleep is not counted as busy time
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        ASSERT_TRUE(BackgroundThrottle::GetCurrentFn());
+        BusyFor(std::chrono::milliseconds(100));
+        ASSERT_GE(report_cnt, 2u);
+    }
+    ASSERT_FALSE(BackgroundThrottle::GetCurrentFn());
+    // the busy loop takes 100ms of wall time, including the sleeps which are not reported
+    ASSERT_GE(total_busy_us, 40u * 1000);
+    ASSERT_LT(total_busy_us, 100u * 1000);
+}
+
+TEST_F(BackgroundThrottleTest, Nested) {
+    uint32_t outer_cnt = 0;
+    uint32_t inner_cnt = 0;
+    BackgroundThrottle outer([&](uint64_t) { outer_cnt++; });
+    {
+        BackgroundThrottle inner([&](uint64_t) { inner_cnt++; });
+        BusyFor(std::chrono::milliseconds(50));
+    }
+    ASSERT_GT(inner_cnt, 0u);
+    ASSERT_EQ(0u, outer_cnt);
+    BusyFor(std::chrono::milliseconds(50));
+    ASSERT_GT(outer_cnt, 0u);
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::openmldb::base::SetLogLevel(INFO);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
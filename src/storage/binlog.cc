@@ -104,6 +104,8 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
         }
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             table->Delete(entry);
+        } else if (table->IsExpireOnRecover(entry)) {
+            DEBUGLOG("offset %lu has expired", entry.log_index());
         } else {
             table->Put(entry);
         }
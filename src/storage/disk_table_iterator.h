@@ -72,6 +72,7 @@ class DiskTableTraverseIterator : public TraverseIterator {
     void SeekToFirst() override;
     void Seek(const std::string& pk, uint64_t time) override;
     uint64_t GetCount() const override;
+    void ResetCount() override { traverse_cnt_ = 0; }
 
  private:
     bool IsExpired();
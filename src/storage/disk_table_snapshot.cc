@@ -140,7 +140,7 @@ bool DiskTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_o
 base::Status DiskTableSnapshot::ExtractIndexData(const std::shared_ptr<Table>& table,
             const std::vector<::openmldb::common::ColumnKey>& add_indexs,
             const std::vector<std::shared_ptr<::openmldb::log::WriteHandle>>& whs,
-            uint64_t offset, bool dump_data) {
+            uint64_t offset, bool dump_data, const std::function<void(uint64_t)>& progress) {
     uint32_t pid = table->GetPid();
     schema::TableIndexInfo table_index_info(*(table->GetTableMeta()), add_indexs);
     if (!table_index_info.Init()) {
@@ -152,9 +152,13 @@ base::Status DiskTableSnapshot::ExtractIndexData(const std::shared_ptr<Table>& t
         return {-1, "fail to get iterator"};
     }
     it->SeekToFirst();
+    uint64_t read_cnt = 0;
     while (it->Valid()) {
         auto data = it->GetValue();
         uint64_t ts = it->GetKey();
+        if (progress && ++read_cnt % 1000000 == 0) {
+            progress(read_cnt);
+        }
         std::vector<std::string> index_row;
         auto staus = DecodeData(table, data, table_index_info.GetAllIndexCols(), &index_row);
         std::map<uint32_t, std::vector<::openmldb::api::Dimension>> dimension_map;
@@ -208,6 +212,9 @@ base::Status DiskTableSnapshot::ExtractIndexData(const std::shared_ptr<Table>& t
         }
         it->Next();
     }
+    if (progress) {
+        progress(read_cnt);
+    }
     return {};
 }
 
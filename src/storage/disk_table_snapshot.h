@@ -40,7 +40,7 @@ class DiskTableSnapshot : public Snapshot {
     base::Status ExtractIndexData(const std::shared_ptr<Table>& table,
             const std::vector<::openmldb::common::ColumnKey>& add_indexs,
             const std::vector<std::shared_ptr<::openmldb::log::WriteHandle>>& whs,
-            uint64_t offset, bool dump_data) override;
+            uint64_t offset, bool dump_data, const std::function<void(uint64_t)>& progress) override;
 
  private:
     std::string db_root_path_;
@@ -52,6 +52,9 @@ class IndexOrganizedTable : public MemTable {
     }
     bool AddIndexToTable(const std::shared_ptr<IndexDef>& index_def) override;
 
+    // the rows of secondary indexes refer to the clustered index, so they are not skipped when recovering
+    void BeginRecover() override {}
+
     void SchedGCByDelete(const std::shared_ptr<sdk::SQLRouter>& router);
 
  private:
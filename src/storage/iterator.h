@@ -39,6 +39,8 @@ class TableIterator {
     virtual void Seek(const std::string& pk, uint64_t time) {}
     virtual void Seek(uint64_t time) {}
     virtual uint64_t GetCount() const { return 0; }
+    // restart the count of the traversed records, it's used when the iterator is reused by the next request
+    virtual void ResetCount() {}
 };
 
 class TraverseIterator : public TableIterator {
@@ -27,8 +27,12 @@ namespace storage {
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // the data refers to the pages of a mapped image, it's not freed with the block
+    bool mapped = false;
     uint32_t size;
     char* data;
+    // the order the row is put to the memory table in, 0 if it's not put by MemTable::Put. see MemTable::GetPutSeq
+    uint64_t seq = 0;
 
     DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(nullptr) {
         data = new char[len];
@@ -46,7 +50,9 @@ struct DataBlock {
     }
 
     ~DataBlock() {
-        delete[] data;
+        if (!mapped) {
+            delete[] data;
+        }
         data = nullptr;
     }
 
@@ -19,14 +19,18 @@
 #include <snappy.h>
 
 #include <algorithm>
+#include <tuple>
 #include <utility>
 
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "base/slice.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "schema/index_util.h"
+#include "storage/background_throttle.h"
 #include "storage/mem_table_iterator.h"
 #include "storage/record.h"
 
@@ -40,6 +44,7 @@ namespace openmldb {
 namespace storage {
 
 static const uint32_t SEED = 0xe17a1465;
+static const uint32_t DUMP_ROWS_BATCH = 10000;
 
 MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t seg_cnt,
                    const std::map<std::string, uint32_t>& mapping, uint64_t ttl, ::openmldb::type::TTLType ttl_type)
@@ -219,7 +224,8 @@ absl::Status MemTable::Put(uint64_t time, const std::string& value, const Dimens
     if (ts_value_map.empty()) {
         return absl::InvalidArgumentError(absl::StrCat(id_, ".", pid_, ": empty ts value map"));
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    // <segment, key, ts map> of the inner indexes the row is put to
+    std::vector<std::tuple<Segment*, Slice, const std::map<int32_t, uint64_t>*>> puts;
     for (const auto& kv : inner_index_key_map) {
         auto iter = ts_value_map.find(kv.first);
         if (iter == ts_value_map.end()) {
@@ -229,11 +235,22 @@ absl::Status MemTable::Put(uint64_t time, const std::string& value, const Dimens
         if (seg_cnt_ > 1) {
             seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
         }
-        Segment* segment = segments_[kv.first][seg_idx];
-        if (!segment->Put(kv.second, iter->second, block, put_if_absent)) {
-            return absl::AlreadyExistsError("data exists");  // let caller know exists
+        puts.emplace_back(segments_[kv.first][seg_idx], kv.second, &iter->second);
+    }
+    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    if (put_if_absent) {
+        // check all the segments before putting, so the row is put to all of them or none of them
+        for (const auto& [segment, key, ts_map] : puts) {
+            if (segment->Contains(key, *ts_map, block)) {
+                delete block;
+                return absl::AlreadyExistsError("data exists");  // let caller know exists
+            }
         }
     }
+    block->seq = put_seq_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    for (const auto& [segment, key, ts_map] : puts) {
+        segment->Put(key, *ts_map, block);
+    }
     record_byte_size_.fetch_add(GetRecordSize(value.length()));
     return absl::OkStatus();
 }
@@ -316,6 +333,16 @@ uint64_t MemTable::Release() {
 }
 
 void MemTable::SchedGc() {
+    std::unique_lock<std::mutex> gc_lock(gc_mu_, std::try_to_lock);
+    if (!gc_lock.owns_lock()) {
+        gc_pending_.store(true);
+        // the dump may have finished before the flag is set
+        if (!gc_lock.try_lock()) {
+            PDLOG(INFO, "table is dumping image or making gc, run this gc after it. tid %u, pid %u", id_, pid_);
+            return;
+        }
+        gc_pending_.store(false);
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     PDLOG(INFO, "start making gc for table %s, tid %u, pid %u", name_.c_str(), id_, pid_);
     auto inner_indexs = table_index_.GetAllInnerIndex();
@@ -369,6 +396,7 @@ void MemTable::SchedGc() {
             continue;
         }
         for (uint32_t j = 0; j < seg_cnt_; j++) {
+            BackgroundThrottle::Check();
             uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
             Segment* segment = segments_[i][j];
             StatisticsInfo statistics_info(segment->GetTsCnt());
@@ -417,10 +445,8 @@ bool MemTable::CheckLatest(uint32_t index_id, const std::string& key, uint64_t t
 
 inline bool MemTable::CheckAbsolute(const TTLSt& ttl_st, uint64_t ts) { return ts < GetExpireTime(ttl_st); }
 
-bool MemTable::IsExpire(const LogEntry& entry) {
-    if (!enable_gc_.load(std::memory_order_relaxed)) {
-        return false;
-    }
+template <typename F>
+bool MemTable::CheckExpire(const LogEntry& entry, F&& check) {
     std::map<int32_t, std::string> inner_index_key_map;
     if (entry.dimensions_size() > 0) {
         for (auto iter = entry.dimensions().begin(); iter != entry.dimensions().end(); iter++) {
@@ -457,11 +483,9 @@ bool MemTable::IsExpire(const LogEntry& entry) {
             if (!index_def || !index_def->IsReady()) {
                 continue;
             }
-            auto ttl = index_def->GetTTL();
-            if (!ttl->NeedGc()) {
+            if (!index_def->GetTTL()->NeedGc()) {
                 return false;
             }
-            TTLType ttl_type = index_def->GetTTLType();
             int64_t ts = entry.ts();
             auto ts_col = index_def->GetTsColumn();
             if (ts_col && !ts_col->IsAutoGenTs()) {
@@ -469,25 +493,7 @@ bool MemTable::IsExpire(const LogEntry& entry) {
                     continue;
                 }
             }
-            bool is_expire = false;
-            uint32_t index_id = index_def->GetId();
-            switch (ttl_type) {
-                case ::openmldb::storage::TTLType::kLatestTime:
-                    is_expire = CheckLatest(index_id, kv.second, ts);
-                    break;
-                case ::openmldb::storage::TTLType::kAbsoluteTime:
-                    is_expire = CheckAbsolute(*ttl, ts);
-                    break;
-                case ::openmldb::storage::TTLType::kAbsOrLat:
-                    is_expire = CheckAbsolute(*ttl, ts) || CheckLatest(index_id, kv.second, ts);
-                    break;
-                case ::openmldb::storage::TTLType::kAbsAndLat:
-                    is_expire = CheckAbsolute(*ttl, ts) && CheckLatest(index_id, kv.second, ts);
-                    break;
-                default:
-                    return true;
-            }
-            if (!is_expire) {
+            if (!check(*index_def, kv.second, ts)) {
                 return false;
             }
         }
@@ -495,6 +501,72 @@ bool MemTable::IsExpire(const LogEntry& entry) {
     return true;
 }
 
+bool MemTable::IsExpire(const LogEntry& entry) {
+    if (!enable_gc_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    return CheckExpire(entry, [this](const IndexDef& index_def, const std::string& key, uint64_t ts) {
+        auto ttl = index_def.GetTTL();
+        uint32_t index_id = index_def.GetId();
+        switch (index_def.GetTTLType()) {
+            case ::openmldb::storage::TTLType::kLatestTime:
+                return CheckLatest(index_id, key, ts);
+            case ::openmldb::storage::TTLType::kAbsoluteTime:
+                return CheckAbsolute(*ttl, ts);
+            case ::openmldb::storage::TTLType::kAbsOrLat:
+                return CheckAbsolute(*ttl, ts) || CheckLatest(index_id, key, ts);
+            case ::openmldb::storage::TTLType::kAbsAndLat:
+                return CheckAbsolute(*ttl, ts) && CheckLatest(index_id, key, ts);
+            default:
+                return true;
+        }
+    });
+}
+
+void MemTable::BeginRecover() {
+    std::vector<uint64_t> expire_time;
+    for (const auto& index_def : table_index_.GetAllIndex()) {
+        if (!index_def) {
+            continue;
+        }
+        if (index_def->GetId() >= expire_time.size()) {
+            expire_time.resize(index_def->GetId() + 1, 0);
+        }
+        expire_time[index_def->GetId()] = GetExpireTime(*index_def->GetTTL());
+    }
+    recover_expire_time_.swap(expire_time);
+    recover_expired_cnt_.store(0, std::memory_order_relaxed);
+    recovering_.store(true, std::memory_order_release);
+}
+
+void MemTable::EndRecover() {
+    if (recovering_.exchange(false, std::memory_order_acq_rel)) {
+        PDLOG(INFO, "skip %lu expired rows when recovering. tid %u pid %u",
+              recover_expired_cnt_.load(std::memory_order_relaxed), id_, pid_);
+    }
+}
+
+bool MemTable::IsExpireOnRecover(const LogEntry& entry) {
+    if (!recovering_.load(std::memory_order_acquire) || !enable_gc_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    bool is_expire = CheckExpire(entry, [this](const IndexDef& index_def, const std::string& key, uint64_t ts) {
+        uint32_t index_id = index_def.GetId();
+        uint64_t expire_time = index_id < recover_expire_time_.size() ? recover_expire_time_[index_id] : 0;
+        switch (index_def.GetTTLType()) {
+            case ::openmldb::storage::TTLType::kAbsoluteTime:
+            case ::openmldb::storage::TTLType::kAbsOrLat:
+                return ts < expire_time;
+            default:
+                return false;
+        }
+    });
+    if (is_expire) {
+        recover_expired_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return is_expire;
+}
+
 int MemTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count) {
     std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
     if (index_def && !index_def->IsReady()) {
@@ -779,5 +851,188 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
     return true;
 }
 
+bool MemTable::DumpImage(uint64_t offset, const MemTableView& view, MemTableImageWriter* writer) {
+    // run the gc round skipped during the dump after the lock is released
+    absl::Cleanup pending_gc = [this] {
+        if (gc_pending_.exchange(false)) {
+            SchedGc();
+        }
+    };
+    std::lock_guard<std::mutex> gc_lock(gc_mu_);
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    std::vector<uint32_t> ts_cnt_vec;
+    for (uint32_t i = 0; i < inner_indexs->size(); i++) {
+        if (segments_[i] == nullptr) {
+            PDLOG(WARNING, "segments of inner index %u is null. tid %u pid %u", i, id_, pid_);
+            return false;
+        }
+        ts_cnt_vec.push_back(segments_[i][0]->GetTsCnt());
+    }
+    writer->WriteHeader(offset, seg_cnt_, ts_cnt_vec);
+    for (uint32_t i = 0; i < ts_cnt_vec.size(); i++) {
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            // flush out of the lock of segment
+            std::optional<std::string> last_key;
+            while (segments_[i][j]->DumpImage(writer, view.put_seq, kImageBlockSize, &last_key)) {
+                if (!writer->Flush()) {
+                    return false;
+                }
+                BackgroundThrottle::Check();
+            }
+            writer->WriteEndSegment();
+            if (!writer->Flush()) {
+                return false;
+            }
+        }
+    }
+    return writer->Finish();
+}
+
+bool MemTable::DumpRows(const MemTableView& view, uint64_t max_pending,
+                        const std::function<bool(::openmldb::api::LogEntry* entry)>& fn) {
+    // run the gc round skipped during the dump after the lock is released
+    absl::Cleanup pending_gc = [this] {
+        if (gc_pending_.exchange(false)) {
+            SchedGc();
+        }
+    };
+    std::lock_guard<std::mutex> gc_lock(gc_mu_);
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    // the rows in several time lists which have not been visited in all of them. <row, <entry, visited count>>
+    absl::flat_hash_map<DataBlock*, std::pair<::openmldb::api::LogEntry, uint32_t>> shared_rows;
+    std::vector<::openmldb::api::LogEntry> entries;
+    for (uint32_t i = 0; i < inner_indexs->size(); i++) {
+        if (segments_[i] == nullptr) {
+            continue;
+        }
+        Segment* first_segment = segments_[i][0];
+        // the time lists of the indexes not ready have no reference of rows
+        std::vector<bool> ready_pos(first_segment->GetTsCnt(), false);
+        std::optional<uint32_t> dim_idx;
+        std::optional<uint32_t> auto_gen_pos;
+        for (const auto& index_def : inner_indexs->at(i)->GetIndex()) {
+            auto ts_col = index_def->GetTsColumn();
+            if (!index_def->IsReady() || !ts_col) {
+                continue;
+            }
+            uint32_t pos = 0;
+            if (first_segment->GetTsCnt() > 1 && first_segment->GetTsIdx(ts_col->GetId(), pos) < 0) {
+                continue;
+            }
+            ready_pos[pos] = true;
+            if (!dim_idx.has_value()) {
+                dim_idx = index_def->GetId();
+            }
+            if (ts_col->IsAutoGenTs()) {
+                auto_gen_pos = pos;
+            }
+        }
+        if (!dim_idx.has_value()) {
+            continue;
+        }
+        // the row is put to all the time lists of inner index by one dimension
+        auto add_dimension = [&](::openmldb::api::LogEntry* entry, const Slice& key, uint32_t ts_pos, uint64_t ts) {
+            int dim_size = entry->dimensions_size();
+            if (dim_size == 0 || entry->dimensions(dim_size - 1).idx() != dim_idx.value()) {
+                auto dimension = entry->add_dimensions();
+                dimension->set_key(key.data(), key.size());
+                dimension->set_idx(dim_idx.value());
+            }
+            if (!entry->has_ts() || auto_gen_pos == ts_pos) {
+                entry->set_ts(ts);
+            }
+        };
+        auto visit = [&](const Slice& key, uint32_t ts_pos, uint64_t ts, DataBlock* row) {
+            if (ts_pos >= ready_pos.size() || !ready_pos[ts_pos]) {
+                return;
+            }
+            if (row->dim_cnt_down <= 1) {
+                auto& entry = entries.emplace_back();
+                add_dimension(&entry, key, ts_pos, ts);
+                entry.set_value(row->data, row->size);
+                return;
+            }
+            auto iter = shared_rows.try_emplace(row).first;
+            add_dimension(&iter->second.first, key, ts_pos, ts);
+            if (++iter->second.second >= row->dim_cnt_down) {
+                auto& entry = entries.emplace_back(std::move(iter->second.first));
+                entry.set_value(row->data, row->size);
+                shared_rows.erase(iter);
+            }
+        };
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            std::optional<std::string> last_key;
+            bool has_more = true;
+            while (has_more) {
+                // call `fn` out of the lock of segment
+                has_more = segments_[i][j]->DumpRows(view.put_seq, DUMP_ROWS_BATCH, &last_key, visit);
+                for (auto& entry : entries) {
+                    if (!fn(&entry)) {
+                        return false;
+                    }
+                }
+                entries.clear();
+                if (shared_rows.size() > max_pending) {
+                    PDLOG(WARNING, "the rows in several inner indexes held %lu exceed %lu. tid %u pid %u",
+                          shared_rows.size(), max_pending, id_, pid_);
+                    return false;
+                }
+                BackgroundThrottle::Check();
+            }
+        }
+    }
+    // the rows have been deleted from some of the lists
+    for (auto& kv : shared_rows) {
+        kv.second.first.set_value(kv.first->data, kv.first->size);
+        if (!fn(&kv.second.first)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MemTable::LoadImage(uint64_t offset, MemTableImageReader* reader) {
+    uint64_t image_offset = 0;
+    uint32_t seg_cnt = 0;
+    std::vector<uint32_t> ts_cnt_vec;
+    if (!reader->ReadHeader(&image_offset, &seg_cnt, &ts_cnt_vec)) {
+        return false;
+    }
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    if (image_offset != offset || seg_cnt != seg_cnt_ || ts_cnt_vec.size() != inner_indexs->size()) {
+        PDLOG(WARNING, "image does not match the table. offset %lu seg_cnt %u inner index num %u. tid %u pid %u",
+              image_offset, seg_cnt, ts_cnt_vec.size(), id_, pid_);
+        return false;
+    }
+    for (uint32_t i = 0; i < ts_cnt_vec.size(); i++) {
+        if (segments_[i] == nullptr || segments_[i][0]->GetTsCnt() != ts_cnt_vec[i]) {
+            PDLOG(WARNING, "ts count of inner index %u does not match the image. tid %u pid %u", i, id_, pid_);
+            return false;
+        }
+    }
+    if (GetRecordIdxCnt() > 0) {
+        PDLOG(WARNING, "table is not empty, can not load image. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < ts_cnt_vec.size(); i++) {
+        for (uint32_t j = 0; ok && j < seg_cnt_; j++) {
+            ok = segments_[i][j]->LoadImage(reader);
+        }
+    }
+    if (!ok || !reader->ReadTail()) {
+        for (uint32_t i = 0; i < ts_cnt_vec.size(); i++) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                StatisticsInfo statistics_info(segments_[i][j]->GetTsCnt());
+                segments_[i][j]->Release(&statistics_info);
+            }
+        }
+        return false;
+    }
+    record_byte_size_.fetch_add(reader->GetRecordByteSize(), std::memory_order_relaxed);
+    image_rows_ = reader->GetRows();
+    return true;
+}
+
 }  // namespace storage
 }  // namespace openmldb
@@ -18,8 +18,10 @@
 #define SRC_STORAGE_MEM_TABLE_H_
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
@@ -37,6 +39,13 @@ typedef google::protobuf::RepeatedPtrField<::openmldb::api::Dimension> Dimension
 using ::openmldb::api::LogEntry;
 using ::openmldb::base::Slice;
 
+// the rows put to the memory table up to `put_seq` are exactly the rows of the binlog entries up to `offset`.
+// it's pinned while no one is between changing the table and appending the entry to binlog
+struct MemTableView {
+    uint64_t offset = 0;
+    uint64_t put_seq = 0;
+};
+
 class MemTable : public Table {
  public:
     MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t seg_cnt,
@@ -97,10 +106,34 @@ class MemTable : public Table {
 
     bool IsExpire(const ::openmldb::api::LogEntry& entry) override;
 
+    // fix the expire time of absolute ttl of each index when recovery starts
+    void BeginRecover() override;
+    void EndRecover() override;
+    // whether the row is expired by absolute ttl in all the indexes it's in. latest ttl is not checked, a delete in
+    // the binlog loaded later may remove the newer rows and make the row visible again
+    bool IsExpireOnRecover(const ::openmldb::api::LogEntry& entry) override;
+
     inline bool GetExpireStatus() { return enable_gc_.load(std::memory_order_relaxed); }
 
     inline uint32_t GetKeyEntryHeight() const { return key_entry_max_height_; }
 
+    // the seq of the last row put by Put, the rows put later have greater seqs
+    uint64_t GetPutSeq() const { return put_seq_.load(std::memory_order_acquire); }
+
+    // dump the memory image of table with the rows of `view`, `offset` is the offset of snapshot the image
+    // belongs to. gc is skipped while dumping, so no data block will be freed and its address can't be reused
+    bool DumpImage(uint64_t offset, const MemTableView& view, MemTableImageWriter* writer);
+
+    // load the memory image to the empty table, the table is still empty if it fails
+    bool LoadImage(uint64_t offset, MemTableImageReader* reader);
+
+    // call `fn` with the entry of every row of `view`, the entry has a dimension for each inner index the row
+    // is in. gc is skipped while dumping like DumpImage, so the rows visited can't be freed. the row in several
+    // inner indexes is held until it's visited in all of them, fail if more than `max_pending` rows are held.
+    // stop if `fn` returns false
+    bool DumpRows(const MemTableView& view, uint64_t max_pending,
+                  const std::function<bool(::openmldb::api::LogEntry* entry)>& fn);
+
  protected:
     bool AddIndexToTable(const std::shared_ptr<IndexDef>& index_def) override;
 
@@ -120,6 +153,11 @@ class MemTable : public Table {
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    // call `check` with every ready index the entry is in and the ts of the index,
+    // return true if it returns true for all of them
+    template <typename F>
+    bool CheckExpire(const ::openmldb::api::LogEntry& entry, F&& check);
+
     bool Delete(uint32_t idx, const std::string& key, const std::optional<uint64_t>& start_ts,
                 const std::optional<uint64_t>& end_ts);
 
@@ -131,6 +169,16 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    std::mutex gc_mu_;
+    // a gc round is skipped while dumping, it's run once the dump finishes
+    std::atomic<bool> gc_pending_{false};
+    std::atomic<uint64_t> put_seq_{0};
+    // the rows file mapped by LoadImage, the rows loaded refer to it
+    std::shared_ptr<MemTableImageRows> image_rows_;
+    // the expire time of absolute ttl indexed by index id, it's set by BeginRecover
+    std::vector<uint64_t> recover_expire_time_;
+    std::atomic<bool> recovering_{false};
+    std::atomic<uint64_t> recover_expired_cnt_{0};
 };
 
 }  // namespace storage
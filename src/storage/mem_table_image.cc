@@ -0,0 +1,457 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/mem_table_image.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/glog_wrapper.h"
+#include "log/coding.h"
+#include "log/crc32c.h"
+#include "storage/record.h"
+
+namespace openmldb {
+namespace storage {
+
+std::shared_ptr<MemTableImageRows> MemTableImageRows::Open(const std::string& fname) {
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to open rows file %s, errno %d", fname.c_str(), errno);
+        return {};
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        PDLOG(WARNING, "fail to stat rows file %s, errno %d", fname.c_str(), errno);
+        close(fd);
+        return {};
+    }
+    uint64_t size = st.st_size;
+    char* data = nullptr;
+    if (size > 0) {
+        void* addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            PDLOG(WARNING, "fail to map rows file %s, errno %d", fname.c_str(), errno);
+            close(fd);
+            return {};
+        }
+        // the rows are read by key lookups
+        madvise(addr, size, MADV_RANDOM);
+        data = reinterpret_cast<char*>(addr);
+    }
+    // the mapping is kept after the file is closed
+    close(fd);
+    return std::shared_ptr<MemTableImageRows>(new MemTableImageRows(data, size));
+}
+
+MemTableImageRows::~MemTableImageRows() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+    }
+}
+
+MemTableImageWriter::MemTableImageWriter(const std::string& fname, FILE* fd, FILE* rows_fd)
+    : fname_(fname),
+      fd_(fd),
+      rows_fd_(rows_fd),
+      rows_size_(0),
+      buf_(),
+      block_start_(0),
+      failed_(false),
+      row_cnt_(0),
+      entry_cnt_(0),
+      next_id_(0),
+      shared_rows_() {
+    buf_.reserve(2 * kImageBlockSize);
+}
+
+MemTableImageWriter::~MemTableImageWriter() {
+    if (fd_ != NULL) {
+        fclose(fd_);
+    }
+    if (rows_fd_ != NULL) {
+        fclose(rows_fd_);
+    }
+}
+
+void MemTableImageWriter::WriteHeader(uint64_t offset, uint32_t seg_cnt, const std::vector<uint32_t>& ts_cnt_vec) {
+    AppendFixed32(kImageMagic);
+    AppendFixed32(kImageVersion);
+    AppendFixed64(offset);
+    AppendFixed32(seg_cnt);
+    AppendFixed32(ts_cnt_vec.size());
+    for (auto ts_cnt : ts_cnt_vec) {
+        AppendFixed32(ts_cnt);
+    }
+}
+
+void MemTableImageWriter::WriteKey(const base::Slice& key) {
+    AppendTag(kKey);
+    AppendFixed32(key.size());
+    Append(key.data(), key.size());
+}
+
+void MemTableImageWriter::WriteRow(uint64_t ts, const DataBlock* row) {
+    entry_cnt_++;
+    if (row->dim_cnt_down <= 1) {
+        AppendTag(rows_fd_ == NULL ? kRow : kMappedRow);
+        AppendFixed64(ts);
+        AppendData(row);
+        row_cnt_++;
+        return;
+    }
+    auto iter = shared_rows_.find(row);
+    if (iter == shared_rows_.end()) {
+        uint64_t id = next_id_++;
+        shared_rows_.emplace(row, std::make_pair(id, 1));
+        AppendTag(rows_fd_ == NULL ? kSharedRow : kMappedSharedRow);
+        AppendFixed64(ts);
+        AppendFixed64(id);
+        AppendData(row);
+        row_cnt_++;
+        return;
+    }
+    uint64_t id = iter->second.first;
+    if (++iter->second.second >= row->dim_cnt_down) {
+        shared_rows_.erase(iter);
+        AppendTag(kLastRowRef);
+    } else {
+        AppendTag(kRowRef);
+    }
+    AppendFixed64(ts);
+    AppendFixed64(id);
+}
+
+void MemTableImageWriter::AppendData(const DataBlock* row) {
+    if (rows_fd_ == NULL) {
+        AppendFixed32(row->size);
+        Append(row->data, row->size);
+        return;
+    }
+    if (!failed_ && fwrite(row->data, 1, row->size, rows_fd_) != row->size) {
+        PDLOG(WARNING, "fail to write rows of image %s, errno %d", fname_.c_str(), errno);
+        failed_ = true;
+    }
+    AppendFixed64(rows_size_);
+    AppendFixed32(row->size);
+    rows_size_ += row->size;
+}
+
+void MemTableImageWriter::WriteEndList() { AppendTag(kEndList); }
+
+void MemTableImageWriter::WriteEndSegment() { AppendTag(kEndSegment); }
+
+void MemTableImageWriter::AppendFixed32(uint32_t value) {
+    char buf[sizeof(uint32_t)];
+    ::openmldb::log::EncodeFixed32(buf, value);
+    Append(buf, sizeof(buf));
+}
+
+void MemTableImageWriter::AppendFixed64(uint64_t value) {
+    char buf[sizeof(uint64_t)];
+    ::openmldb::log::EncodeFixed64(buf, value);
+    Append(buf, sizeof(buf));
+}
+
+void MemTableImageWriter::Append(const char* data, size_t size) {
+    while (size > 0) {
+        if (buf_.size() == block_start_) {
+            // reserve the header of new block
+            buf_.append(kImageBlockHeaderSize, '\0');
+        }
+        size_t n = std::min(size, block_start_ + kImageBlockSize - buf_.size());
+        buf_.append(data, n);
+        data += n;
+        size -= n;
+        if (buf_.size() == block_start_ + kImageBlockSize) {
+            SealBlock();
+        }
+    }
+}
+
+void MemTableImageWriter::SealBlock() {
+    char* block = &buf_[block_start_];
+    uint32_t payload_size = buf_.size() - block_start_ - kImageBlockHeaderSize;
+    uint32_t crc = ::openmldb::log::Value(block + kImageBlockHeaderSize, payload_size);
+    ::openmldb::log::EncodeFixed32(block, payload_size);
+    ::openmldb::log::EncodeFixed32(block + 4, ::openmldb::log::Mask(crc));
+    block_start_ = buf_.size();
+}
+
+bool MemTableImageWriter::WriteFile(size_t size) {
+    if (fwrite(buf_.data(), 1, size, fd_) != size) {
+        PDLOG(WARNING, "fail to write image %s, errno %d", fname_.c_str(), errno);
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool MemTableImageWriter::Flush() {
+    if (failed_) {
+        return false;
+    }
+    if (block_start_ == 0) {
+        return true;
+    }
+    if (!WriteFile(block_start_)) {
+        return false;
+    }
+    buf_.erase(0, block_start_);
+    block_start_ = 0;
+    return true;
+}
+
+bool MemTableImageWriter::Finish() {
+    AppendTag(kEndImage);
+    AppendFixed64(row_cnt_);
+    AppendFixed64(entry_cnt_);
+    if (buf_.size() > block_start_) {
+        SealBlock();
+    }
+    if (!Flush()) {
+        return false;
+    }
+    if (fflush(fd_) != 0 || fsync(fileno(fd_)) != 0) {
+        PDLOG(WARNING, "fail to sync image %s, errno %d", fname_.c_str(), errno);
+        failed_ = true;
+        return false;
+    }
+    if (rows_fd_ != NULL && (fflush(rows_fd_) != 0 || fsync(fileno(rows_fd_)) != 0)) {
+        PDLOG(WARNING, "fail to sync rows of image %s, errno %d", fname_.c_str(), errno);
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+MemTableImageReader::MemTableImageReader(const std::string& fname, FILE* fd, bool verify_crc)
+    : fname_(fname),
+      fd_(fd),
+      verify_crc_(verify_crc),
+      rows_(),
+      block_(),
+      pos_(0),
+      record_byte_size_(0),
+      row_cnt_(0),
+      entry_cnt_(0),
+      shared_rows_() {
+    posix_fadvise(fileno(fd_), 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+MemTableImageReader::~MemTableImageReader() {
+    if (fd_ != NULL) {
+        fclose(fd_);
+    }
+}
+
+bool MemTableImageReader::ReadBlock() {
+    char header[kImageBlockHeaderSize];
+    if (fread(header, 1, kImageBlockHeaderSize, fd_) != kImageBlockHeaderSize) {
+        PDLOG(WARNING, "fail to read block header of image %s, the file is truncated", fname_.c_str());
+        return false;
+    }
+    uint32_t payload_size = ::openmldb::log::DecodeFixed32(header);
+    if (payload_size == 0 || payload_size > kImageBlockSize - kImageBlockHeaderSize) {
+        PDLOG(WARNING, "invalid block size %u of image %s", payload_size, fname_.c_str());
+        return false;
+    }
+    block_.resize(payload_size);
+    if (fread(&block_[0], 1, payload_size, fd_) != payload_size) {
+        PDLOG(WARNING, "fail to read block of image %s, the file is truncated", fname_.c_str());
+        return false;
+    }
+    if (verify_crc_) {
+        uint32_t expected = ::openmldb::log::Unmask(::openmldb::log::DecodeFixed32(header + 4));
+        if (expected != ::openmldb::log::Value(block_.data(), payload_size)) {
+            PDLOG(WARNING, "checksum mismatch in image %s", fname_.c_str());
+            return false;
+        }
+    }
+    pos_ = 0;
+    return true;
+}
+
+bool MemTableImageReader::Read(char* dst, size_t size) {
+    while (size > 0) {
+        if (pos_ == block_.size() && !ReadBlock()) {
+            return false;
+        }
+        size_t n = std::min(size, block_.size() - pos_);
+        memcpy(dst, block_.data() + pos_, n);
+        pos_ += n;
+        dst += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool MemTableImageReader::ReadFixed32(uint32_t* value) {
+    char buf[sizeof(uint32_t)];
+    if (!Read(buf, sizeof(buf))) {
+        return false;
+    }
+    *value = ::openmldb::log::DecodeFixed32(buf);
+    return true;
+}
+
+bool MemTableImageReader::ReadFixed64(uint64_t* value) {
+    char buf[sizeof(uint64_t)];
+    if (!Read(buf, sizeof(buf))) {
+        return false;
+    }
+    *value = ::openmldb::log::DecodeFixed64(buf);
+    return true;
+}
+
+bool MemTableImageReader::ReadHeader(uint64_t* offset, uint32_t* seg_cnt, std::vector<uint32_t>* ts_cnt_vec) {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!ReadFixed32(&magic) || !ReadFixed32(&version)) {
+        return false;
+    }
+    if (magic != kImageMagic || version != kImageVersion) {
+        PDLOG(WARNING, "invalid image %s, magic %u version %u", fname_.c_str(), magic, version);
+        return false;
+    }
+    uint32_t inner_index_num = 0;
+    if (!ReadFixed64(offset) || !ReadFixed32(seg_cnt) || !ReadFixed32(&inner_index_num)) {
+        return false;
+    }
+    ts_cnt_vec->resize(inner_index_num);
+    for (uint32_t i = 0; i < inner_index_num; i++) {
+        if (!ReadFixed32(&ts_cnt_vec->at(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MemTableImageReader::ReadTag(uint8_t* tag) { return Read(reinterpret_cast<char*>(tag), 1); }
+
+bool MemTableImageReader::ReadKey(std::string* key) {
+    uint32_t size = 0;
+    if (!ReadFixed32(&size)) {
+        return false;
+    }
+    key->resize(size);
+    return Read(&(*key)[0], size);
+}
+
+bool MemTableImageReader::ReadRow(uint8_t tag, uint64_t* ts, DataBlock** row) {
+    if (!ReadFixed64(ts)) {
+        return false;
+    }
+    uint64_t id = 0;
+    switch (tag) {
+        case kRow:
+        case kSharedRow: {
+            if (tag == kSharedRow && !ReadFixed64(&id)) {
+                return false;
+            }
+            uint32_t size = 0;
+            if (!ReadFixed32(&size)) {
+                return false;
+            }
+            char* data = new char[size];
+            if (!Read(data, size)) {
+                delete[] data;
+                return false;
+            }
+            *row = new DataBlock(0, data, size, true);
+            if (tag == kSharedRow && !shared_rows_.emplace(id, *row).second) {
+                PDLOG(WARNING, "duplicate row id %lu in image %s", id, fname_.c_str());
+                delete *row;
+                return false;
+            }
+            record_byte_size_ += GetRecordSize(size);
+            row_cnt_++;
+            break;
+        }
+        case kMappedRow:
+        case kMappedSharedRow: {
+            if (tag == kMappedSharedRow && !ReadFixed64(&id)) {
+                return false;
+            }
+            uint64_t pos = 0;
+            uint32_t size = 0;
+            if (!ReadFixed64(&pos) || !ReadFixed32(&size)) {
+                return false;
+            }
+            if (!rows_ || pos > rows_->GetSize() || size > rows_->GetSize() - pos) {
+                PDLOG(WARNING, "row at %lu size %u is out of the rows file of image %s", pos, size, fname_.c_str());
+                return false;
+            }
+            *row = new DataBlock(0, const_cast<char*>(rows_->GetData() + pos), size, true);
+            (*row)->mapped = true;
+            if (tag == kMappedSharedRow && !shared_rows_.emplace(id, *row).second) {
+                PDLOG(WARNING, "duplicate row id %lu in image %s", id, fname_.c_str());
+                delete *row;
+                return false;
+            }
+            // counted like the rows in heap, so that it's consistent with the size released by gc
+            record_byte_size_ += GetRecordSize(size);
+            row_cnt_++;
+            break;
+        }
+        case kRowRef:
+        case kLastRowRef: {
+            if (!ReadFixed64(&id)) {
+                return false;
+            }
+            auto iter = shared_rows_.find(id);
+            if (iter == shared_rows_.end()) {
+                PDLOG(WARNING, "row id %lu is not found in image %s", id, fname_.c_str());
+                return false;
+            }
+            *row = iter->second;
+            if (tag == kLastRowRef) {
+                shared_rows_.erase(iter);
+            }
+            break;
+        }
+        default:
+            PDLOG(WARNING, "invalid row tag %u in image %s", tag, fname_.c_str());
+            return false;
+    }
+    entry_cnt_++;
+    return true;
+}
+
+bool MemTableImageReader::ReadTail() {
+    uint8_t tag = 0;
+    uint64_t row_cnt = 0;
+    uint64_t entry_cnt = 0;
+    if (!ReadTag(&tag) || tag != kEndImage || !ReadFixed64(&row_cnt) || !ReadFixed64(&entry_cnt)) {
+        PDLOG(WARNING, "fail to read the tail of image %s", fname_.c_str());
+        return false;
+    }
+    if (row_cnt != row_cnt_ || entry_cnt != entry_cnt_) {
+        PDLOG(WARNING, "count mismatch in image %s. row count %lu, expect %lu. entry count %lu, expect %lu",
+              fname_.c_str(), row_cnt_, row_cnt, entry_cnt_, entry_cnt);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_MEM_TABLE_IMAGE_H_
+#define SRC_STORAGE_MEM_TABLE_IMAGE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "base/slice.h"
+#include "storage/key_entry.h"
+
+namespace openmldb {
+namespace storage {
+
+// Memory image of MemTable. It keeps the keys and the time lists of every segment
+// in the order of skiplist, so the table can be loaded by appending the nodes to
+// skiplists without comparing keys and decoding rows.
+//
+// The file is made up of blocks of kImageBlockSize bytes except the last one, each block is
+//   payload_size(4 bytes) + masked crc32c of payload(4 bytes) + payload
+// and the payloads make up a stream:
+//   image   := header segment * (inner_index_num * seg_cnt) kEndImage row_cnt(8) entry_cnt(8)
+//   header  := magic(4) version(4) offset(8) seg_cnt(4) inner_index_num(4) ts_cnt(4) * inner_index_num
+//   segment := (kKey key_size(4) key (row * kEndList) * ts_cnt) * kEndSegment
+//   row     := kRow ts(8) size(4) data
+//            | kSharedRow ts(8) id(8) size(4) data  // the first time of the row in several lists
+//            | kRowRef ts(8) id(8)                  // refer to the row written by kSharedRow
+//            | kLastRowRef ts(8) id(8)              // the last reference, the id will not be used again
+//            | kMappedRow ts(8) pos(8) size(4)      // the data is at pos of the rows file
+//            | kMappedSharedRow ts(8) id(8) pos(8) size(4)
+// the integers are in little endian and the offset is the offset of snapshot the image belongs to.
+//
+// The rows file `<image name>.rows` is the concatenation of row data. It's mapped into memory when loading and
+// the rows refer to its pages instead of being copied, so the data stays in page cache rather than heap
+constexpr uint32_t kImageMagic = 0x474d494f;  // "OIMG"
+constexpr uint32_t kImageVersion = 1;
+constexpr uint32_t kImageBlockHeaderSize = 4 + 4;
+constexpr uint32_t kImageBlockSize = 4 * 1024 * 1024;
+
+enum ImageTag : uint8_t {
+    kEndList = 0,
+    kRow = 1,
+    kSharedRow = 2,
+    kRowRef = 3,
+    kLastRowRef = 4,
+    kKey = 5,
+    kEndSegment = 6,
+    kEndImage = 7,
+    kMappedRow = 8,
+    kMappedSharedRow = 9,
+};
+
+constexpr const char* kImageRowsSuffix = ".rows";
+
+// the rows file of image mapped into memory read only, it's kept until the rows referring to it are released
+class MemTableImageRows {
+ public:
+    static std::shared_ptr<MemTableImageRows> Open(const std::string& fname);
+    ~MemTableImageRows();
+
+    const char* GetData() const { return data_; }
+    uint64_t GetSize() const { return size_; }
+
+    MemTableImageRows(const MemTableImageRows&) = delete;
+    MemTableImageRows& operator=(const MemTableImageRows&) = delete;
+
+ private:
+    MemTableImageRows(char* data, uint64_t size) : data_(data), size_(size) {}
+
+    char* data_;
+    uint64_t size_;
+};
+
+class MemTableImageWriter {
+ public:
+    // the data of rows is written to `rows_fd` if it's not NULL
+    MemTableImageWriter(const std::string& fname, FILE* fd, FILE* rows_fd = NULL);
+    ~MemTableImageWriter();
+
+    void WriteHeader(uint64_t offset, uint32_t seg_cnt, const std::vector<uint32_t>& ts_cnt_vec);
+    void WriteKey(const base::Slice& key);
+    // the time list of a key is ended by WriteEndList
+    void WriteRow(uint64_t ts, const DataBlock* row);
+    void WriteEndList();
+    void WriteEndSegment();
+
+    // the size of data which has not been written to file
+    uint64_t GetBufferedSize() const { return buf_.size(); }
+    // write the full blocks to file
+    bool Flush();
+    // write the tail and sync the file
+    bool Finish();
+
+    uint64_t GetRowCnt() const { return row_cnt_; }
+    uint64_t GetEntryCnt() const { return entry_cnt_; }
+
+    MemTableImageWriter(const MemTableImageWriter&) = delete;
+    MemTableImageWriter& operator=(const MemTableImageWriter&) = delete;
+
+ private:
+    void Append(const char* data, size_t size);
+    void AppendTag(uint8_t tag) { Append(reinterpret_cast<const char*>(&tag), 1); }
+    void AppendFixed32(uint32_t value);
+    void AppendFixed64(uint64_t value);
+    void SealBlock();
+    bool WriteFile(size_t size);
+    void AppendData(const DataBlock* row);
+
+ private:
+    std::string fname_;
+    FILE* fd_;
+    FILE* rows_fd_;
+    uint64_t rows_size_;
+    // the sealed blocks and the block being written which starts at block_start_
+    std::string buf_;
+    size_t block_start_;
+    bool failed_;
+    uint64_t row_cnt_;
+    uint64_t entry_cnt_;
+    uint64_t next_id_;
+    // the rows shared by several lists which have not been referred by all the lists. <row, <id, ref count>>
+    absl::flat_hash_map<const DataBlock*, std::pair<uint64_t, uint32_t>> shared_rows_;
+};
+
+class MemTableImageReader {
+ public:
+    MemTableImageReader(const std::string& fname, FILE* fd, bool verify_crc);
+    ~MemTableImageReader();
+
+    // the rows file which the mapped rows refer to
+    void SetRows(const std::shared_ptr<MemTableImageRows>& rows) { rows_ = rows; }
+    const std::shared_ptr<MemTableImageRows>& GetRows() const { return rows_; }
+
+    bool ReadHeader(uint64_t* offset, uint32_t* seg_cnt, std::vector<uint32_t>* ts_cnt_vec);
+    bool ReadTag(uint8_t* tag);
+    // read the key after kKey
+    bool ReadKey(std::string* key);
+    // read the row after the row tags. dim_cnt_down of the new row is 0
+    bool ReadRow(uint8_t tag, uint64_t* ts, DataBlock** row);
+    // read the tail after kEndImage and check the count
+    bool ReadTail();
+
+    // the size of the rows has been read, counted by GetRecordSize
+    uint64_t GetRecordByteSize() const { return record_byte_size_; }
+    uint64_t GetRowCnt() const { return row_cnt_; }
+    uint64_t GetEntryCnt() const { return entry_cnt_; }
+
+    MemTableImageReader(const MemTableImageReader&) = delete;
+    MemTableImageReader& operator=(const MemTableImageReader&) = delete;
+
+ private:
+    bool Read(char* dst, size_t size);
+    bool ReadFixed32(uint32_t* value);
+    bool ReadFixed64(uint64_t* value);
+    bool ReadBlock();
+
+ private:
+    std::string fname_;
+    FILE* fd_;
+    bool verify_crc_;
+    std::shared_ptr<MemTableImageRows> rows_;
+    std::string block_;
+    size_t pos_;
+    uint64_t record_byte_size_;
+    uint64_t row_cnt_;
+    uint64_t entry_cnt_;
+    absl::flat_hash_map<uint64_t, DataBlock*> shared_rows_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_MEM_TABLE_IMAGE_H_
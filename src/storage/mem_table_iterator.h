@@ -115,6 +115,7 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint64_t GetKey() const override;
     void SeekToFirst() override;
     uint64_t GetCount() const override;
+    void ResetCount() override { traverse_cnt_ = 0; }
 
  private:
     Segment** segments_;
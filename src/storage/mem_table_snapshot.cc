@@ -40,21 +40,37 @@
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
 #include "schema/index_util.h"
+#include "storage/background_throttle.h"
+#include "storage/mem_table.h"
+#include "storage/mem_table_image.h"
 
 DECLARE_uint64(gc_on_table_recover_count);
 DECLARE_int32(binlog_name_length);
 DECLARE_uint32(make_snapshot_max_deleted_keys);
+DECLARE_uint32(make_snapshot_max_pending_rows);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(binlog_enable_crc);
+DECLARE_uint32(snapshot_shard_num);
+DECLARE_uint32(snapshot_max_delta_num);
+DECLARE_bool(snapshot_image_mapped);
+DECLARE_uint32(index_data_thread_num);
+DECLARE_uint32(snapshot_read_ahead_size);
 
 namespace openmldb {
 namespace storage {
 
 constexpr const char* SNAPSHOT_SUBFIX = ".sdb";
+constexpr const char* IMAGE_SUBFIX = ".img";
+constexpr const char* DELTA_SUBFIX = ".delta";
 constexpr uint32_t KEY_NUM_DISPLAY = 1000000;
 constexpr const char* MANIFEST = "MANIFEST";
+constexpr uint32_t SEED = 0xe17a1465;
+constexpr uint32_t SHARD_WRITE_BATCH = 256;
+constexpr uint32_t SHARD_WRITE_QUEUE_SIZE = 16;
+constexpr uint32_t EXTRACT_INDEX_BATCH = 1024;
 
 bool IsCompressed(const std::string& path) {
     if (path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
@@ -88,25 +104,42 @@ std::shared_ptr<DataReader> DataReader::CreateDataReader(const std::string& snap
     return reader;
 }
 
+std::shared_ptr<DataReader> DataReader::CreateShardReader(const std::string& snapshot_path,
+        const std::string& shard_name) {
+    return CreateDataReader(snapshot_path, std::vector<std::string>{shard_name});
+}
+
+std::shared_ptr<DataReader> DataReader::CreateDataReader(const std::string& snapshot_path,
+        const std::vector<std::string>& files) {
+    if (files.empty()) {
+        return {};
+    }
+    auto reader = std::make_shared<DataReader>(snapshot_path, nullptr, "", DataReaderType::kSnapshot, 0, 0);
+    reader->snapshot_files_ = files;
+    if (!reader->Init()) {
+        reader.reset();
+    }
+    return reader;
+}
+
 bool DataReader::Init() {
     uint64_t snapshot_offset = 0;
     if (read_type_ == DataReaderType::kSnapshot || read_type_ == DataReaderType::kSnapshotAndBinlog) {
-        ::openmldb::api::Manifest manifest;
-        int ret = Snapshot::GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
-        if (ret == -1) {
-            return false;
-        } else if (ret == 0) {
-            snapshot_offset = manifest.offset();
-            std::string path = absl::StrCat(snapshot_path_, "/", manifest.name());
-            FILE* fd = fopen(path.c_str(), "rb");
-            if (fd == nullptr) {
-                PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        if (snapshot_files_.empty()) {
+            ::openmldb::api::Manifest manifest;
+            int ret = Snapshot::GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+            if (ret == -1) {
+                return false;
+            } else if (ret == 0) {
+                snapshot_offset = manifest.offset();
+                snapshot_files_ = Snapshot::GetSnapshotFiles(manifest);
+            }
+        }
+        snapshot_file_idx_ = 0;
+        if (!snapshot_files_.empty()) {
+            if (!OpenSnapshotFile()) {
                 return false;
             }
-            seq_file_.reset(::openmldb::log::NewSeqFile(path, fd));
-            bool compressed = IsCompressed(path);
-            snapshot_reader_ = std::make_shared<::openmldb::log::Reader>(
-                    seq_file_.get(), nullptr, false, 0, compressed);
             read_snapshot_ = true;
         }
     }
@@ -122,6 +155,20 @@ bool DataReader::Init() {
     return true;
 }
 
+bool DataReader::OpenSnapshotFile() {
+    std::string path = absl::StrCat(snapshot_path_, "/", snapshot_files_[snapshot_file_idx_]);
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == nullptr) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    snapshot_reader_.reset();
+    seq_file_.reset(::openmldb::log::NewReadAheadSeqFile(path, fd, FLAGS_snapshot_read_ahead_size));
+    bool compressed = IsCompressed(path);
+    snapshot_reader_ = std::make_shared<::openmldb::log::Reader>(seq_file_.get(), nullptr, false, 0, compressed);
+    return true;
+}
+
 bool DataReader::ReadFromSnapshot() {
     if (!read_snapshot_) {
         return false;
@@ -132,9 +179,16 @@ bool DataReader::ReadFromSnapshot() {
         auto status = snapshot_reader_->ReadRecord(&record_, &buffer_);
         if (status.IsWaitRecord() || status.IsEof()) {
             PDLOG(INFO, "read snapshot completed, succ_cnt %lu, failed_cnt %lu, path %s",
-                    succ_cnt_, failed_cnt_, snapshot_path_.c_str());
+                    succ_cnt_, failed_cnt_, snapshot_files_[snapshot_file_idx_].c_str());
             succ_cnt_ = 0;
             failed_cnt_ = 0;
+            // go on with the next shard
+            if (snapshot_file_idx_ + 1 < snapshot_files_.size()) {
+                snapshot_file_idx_++;
+                if (OpenSnapshotFile()) {
+                    continue;
+                }
+            }
             read_snapshot_ = false;
             return false;
         }
@@ -302,6 +356,87 @@ size_t DeleteCollector::Size() const {
     return deleted_keys_.size() + deleted_spans_.size() + no_key_spans_.size();
 }
 
+SnapshotShardWriter::SnapshotShardWriter(const std::vector<std::shared_ptr<WriteHandle>>& whs, uint32_t seg_cnt)
+    : whs_(whs), seg_cnt_(seg_cnt), pools_(), batches_(), counts_(whs.size(), 0), has_error_(false) {
+    for (size_t i = 0; i < whs_.size(); i++) {
+        pools_.emplace_back(new ::openmldb::base::TaskPool(1, SHARD_WRITE_QUEUE_SIZE));
+        batches_.push_back(std::make_shared<std::vector<std::string>>());
+    }
+}
+
+SnapshotShardWriter::~SnapshotShardWriter() {
+    for (auto& pool : pools_) {
+        pool->Stop();
+    }
+}
+
+uint32_t SnapshotShardWriter::GetShard(const ::openmldb::api::LogEntry& entry, uint32_t seg_cnt,
+                                       uint32_t shard_num) {
+    if (shard_num <= 1 || seg_cnt <= 1) {
+        return 0;
+    }
+    const std::string& key = entry.dimensions_size() > 0 ? entry.dimensions(0).key() : entry.pk();
+    uint32_t seg_idx = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt;
+    return seg_idx % shard_num;
+}
+
+bool SnapshotShardWriter::Write(const ::openmldb::api::LogEntry& entry, const ::openmldb::base::Slice& record) {
+    if (has_error_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    uint32_t shard = GetShard(entry, seg_cnt_, whs_.size());
+    auto& batch = batches_[shard];
+    batch->emplace_back(record.data(), record.size());
+    if (batch->size() >= SHARD_WRITE_BATCH) {
+        pools_[shard]->AddTask(boost::bind(&SnapshotShardWriter::WriteBatch, this, shard, batch));
+        batch = std::make_shared<std::vector<std::string>>();
+    }
+    return true;
+}
+
+bool SnapshotShardWriter::WriteShard(uint32_t shard, const ::openmldb::base::Slice& record) {
+    auto status = whs_[shard]->Write(record);
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to write shard %u of snapshot. status[%s]", shard, status.ToString().c_str());
+        has_error_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    counts_[shard]++;
+    return true;
+}
+
+void SnapshotShardWriter::WriteBatch(uint32_t shard, const std::shared_ptr<std::vector<std::string>>& batch) {
+    for (const auto& record : *batch) {
+        if (has_error_.load(std::memory_order_relaxed) || !WriteShard(shard, ::openmldb::base::Slice(record))) {
+            break;
+        }
+    }
+}
+
+bool SnapshotShardWriter::Finish() {
+    for (uint32_t shard = 0; shard < whs_.size(); shard++) {
+        if (!batches_[shard]->empty()) {
+            pools_[shard]->AddTask(boost::bind(&SnapshotShardWriter::WriteBatch, this, shard, batches_[shard]));
+            batches_[shard] = std::make_shared<std::vector<std::string>>();
+        }
+    }
+    for (auto& pool : pools_) {
+        pool->Stop();
+    }
+    for (auto& wh : whs_) {
+        if (!wh) {
+            continue;
+        }
+        auto status = wh->EndLog();
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to end snapshot. status[%s]", status.ToString().c_str());
+            has_error_.store(true, std::memory_order_relaxed);
+        }
+        wh.reset();
+    }
+    return !has_error_.load(std::memory_order_relaxed);
+}
+
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
 
@@ -327,13 +462,75 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        // the image has the rows of the binlog entries up to its offset, the binlog is replayed after it
+        uint64_t image_offset = 0;
+        if (manifest.has_image_name() && LoadImage(manifest, table)) {
+            image_offset = manifest.image_offset();
+        } else {
+            if (manifest.shard_size() > 0) {
+                RecoverFromShards(manifest, table);
+            } else {
+                RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+            }
+            // the deltas are applied in order after the base snapshot
+            for (const auto& delta : manifest.delta()) {
+                std::atomic<uint64_t> succ_cnt(0);
+                std::atomic<uint64_t> failed_cnt(0);
+                RecoverShard(absl::StrCat(snapshot_path_, "/", delta.name()), table, &succ_cnt, &failed_cnt);
+                if (succ_cnt.load(std::memory_order_relaxed) != delta.count()) {
+                    PDLOG(WARNING, "delta %s , expect cnt %lu but succ_cnt %lu", delta.name().c_str(),
+                          delta.count(), succ_cnt.load(std::memory_order_relaxed));
+                }
+            }
+        }
+        offset_ = manifest.offset();
+        latest_offset = std::max(offset_, image_offset);
+    }
+    return true;
+}
+
+bool MemTableSnapshot::RecoverOffset(uint64_t& latest_offset) {
+    ::openmldb::api::Manifest manifest;
+    manifest.set_offset(0);
+    int ret = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    if (ret == -1) {
+        return false;
+    }
+    if (ret == 0) {
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
     return true;
 }
 
+bool MemTableSnapshot::LoadImage(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table) {
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (!mem_table) {
+        return false;
+    }
+    std::string full_path = snapshot_path_ + manifest.image_name();
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open image %s, recover from snapshot. tid %u pid %u", full_path.c_str(), tid_, pid_);
+        return false;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    MemTableImageReader reader(full_path, fd, FLAGS_binlog_enable_crc);
+    std::string rows_path = full_path + kImageRowsSuffix;
+    if (::openmldb::base::IsExists(rows_path)) {
+        // the image with mapped rows fails to load if the rows file can't be mapped
+        reader.SetRows(MemTableImageRows::Open(rows_path));
+    }
+    if (!mem_table->LoadImage(manifest.offset(), &reader)) {
+        PDLOG(WARNING, "fail to load image %s, recover from snapshot. tid %u pid %u", full_path.c_str(), tid_, pid_);
+        return false;
+    }
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO, "load image %s success. row count %lu, entry count %lu, consumed %us. tid %u pid %u",
+          full_path.c_str(), reader.GetRowCnt(), reader.GetEntryCnt(), consumed, tid_, pid_);
+    return true;
+}
+
 void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt,
                                            std::shared_ptr<Table> table) {
     std::string full_path = absl::StrCat(snapshot_path_, "/", snapshot_name);
@@ -348,6 +545,78 @@ void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uin
     }
 }
 
+void MemTableSnapshot::RecoverFromShards(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table) {
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    std::atomic<uint64_t> g_succ_cnt(0);
+    std::atomic<uint64_t> g_failed_cnt(0);
+    {
+        ::openmldb::base::TaskPool load_pool(manifest.shard_size(), manifest.shard_size());
+        for (const auto& shard : manifest.shard()) {
+            std::string full_path = absl::StrCat(snapshot_path_, "/", shard.name());
+            load_pool.AddTask([this, full_path, &table, &g_succ_cnt, &g_failed_cnt] {
+                RecoverShard(full_path, table, &g_succ_cnt, &g_failed_cnt);
+            });
+        }
+        load_pool.Stop();
+    }
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO, "[Recover] load %d shards done stat: success count %lu, failed count %lu, consumed %us. tid %u pid %u",
+          manifest.shard_size(), g_succ_cnt.load(std::memory_order_relaxed),
+          g_failed_cnt.load(std::memory_order_relaxed), consumed, tid_, pid_);
+    if (g_succ_cnt.load(std::memory_order_relaxed) != manifest.count()) {
+        PDLOG(WARNING, "snapshot %s , expect cnt %lu but succ_cnt %lu", manifest.name().c_str(), manifest.count(),
+              g_succ_cnt.load(std::memory_order_relaxed));
+    }
+}
+
+void MemTableSnapshot::RecoverShard(const std::string& path, std::shared_ptr<Table> table,
+                                    std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return;
+    }
+    bool compressed = IsCompressed(path);
+    std::unique_ptr<::openmldb::log::SequentialFile> seq_file(
+        ::openmldb::log::NewReadAheadSeqFile(path, fd, FLAGS_snapshot_read_ahead_size));
+    ::openmldb::log::Reader reader(seq_file.get(), NULL, FLAGS_binlog_enable_crc, 0, compressed);
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    uint64_t succ_cnt = 0;
+    uint64_t failed_cnt = 0;
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt++;
+            continue;
+        }
+        if (!entry.ParseFromArray(record.data(), record.size())) {
+            PDLOG(WARNING, "fail to parse record. path %s", path.c_str());
+            failed_cnt++;
+            continue;
+        }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            table->Delete(entry);
+        } else if (!table->IsExpireOnRecover(entry)) {
+            table->Put(entry);
+        }
+        if (++succ_cnt % 100000 == 0) {
+            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), succ_cnt, failed_cnt);
+        }
+    }
+    PDLOG(INFO, "read path %s for table tid %u pid %u completed, succ_cnt %lu, failed_cnt %lu", path.c_str(),
+          tid_, pid_, succ_cnt, failed_cnt);
+    g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+    g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+}
+
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
     ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
@@ -365,8 +634,9 @@ void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::share
             break;
         }
         bool compressed = IsCompressed(path);
-        std::unique_ptr<::openmldb::log::SequentialFile> seq_file(::openmldb::log::NewSeqFile(path, fd));
-        ::openmldb::log::Reader reader(seq_file.get(), NULL, false, 0, compressed);
+        std::unique_ptr<::openmldb::log::SequentialFile> seq_file(
+            ::openmldb::log::NewReadAheadSeqFile(path, fd, FLAGS_snapshot_read_ahead_size));
+        ::openmldb::log::Reader reader(seq_file.get(), NULL, FLAGS_binlog_enable_crc, 0, compressed);
         std::string buffer;
         uint64_t consumed = ::baidu::common::timer::now_time();
         std::vector<std::string*> recordPtr;
@@ -431,24 +701,71 @@ void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std
         }
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             table->Delete(entry);
-        } else {
+        } else if (!table->IsExpireOnRecover(entry)) {
             table->Put(entry);
         }
     }
 }
 
 int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
-        const std::shared_ptr<WriteHandle>& wh, MemSnapshotMeta* snapshot_meta) {
-    auto data_reader = DataReader::CreateDataReader(snapshot_path_, nullptr, "", DataReaderType::kSnapshot);
+        SnapshotShardWriter* writer, MemSnapshotMeta* snapshot_meta) {
+    uint32_t shard_num = writer->GetShardNum();
+    uint64_t total_cnt = manifest.count();
+    for (const auto& delta : manifest.delta()) {
+        total_cnt += delta.count();
+    }
+    std::vector<std::string> files = GetSnapshotFiles(manifest);
+    if (shard_num > 1 && manifest.shard_size() == static_cast<int>(shard_num) &&
+            manifest.seg_cnt() == snapshot_meta->seg_cnt) {
+        // the layout is not changed, so every shard of old snapshot is filtered into the same shard in parallel
+        std::atomic<uint64_t> expired_cnt(0);
+        std::atomic<uint64_t> deleted_cnt(0);
+        std::atomic<uint64_t> write_cnt(0);
+        std::atomic<bool> has_error(false);
+        {
+            ::openmldb::base::TaskPool pool(shard_num, shard_num);
+            auto throttle_fn = BackgroundThrottle::GetCurrentFn();
+            for (uint32_t idx = 0; idx < shard_num; idx++) {
+                pool.AddTask([&, idx] {
+                    BackgroundThrottle throttle(throttle_fn);
+                    if (!TTLShard(table, manifest.shard(idx), idx, writer, &expired_cnt, &deleted_cnt, &write_cnt)) {
+                        has_error.store(true, std::memory_order_relaxed);
+                    }
+                });
+            }
+            pool.Stop();
+        }
+        snapshot_meta->expired_key_num += expired_cnt.load(std::memory_order_relaxed);
+        snapshot_meta->deleted_key_num += deleted_cnt.load(std::memory_order_relaxed);
+        snapshot_meta->count += write_cnt.load(std::memory_order_relaxed);
+        if (has_error.load(std::memory_order_relaxed)) {
+            return -1;
+        }
+        if (manifest.delta_size() == 0) {
+            PDLOG(INFO, "load snapshot success. load key num[%lu] ttl key num[%lu] shard num[%u]",
+                    snapshot_meta->count, snapshot_meta->expired_key_num, shard_num);
+            return 0;
+        }
+        // the deltas are filtered in order after the shards
+        files.erase(files.begin(), files.begin() + shard_num);
+    }
+    auto data_reader = DataReader::CreateDataReader(snapshot_path_, files);
     if (!data_reader) {
         PDLOG(WARNING, "fail to create data reader. tid %u pid %u", tid_, pid_);
         return -1;
     }
     bool has_error = false;
+    uint64_t delete_entry_cnt = 0;
     std::string tmp_buf;
     while (data_reader->HasNext()) {
+        BackgroundThrottle::Check();
         auto& entry = data_reader->GetValue();
         ::openmldb::base::Slice record(data_reader->GetStrValue());
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            // the delete entry of delta has been collected by CollectDeletedKey
+            delete_entry_cnt++;
+            continue;
+        }
         if (!delete_collector_.IsEmpty()) {
             int ret = CheckDeleteAndUpdate(table, &entry);
             if (ret == 1) {
@@ -463,23 +780,22 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
             snapshot_meta->expired_key_num++;
             continue;
         }
-        auto status = wh->Write(record);
-        if (!status.ok()) {
-            PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
+        if (!writer->Write(entry, record)) {
+            PDLOG(WARNING, "fail to write snapshot %s", snapshot_meta->snapshot_name.c_str());
             has_error = true;
             break;
         }
         if ((snapshot_meta->count + snapshot_meta->expired_key_num + snapshot_meta->deleted_key_num)
                 % KEY_NUM_DISPLAY == 0) {
             PDLOG(INFO, "tackled key num[%lu] total[%lu]",
-                    snapshot_meta->count + snapshot_meta->expired_key_num, manifest.count());
+                    snapshot_meta->count + snapshot_meta->expired_key_num, total_cnt);
         }
         snapshot_meta->count++;
     }
-    if (snapshot_meta->expired_key_num + snapshot_meta->count + snapshot_meta->deleted_key_num
-            != manifest.count()) {
+    if (snapshot_meta->expired_key_num + snapshot_meta->count + snapshot_meta->deleted_key_num + delete_entry_cnt
+            != total_cnt) {
         PDLOG(WARNING, "key num not match! total key num[%lu] load key num[%lu] ttl key num[%lu]",
-              manifest.count(), snapshot_meta->count, snapshot_meta->expired_key_num);
+              total_cnt, snapshot_meta->count, snapshot_meta->expired_key_num);
         has_error = true;
     }
     if (has_error) {
@@ -490,14 +806,98 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
     return 0;
 }
 
+bool MemTableSnapshot::TTLShard(std::shared_ptr<Table> table, const ::openmldb::api::SnapshotShard& shard,
+                                uint32_t shard_idx, SnapshotShardWriter* writer, std::atomic<uint64_t>* expired_cnt,
+                                std::atomic<uint64_t>* deleted_cnt, std::atomic<uint64_t>* write_cnt) {
+    auto data_reader = DataReader::CreateShardReader(snapshot_path_, shard.name());
+    if (!data_reader) {
+        PDLOG(WARNING, "fail to create data reader of %s. tid %u pid %u", shard.name().c_str(), tid_, pid_);
+        return false;
+    }
+    uint64_t expired_num = 0;
+    uint64_t deleted_num = 0;
+    uint64_t count = 0;
+    bool has_error = false;
+    std::string tmp_buf;
+    while (data_reader->HasNext()) {
+        BackgroundThrottle::Check();
+        auto& entry = data_reader->GetValue();
+        ::openmldb::base::Slice record(data_reader->GetStrValue());
+        if (!delete_collector_.IsEmpty()) {
+            int ret = CheckDeleteAndUpdate(table, &entry);
+            if (ret == 1) {
+                deleted_num++;
+                continue;
+            } else if (ret == 2) {
+                entry.SerializeToString(&tmp_buf);
+                record.reset(tmp_buf.data(), tmp_buf.size());
+            }
+        }
+        if (table->IsExpire(entry)) {
+            expired_num++;
+            continue;
+        }
+        if (!writer->WriteShard(shard_idx, record)) {
+            has_error = true;
+            break;
+        }
+        count++;
+    }
+    expired_cnt->fetch_add(expired_num, std::memory_order_relaxed);
+    deleted_cnt->fetch_add(deleted_num, std::memory_order_relaxed);
+    write_cnt->fetch_add(count, std::memory_order_relaxed);
+    if (!has_error && expired_num + deleted_num + count != shard.count()) {
+        PDLOG(WARNING, "key num not match! shard %s total key num[%lu] load key num[%lu] ttl key num[%lu]",
+              shard.name().c_str(), shard.count(), count, expired_num);
+        has_error = true;
+    }
+    return !has_error;
+}
+
+void MemTableSnapshot::CollectDeleteEntry(const ::openmldb::api::LogEntry& entry) {
+    uint64_t offset = entry.log_index();
+    if (entry.dimensions_size() == 0) {
+        delete_collector_.AddSpan(offset, DeleteSpan(entry));
+        DEBUGLOG("insert span offset %lu. tid %u pid %u", offset, tid_, pid_);
+    } else {
+        std::string combined_key = absl::StrCat(entry.dimensions(0).key(), "|", entry.dimensions(0).idx());
+        DEBUGLOG("insert key %s offset %lu. tid %u pid %u", combined_key.c_str(), offset, tid_, pid_);
+        if (entry.has_ts() || entry.has_end_ts()) {
+            delete_collector_.AddSpan(std::move(combined_key), DeleteSpan(entry));
+        } else {
+            delete_collector_.AddKey(offset, std::move(combined_key));
+        }
+    }
+}
+
 uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     delete_collector_.Clear();
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) == 0) {
+        // the delete entries of deltas are applied to the base snapshot and the former deltas, so they are
+        // collected completely regardless of make_snapshot_max_deleted_keys
+        for (const auto& delta : manifest.delta()) {
+            auto data_reader = DataReader::CreateShardReader(snapshot_path_, delta.name());
+            if (!data_reader) {
+                PDLOG(WARNING, "fail to create data reader of %s. tid %u pid %u", delta.name().c_str(), tid_, pid_);
+                continue;
+            }
+            while (data_reader->HasNext()) {
+                BackgroundThrottle::Check();
+                const auto& entry = data_reader->GetValue();
+                if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                    CollectDeleteEntry(entry);
+                }
+            }
+        }
+    }
     uint64_t cur_offset = offset_;
     auto data_reader = DataReader::CreateDataReader(log_part_, log_path_, offset_, end_offset);
     if (!data_reader) {
         return cur_offset;
     }
     while (data_reader->HasNext()) {
+        BackgroundThrottle::Check();
         if (delete_collector_.Size() >= FLAGS_make_snapshot_max_deleted_keys) {
             PDLOG(WARNING, "deleted_keys map size reach the make_snapshot_max_deleted_keys %u, tid %u pid %u",
                   FLAGS_make_snapshot_max_deleted_keys, tid_, pid_);
@@ -506,18 +906,7 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
         const auto& entry = data_reader->GetValue();
         cur_offset = entry.log_index();
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            if (entry.dimensions_size() == 0) {
-                delete_collector_.AddSpan(cur_offset, DeleteSpan(entry));
-                DEBUGLOG("insert span offset %lu. tid %u pid %u", cur_offset, tid_, pid_);
-            } else {
-                std::string combined_key = absl::StrCat(entry.dimensions(0).key(), "|", entry.dimensions(0).idx());
-                if (entry.has_ts() || entry.has_end_ts()) {
-                    delete_collector_.AddSpan(std::move(combined_key), DeleteSpan(entry));
-                } else {
-                    delete_collector_.AddKey(cur_offset, std::move(combined_key));
-                }
-                DEBUGLOG("insert key %s offset %lu. tid %u pid %u", combined_key.c_str(), cur_offset, tid_, pid_);
-            }
+            CollectDeleteEntry(entry);
         }
     }
     return cur_offset;
@@ -538,22 +927,23 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         this->making_snapshot_.store(false, std::memory_order_release);
         this->delete_collector_.Clear();
     };
+    ::openmldb::api::Manifest manifest;
+    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
+    if (result == 0 && !NeedCompaction(manifest, end_offset)) {
+        return MakeDeltaSnapshot(table, manifest, out_offset);
+    }
     MemSnapshotMeta snapshot_meta(GenSnapshotName(), snapshot_path_, FLAGS_snapshot_compression);
-    auto wh = ::openmldb::log::CreateWriteHandle(FLAGS_snapshot_compression,
-            snapshot_meta.snapshot_name, snapshot_meta.tmp_file_path);
-    if (!wh) {
-        PDLOG(WARNING, "fail to create file %s", snapshot_meta.tmp_file_path.c_str());
+    auto writer = CreateShardWriter(table, FLAGS_snapshot_shard_num, &snapshot_meta);
+    if (!writer) {
         return -1;
     }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    ::openmldb::api::Manifest manifest;
     bool has_error = false;
     snapshot_meta.term = term;
-    int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
         // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, &snapshot_meta) < 0) {
+        if (TTLSnapshot(table, manifest, writer.get(), &snapshot_meta) < 0) {
             has_error = true;
         }
         snapshot_meta.term = manifest.term();
@@ -569,6 +959,7 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     std::string buffer;
     std::string tmp_buf;
     while (!has_error && cur_offset < collected_offset) {
+        BackgroundThrottle::Check();
         buffer.clear();
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
@@ -609,10 +1000,8 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
                 snapshot_meta.expired_key_num++;
                 continue;
             }
-            ::openmldb::log::Status status = wh->Write(record);
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]",
-                        snapshot_meta.tmp_file_path.c_str(), status.ToString().c_str());
+            if (!writer->Write(entry, record)) {
+                PDLOG(WARNING, "fail to write snapshot. path[%s]", snapshot_meta.tmp_file_path.c_str());
                 has_error = true;
                 break;
             }
@@ -643,12 +1032,16 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
             break;
         }
     }
-    wh->EndLog();
-    wh.reset();
+    if (!writer->Finish()) {
+        has_error = true;
+    }
     if (has_error) {
-        unlink(snapshot_meta.tmp_file_path.c_str());
+        RemoveTmpFiles(snapshot_meta);
         return -1;
     } else {
+        for (uint32_t idx = 0; idx < snapshot_meta.shard_names.size(); idx++) {
+            snapshot_meta.shard_counts.push_back(writer->GetCount(idx));
+        }
         snapshot_meta.offset = cur_offset;
         uint64_t old_offset = offset_;
         auto status = WriteSnapshot(snapshot_meta);
@@ -666,6 +1059,114 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     return 0;
 }
 
+bool MemTableSnapshot::NeedCompaction(const ::openmldb::api::Manifest& manifest, uint64_t end_offset) {
+    // the snapshot till end_offset is always a full one
+    if (FLAGS_snapshot_max_delta_num == 0 || end_offset > 0) {
+        return true;
+    }
+    if (manifest.delta_size() >= static_cast<int>(FLAGS_snapshot_max_delta_num)) {
+        return true;
+    }
+    // merge the deltas if they have more rows than the base snapshot
+    uint64_t delta_cnt = 0;
+    for (const auto& delta : manifest.delta()) {
+        delta_cnt += delta.count();
+    }
+    return delta_cnt >= manifest.count();
+}
+
+int MemTableSnapshot::MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                                        uint64_t& out_offset) {
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    // the name is unique among the deltas even if they are made in the same minute
+    std::string delta_name = GenDeltaName(manifest.delta_size());
+    std::string full_path = snapshot_path_ + delta_name;
+    std::string tmp_path = full_path + ".tmp";
+    auto data_reader = DataReader::CreateDataReader(log_part_, log_path_, offset_, 0);
+    if (!data_reader) {
+        PDLOG(WARNING, "fail to create data reader. tid %u pid %u", tid_, pid_);
+        return -1;
+    }
+    auto wh = ::openmldb::log::CreateWriteHandle(FLAGS_snapshot_compression, delta_name, tmp_path);
+    if (!wh) {
+        PDLOG(WARNING, "fail to create file %s", tmp_path.c_str());
+        return -1;
+    }
+    uint64_t cur_offset = offset_;
+    uint64_t term = manifest.term();
+    uint64_t count = 0;
+    uint64_t expired_key_num = 0;
+    bool has_error = false;
+    while (data_reader->HasNext()) {
+        BackgroundThrottle::Check();
+        auto& entry = data_reader->GetValue();
+        cur_offset = entry.log_index();
+        if (entry.has_term()) {
+            term = entry.term();
+        }
+        // the delete entries are kept as the tombstones of the rows in base snapshot and former deltas
+        bool is_delete = entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete;
+        if (!is_delete && table->IsExpire(entry)) {
+            expired_key_num++;
+            continue;
+        }
+        if (!wh->Write(::openmldb::base::Slice(data_reader->GetStrValue())).ok()) {
+            PDLOG(WARNING, "fail to write delta %s. tid %u pid %u", tmp_path.c_str(), tid_, pid_);
+            has_error = true;
+            break;
+        }
+        count++;
+    }
+    if (!wh->EndLog().ok()) {
+        has_error = true;
+    }
+    wh.reset();
+    if (has_error) {
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    if (cur_offset == offset_) {
+        unlink(tmp_path.c_str());
+        PDLOG(INFO, "no new binlog since offset %lu, skip making delta. tid %u pid %u", offset_, tid_, pid_);
+        out_offset = offset_;
+        return 0;
+    }
+    ::openmldb::api::Manifest new_manifest(manifest);
+    if (count > 0) {
+        if (rename(tmp_path.c_str(), full_path.c_str()) != 0) {
+            PDLOG(WARNING, "fail to rename %s", tmp_path.c_str());
+            unlink(tmp_path.c_str());
+            return -1;
+        }
+        auto delta = new_manifest.add_delta();
+        delta->set_name(delta_name);
+        delta->set_count(count);
+        delta->set_offset(cur_offset);
+    } else {
+        unlink(tmp_path.c_str());
+    }
+    new_manifest.set_offset(cur_offset);
+    new_manifest.set_term(term);
+    // the rows of delta are not in the image of base snapshot
+    new_manifest.clear_image_name();
+    new_manifest.clear_image_offset();
+    if (GenManifest(new_manifest) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete delta %s", full_path.c_str());
+        unlink(full_path.c_str());
+        return -1;
+    }
+    if (manifest.has_image_name()) {
+        RemoveImage(manifest.image_name());
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO, "make delta snapshot[%s] success. update offset from %lu to %lu. use %lu second. "
+          "write key %lu expired key %lu delta num %d. tid %u pid %u", delta_name.c_str(), offset_, cur_offset,
+          consumed, count, expired_key_num, new_manifest.delta_size(), tid_, pid_);
+    offset_ = cur_offset;
+    out_offset = cur_offset;
+    return 0;
+}
+
 /**
  * return code:
  * -1 : error
@@ -740,6 +1241,21 @@ int MemTableSnapshot::CheckDeleteAndUpdate(std::shared_ptr<Table> table, openmld
     return 0;
 }
 
+std::string MemTableSnapshot::GenImageName() {
+    std::string now_time = ::openmldb::base::GetNowTime();
+    return now_time.substr(0, now_time.length() - 2) + IMAGE_SUBFIX;
+}
+
+std::string MemTableSnapshot::GenDeltaName(int idx) {
+    std::string now_time = ::openmldb::base::GetNowTime();
+    std::string delta_name = absl::StrCat(now_time.substr(0, now_time.length() - 2), "_", idx, DELTA_SUBFIX);
+    if (FLAGS_snapshot_compression != "off") {
+        delta_name.append(".");
+        delta_name.append(FLAGS_snapshot_compression);
+    }
+    return delta_name;
+}
+
 std::string MemTableSnapshot::GenSnapshotName() {
     std::string now_time = ::openmldb::base::GetNowTime();
     std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
@@ -750,34 +1266,115 @@ std::string MemTableSnapshot::GenSnapshotName() {
     return snapshot_name;
 }
 
+std::unique_ptr<SnapshotShardWriter> MemTableSnapshot::CreateShardWriter(std::shared_ptr<Table> table,
+        uint32_t shard_num, MemSnapshotMeta* snapshot_meta) {
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    uint32_t seg_cnt = mem_table ? mem_table->GetSegCnt() : 1;
+    // a shard holds one segment at least
+    shard_num = std::min(std::max(shard_num, 1u), seg_cnt);
+    std::vector<std::shared_ptr<WriteHandle>> whs;
+    if (shard_num == 1) {
+        auto wh = ::openmldb::log::CreateWriteHandle(FLAGS_snapshot_compression,
+                snapshot_meta->snapshot_name, snapshot_meta->tmp_file_path);
+        if (!wh) {
+            PDLOG(WARNING, "fail to create file %s", snapshot_meta->tmp_file_path.c_str());
+            return {};
+        }
+        whs.push_back(wh);
+    } else {
+        snapshot_meta->seg_cnt = seg_cnt;
+        const std::string& name = snapshot_meta->snapshot_name;
+        size_t pos = name.find(SNAPSHOT_SUBFIX);
+        for (uint32_t idx = 0; idx < shard_num; idx++) {
+            std::string shard_name = absl::StrCat(name.substr(0, pos), "_", idx, name.substr(pos));
+            std::string tmp_path = absl::StrCat(snapshot_path_, shard_name, ".tmp");
+            auto wh = ::openmldb::log::CreateWriteHandle(FLAGS_snapshot_compression, shard_name, tmp_path);
+            if (!wh) {
+                PDLOG(WARNING, "fail to create file %s", tmp_path.c_str());
+                whs.clear();
+                RemoveTmpFiles(*snapshot_meta);
+                snapshot_meta->shard_names.clear();
+                return {};
+            }
+            snapshot_meta->shard_names.push_back(shard_name);
+            whs.push_back(wh);
+        }
+    }
+    return std::make_unique<SnapshotShardWriter>(whs, seg_cnt);
+}
+
+void MemTableSnapshot::RemoveImage(const std::string& image_name) {
+    // the rows file is still readable by the table which has mapped it
+    unlink((snapshot_path_ + image_name).c_str());
+    unlink((snapshot_path_ + image_name + kImageRowsSuffix).c_str());
+}
+
+void MemTableSnapshot::RemoveTmpFiles(const MemSnapshotMeta& snapshot_meta) {
+    if (snapshot_meta.shard_names.empty()) {
+        unlink(snapshot_meta.tmp_file_path.c_str());
+    }
+    for (const auto& shard_name : snapshot_meta.shard_names) {
+        unlink(absl::StrCat(snapshot_path_, shard_name, ".tmp").c_str());
+    }
+}
+
 ::openmldb::base::Status MemTableSnapshot::WriteSnapshot(const MemSnapshotMeta& snapshot_meta) {
     ::openmldb::api::Manifest old_manifest;
     if (GetLocalManifest(snapshot_path_ + MANIFEST, old_manifest) < 0) {
+        RemoveTmpFiles(snapshot_meta);
         return {-1, absl::StrCat("get old manifest failed. snapshot path is ", snapshot_path_)};
     }
-    if (rename(snapshot_meta.tmp_file_path.c_str(), snapshot_meta.full_path.c_str()) == 0) {
-        if (GenManifest(snapshot_meta) == 0) {
-            // delete old snapshot
-            if (old_manifest.has_name() && old_manifest.name() != snapshot_meta.snapshot_name) {
-                DEBUGLOG("old snapshot[%s] has deleted", old_manifest.name().c_str());
-                unlink((snapshot_path_ + old_manifest.name()).c_str());
+    ::openmldb::api::Manifest manifest;
+    manifest.set_offset(snapshot_meta.offset);
+    manifest.set_name(snapshot_meta.snapshot_name);
+    manifest.set_count(snapshot_meta.count);
+    manifest.set_term(snapshot_meta.term);
+    std::vector<std::string> files;
+    if (snapshot_meta.shard_names.empty()) {
+        files.push_back(snapshot_meta.snapshot_name);
+    } else {
+        files = snapshot_meta.shard_names;
+        manifest.set_seg_cnt(snapshot_meta.seg_cnt);
+        for (size_t idx = 0; idx < snapshot_meta.shard_names.size(); idx++) {
+            auto shard = manifest.add_shard();
+            shard->set_name(snapshot_meta.shard_names[idx]);
+            shard->set_count(snapshot_meta.shard_counts[idx]);
+        }
+    }
+    for (size_t idx = 0; idx < files.size(); idx++) {
+        std::string full_path = snapshot_path_ + files[idx];
+        if (rename((full_path + ".tmp").c_str(), full_path.c_str()) != 0) {
+            for (size_t pos = 0; pos < files.size(); pos++) {
+                unlink((snapshot_path_ + files[pos] + (pos < idx ? "" : ".tmp")).c_str());
             }
-            offset_ = snapshot_meta.offset;
-        } else {
-            unlink(snapshot_meta.full_path.c_str());
-            return {-1, absl::StrCat("GenManifest failed. delete snapshot file ", snapshot_meta.full_path)};
+            return {-1, absl::StrCat("rename ", files[idx], " failed")};
         }
-    } else {
-        unlink(snapshot_meta.tmp_file_path.c_str());
-        return {-1, absl::StrCat("rename ", snapshot_meta.snapshot_name, " failed")};
     }
+    if (GenManifest(manifest) != 0) {
+        for (const auto& file : files) {
+            unlink((snapshot_path_ + file).c_str());
+        }
+        return {-1, absl::StrCat("GenManifest failed. delete snapshot ", snapshot_meta.snapshot_name)};
+    }
+    // delete old snapshot
+    for (const auto& file : GetSnapshotFiles(old_manifest)) {
+        if (std::find(files.begin(), files.end(), file) == files.end()) {
+            DEBUGLOG("old snapshot[%s] has deleted", file.c_str());
+            unlink((snapshot_path_ + file).c_str());
+        }
+    }
+    // the image belongs to the old snapshot
+    if (old_manifest.has_image_name()) {
+        RemoveImage(old_manifest.image_name());
+    }
+    offset_ = snapshot_meta.offset;
     return {};
 }
 
 ::openmldb::base::Status MemTableSnapshot::ExtractIndexData(const std::shared_ptr<Table>& table,
         const std::vector<::openmldb::common::ColumnKey>& add_indexs,
         const std::vector<std::shared_ptr<::openmldb::log::WriteHandle>>& whs,
-        uint64_t offset, bool dump_data) {
+        uint64_t offset, bool dump_data, const std::function<void(uint64_t)>& progress) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
     if (making_snapshot_.exchange(true, std::memory_order_consume)) {
@@ -805,139 +1402,171 @@ std::string MemTableSnapshot::GenSnapshotName() {
     if (!data_reader) {
         return {-1, "create DataReader failed"};
     }
-    std::string buff;
-    ::openmldb::base::Status status;
-    uint64_t read_cnt = 0;
-    uint64_t dump_cnt = 0;
-    uint64_t extract_cnt = 0;
-    uint64_t cur_offset = 0;
-    while (data_reader->HasNext()) {
-        auto& entry = data_reader->GetValue();
-        read_cnt++;
-        cur_offset = entry.log_index();
-        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-            continue;
-        }
-        if (entry.has_term()) {
-            snapshot_meta.term = entry.term();
-        }
-        if (table->IsExpire(entry)) {
-            snapshot_meta.expired_key_num++;
-            continue;
-        }
-        bool entry_updated = false;
-        if (!delete_collector_.IsEmpty()) {
-            auto ret = CheckDeleteAndUpdate(table, &entry);
-            if (ret == 1) {
-                snapshot_meta.deleted_key_num++;
+    // the entries are read in order and extracted by the workers in batches. the records of a batch are
+    // written to the snapshot and the index files at once, so the locks are taken once per batch
+    using Batch = std::vector<std::pair<::openmldb::api::LogEntry, std::string>>;
+    std::mutex wh_mu;
+    std::vector<std::mutex> whs_mu(whs.size());
+    std::atomic<uint64_t> dump_cnt(0);
+    std::atomic<uint64_t> extract_cnt(0);
+    std::atomic<uint64_t> write_cnt(0);
+    std::atomic<uint64_t> expired_cnt(0);
+    std::atomic<uint64_t> deleted_cnt(0);
+    // 1: fail to write snapshot, 2: fail to dump index entry
+    std::atomic<int> error(0);
+    auto extract = [&](const std::shared_ptr<Batch>& batch) {
+        std::vector<std::string> records;
+        std::vector<std::vector<std::string>> dumps(whs.size());
+        uint64_t expired_num = 0;
+        uint64_t deleted_num = 0;
+        uint64_t extract_num = 0;
+        for (auto& kv : *batch) {
+            auto& entry = kv.first;
+            if (table->IsExpire(entry)) {
+                expired_num++;
                 continue;
-            } else if (ret == 2) {
-                entry_updated = true;
-            }
-        }
-        bool has_main_index = false;
-        for (int pos = 0; pos < entry.dimensions_size(); pos++) {
-            if (entry.dimensions(pos).idx() == 0) {
-                has_main_index = true;
-                break;
             }
-        }
-        if (!has_main_index) {
-            if (entry_updated) {
-                buff.clear();
-                entry.SerializeToString(&buff);
-                if (!wh->Write(::openmldb::base::Slice(buff)).ok()) {
-                    status = {-1, "fail to write snapshot"};
-                    break;
+            bool entry_updated = false;
+            if (!delete_collector_.IsEmpty()) {
+                auto ret = CheckDeleteAndUpdate(table, &entry);
+                if (ret == 1) {
+                    deleted_num++;
+                    continue;
+                } else if (ret == 2) {
+                    entry_updated = true;
                 }
-            } else {
-                if (!wh->Write(::openmldb::base::Slice(data_reader->GetStrValue())).ok()) {
-                    status = {-1, "fail to write snapshot"};
+            }
+            bool has_main_index = false;
+            for (int pos = 0; pos < entry.dimensions_size(); pos++) {
+                if (entry.dimensions(pos).idx() == 0) {
+                    has_main_index = true;
                     break;
                 }
             }
-            continue;
-        }
-        std::vector<std::string> index_row;
-        auto staus = DecodeData(table, base::Slice(entry.value()), table_index_info.GetAllIndexCols(), &index_row);
-        std::map<uint32_t, std::vector<::openmldb::api::Dimension>> dimension_map;
-        for (auto idx : table_index_info.GetAddIndexIdx()) {
-            std::string index_key;
-            for (auto pos : table_index_info.GetRealIndexCols(idx)) {
-                if (index_key.empty()) {
-                    index_key = index_row.at(pos);
-                } else {
-                    absl::StrAppend(&index_key, "|", index_row.at(pos));
+            std::map<uint32_t, std::vector<::openmldb::api::Dimension>> dimension_map;
+            if (has_main_index) {
+                std::vector<std::string> index_row;
+                auto staus = DecodeData(table, base::Slice(entry.value()), table_index_info.GetAllIndexCols(),
+                                        &index_row);
+                for (auto idx : table_index_info.GetAddIndexIdx()) {
+                    std::string index_key;
+                    for (auto pos : table_index_info.GetRealIndexCols(idx)) {
+                        if (index_key.empty()) {
+                            index_key = index_row.at(pos);
+                        } else {
+                            absl::StrAppend(&index_key, "|", index_row.at(pos));
+                        }
+                    }
+                    ::openmldb::api::Dimension dim;
+                    dim.set_idx(idx);
+                    dim.set_key(index_key);
+                    uint32_t index_pid = ::openmldb::base::hash64(index_key) % whs.size();
+                    auto iter = dimension_map.emplace(index_pid, std::vector<::openmldb::api::Dimension>()).first;
+                    iter->second.push_back(dim);
                 }
             }
-            ::openmldb::api::Dimension dim;
-            dim.set_idx(idx);
-            dim.set_key(index_key);
-            uint32_t index_pid = ::openmldb::base::hash64(index_key) % whs.size();
-            auto iter = dimension_map.emplace(index_pid, std::vector<::openmldb::api::Dimension>()).first;
-            iter->second.push_back(dim);
-        }
-        std::string tmp_buf;
-        auto iter = dimension_map.find(pid);
-        if (iter != dimension_map.end()) {
-            for (const auto& dim : iter->second) {
-                entry.add_dimensions()->CopyFrom(dim);
-            }
-            entry.SerializeToString(&tmp_buf);
-            if (!wh->Write(::openmldb::base::Slice(tmp_buf)).ok()) {
-                status = {-1, "fail to write snapshot"};
-                break;
-            }
-            entry.clear_dimensions();
-            for (const auto& dim : iter->second) {
-                ::openmldb::api::Dimension* new_dim = entry.add_dimensions();
-                new_dim->CopyFrom(dim);
-            }
-            DLOG(INFO) << "extract: dim size " << entry.dimensions_size() << " key " << entry.dimensions(0).key();
-            extract_cnt++;
-            table->Put(entry);
-        } else {
-            if (entry_updated) {
-                buff.clear();
-                entry.SerializeToString(&buff);
-                if (!wh->Write(::openmldb::base::Slice(buff)).ok()) {
-                    status = {-1, "fail to write snapshot"};
-                    break;
+            auto iter = dimension_map.find(pid);
+            if (iter != dimension_map.end()) {
+                for (const auto& dim : iter->second) {
+                    entry.add_dimensions()->CopyFrom(dim);
+                }
+                entry.SerializeToString(&records.emplace_back());
+                entry.clear_dimensions();
+                for (const auto& dim : iter->second) {
+                    entry.add_dimensions()->CopyFrom(dim);
                 }
+                DLOG(INFO) << "extract: dim size " << entry.dimensions_size() << " key " << entry.dimensions(0).key();
+                extract_num++;
+                table->Put(entry);
+            } else if (entry_updated) {
+                entry.SerializeToString(&records.emplace_back());
             } else {
-                if (!wh->Write(::openmldb::base::Slice(data_reader->GetStrValue())).ok()) {
-                    status = {-1, "fail to write snapshot"};
-                    break;
+                records.push_back(std::move(kv.second));
+            }
+            if (dump_data) {
+                for (const auto& dim_kv : dimension_map) {
+                    if (dim_kv.first == pid) {
+                        continue;
+                    }
+                    entry.clear_dimensions();
+                    for (const auto& dim : dim_kv.second) {
+                        entry.add_dimensions()->CopyFrom(dim);
+                    }
+                    entry.SerializeToString(&dumps[dim_kv.first].emplace_back());
                 }
             }
         }
-        if (dump_data) {
-            for (const auto& kv : dimension_map) {
-                if (kv.first == pid) {
-                    continue;
-                }
-                entry.clear_dimensions();
-                for (const auto& dim : kv.second) {
-                    ::openmldb::api::Dimension* new_dim = entry.add_dimensions();
-                    new_dim->CopyFrom(dim);
+        {
+            std::lock_guard<std::mutex> lock(wh_mu);
+            for (const auto& record : records) {
+                if (!wh->Write(::openmldb::base::Slice(record)).ok()) {
+                    error.store(1, std::memory_order_relaxed);
+                    break;
                 }
-                tmp_buf.clear();
-                entry.SerializeToString(&tmp_buf);
-                if (!whs[kv.first]->Write(::openmldb::base::Slice(tmp_buf)).ok()) {
-                    status =  {-1, "fail to dump index entry"};
+            }
+        }
+        for (uint32_t idx = 0; idx < dumps.size(); idx++) {
+            if (dumps[idx].empty()) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(whs_mu[idx]);
+            for (const auto& record : dumps[idx]) {
+                if (!whs[idx]->Write(::openmldb::base::Slice(record)).ok()) {
+                    error.store(2, std::memory_order_relaxed);
                     break;
                 }
-                DLOG(INFO) << "dump " << pid << " dim size " << entry.dimensions_size()
-                    << " key " << entry.dimensions(0).key();
-                dump_cnt++;
             }
+            dump_cnt.fetch_add(dumps[idx].size(), std::memory_order_relaxed);
         }
-        if (!status.OK()) {
-            break;
+        write_cnt.fetch_add(records.size(), std::memory_order_relaxed);
+        extract_cnt.fetch_add(extract_num, std::memory_order_relaxed);
+        expired_cnt.fetch_add(expired_num, std::memory_order_relaxed);
+        deleted_cnt.fetch_add(deleted_num, std::memory_order_relaxed);
+    };
+    uint64_t read_cnt = 0;
+    uint64_t cur_offset = 0;
+    {
+        uint32_t thread_num = std::max(FLAGS_index_data_thread_num, 1u);
+        ::openmldb::base::TaskPool pool(thread_num, thread_num * 2);
+        auto batch = std::make_shared<Batch>();
+        while (data_reader->HasNext() && error.load(std::memory_order_relaxed) == 0) {
+            auto& entry = data_reader->GetValue();
+            read_cnt++;
+            cur_offset = entry.log_index();
+            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                continue;
+            }
+            if (entry.has_term()) {
+                snapshot_meta.term = entry.term();
+            }
+            batch->emplace_back(std::move(entry), data_reader->GetStrValue());
+            if (batch->size() >= EXTRACT_INDEX_BATCH) {
+                pool.AddTask([&extract, batch] { extract(batch); });
+                batch = std::make_shared<Batch>();
+            }
+            if (progress && read_cnt % KEY_NUM_DISPLAY == 0) {
+                progress(read_cnt);
+            }
+        }
+        if (!batch->empty()) {
+            pool.AddTask([&extract, batch] { extract(batch); });
         }
+        pool.Stop();
+    }
+    if (progress) {
+        progress(read_cnt);
+    }
+    ::openmldb::base::Status status;
+    if (error.load(std::memory_order_relaxed) == 1) {
+        status = {-1, "fail to write snapshot"};
+    } else if (error.load(std::memory_order_relaxed) == 2) {
+        status = {-1, "fail to dump index entry"};
     }
-    LOG(INFO) << "read cnt " << read_cnt << " dump cnt " << dump_cnt << " extract cnt " << extract_cnt
-        << " tid " << tid << " pid " << pid;
+    snapshot_meta.count = write_cnt.load(std::memory_order_relaxed);
+    snapshot_meta.expired_key_num = expired_cnt.load(std::memory_order_relaxed);
+    snapshot_meta.deleted_key_num = deleted_cnt.load(std::memory_order_relaxed);
+    LOG(INFO) << "read cnt " << read_cnt << " dump cnt " << dump_cnt.load(std::memory_order_relaxed)
+        << " extract cnt " << extract_cnt.load(std::memory_order_relaxed) << " tid " << tid << " pid " << pid;
     wh->EndLog();
     wh.reset();
     if (!status.OK()) {
@@ -949,6 +1578,164 @@ std::string MemTableSnapshot::GenSnapshotName() {
     return status;
 }
 
+int MemTableSnapshot::MakeImage(std::shared_ptr<Table> table, const std::function<MemTableView()>& pin_view) {
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (!mem_table) {
+        PDLOG(WARNING, "only memory table can make image. tid %u pid %u", tid_, pid_);
+        return -1;
+    }
+    if (making_snapshot_.exchange(true, std::memory_order_acq_rel)) {
+        PDLOG(INFO, "snapshot is doing now!");
+        return -1;
+    }
+    absl::Cleanup clean = [this] { this->making_snapshot_.store(false, std::memory_order_release); };
+    ::openmldb::api::Manifest manifest;
+    if (GetLocalManifest(snapshot_path_ + MANIFEST, manifest) != 0) {
+        PDLOG(WARNING, "fail to get manifest, can not make image. tid %u pid %u", tid_, pid_);
+        return -1;
+    }
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    std::string image_name = GenImageName();
+    if (image_name == manifest.image_name()) {
+        // the files of the image in use, which may be mapped, are never overwritten
+        PDLOG(INFO, "image %s has been made just now, skip it. tid %u pid %u", image_name.c_str(), tid_, pid_);
+        return 0;
+    }
+    // the rows put to table after the view are recovered from the binlog after its offset
+    MemTableView view = pin_view();
+    if (view.offset < manifest.offset()) {
+        PDLOG(WARNING, "offset %lu is less than the snapshot offset %lu, can not make image. tid %u pid %u",
+              view.offset, manifest.offset(), tid_, pid_);
+        return -1;
+    }
+    std::string full_path = snapshot_path_ + image_name;
+    std::string tmp_path = full_path + ".tmp";
+    std::string rows_path = full_path + kImageRowsSuffix;
+    std::string tmp_rows_path = rows_path + ".tmp";
+    FILE* fd = fopen(tmp_path.c_str(), "wb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to create file %s", tmp_path.c_str());
+        return -1;
+    }
+    FILE* rows_fd = NULL;
+    if (FLAGS_snapshot_image_mapped) {
+        rows_fd = fopen(tmp_rows_path.c_str(), "wb");
+        if (rows_fd == NULL) {
+            PDLOG(WARNING, "fail to create file %s", tmp_rows_path.c_str());
+            fclose(fd);
+            unlink(tmp_path.c_str());
+            return -1;
+        }
+    }
+    uint64_t row_cnt = 0;
+    {
+        MemTableImageWriter writer(tmp_path, fd, rows_fd);
+        if (!mem_table->DumpImage(manifest.offset(), view, &writer)) {
+            PDLOG(WARNING, "fail to dump image %s. tid %u pid %u", tmp_path.c_str(), tid_, pid_);
+            unlink(tmp_path.c_str());
+            unlink(tmp_rows_path.c_str());
+            return -1;
+        }
+        row_cnt = writer.GetRowCnt();
+    }
+    uint64_t image_offset = view.offset;
+    // the rows file is renamed first, so the image never refers to a missing one. the old rows file which
+    // may be mapped is replaced rather than rewritten
+    if (rows_fd != NULL && rename(tmp_rows_path.c_str(), rows_path.c_str()) != 0) {
+        PDLOG(WARNING, "fail to rename %s", tmp_rows_path.c_str());
+        unlink(tmp_path.c_str());
+        unlink(tmp_rows_path.c_str());
+        return -1;
+    }
+    if (rows_fd == NULL) {
+        unlink(rows_path.c_str());
+    }
+    if (rename(tmp_path.c_str(), full_path.c_str()) != 0) {
+        PDLOG(WARNING, "fail to rename %s", tmp_path.c_str());
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    std::string old_image = manifest.image_name();
+    manifest.set_image_name(image_name);
+    manifest.set_image_offset(image_offset);
+    if (GenManifest(manifest) != 0) {
+        PDLOG(WARNING, "GenManifest failed. delete image %s", full_path.c_str());
+        RemoveImage(image_name);
+        return -1;
+    }
+    if (!old_image.empty() && old_image != image_name) {
+        RemoveImage(old_image);
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO, "make image %s success. snapshot offset %lu image offset %lu row count %lu, use %lu second. "
+          "tid %u pid %u", image_name.c_str(), manifest.offset(), image_offset, row_cnt, consumed, tid_, pid_);
+    return 0;
+}
+
+int MemTableSnapshot::MakeSnapshotFromMemory(std::shared_ptr<Table> table,
+                                             const std::function<MemTableView()>& pin_view, uint64_t term,
+                                             uint64_t& out_offset) {
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    if (!mem_table) {
+        PDLOG(WARNING, "only memory table can make snapshot from memory. tid %u pid %u", tid_, pid_);
+        return -1;
+    }
+    if (making_snapshot_.exchange(true, std::memory_order_acq_rel)) {
+        PDLOG(INFO, "snapshot is doing now!");
+        return -1;
+    }
+    absl::Cleanup clean = [this] { this->making_snapshot_.store(false, std::memory_order_release); };
+    uint64_t start_time = ::baidu::common::timer::now_time();
+    // the rows put to table after the view are recovered from the binlog after its offset
+    MemTableView view = pin_view();
+    if (view.offset < offset_) {
+        PDLOG(WARNING, "offset %lu is less than the snapshot offset %lu, can not make snapshot from memory. "
+              "tid %u pid %u", view.offset, offset_, tid_, pid_);
+        return -1;
+    }
+    MemSnapshotMeta snapshot_meta(GenSnapshotName(), snapshot_path_, FLAGS_snapshot_compression);
+    snapshot_meta.term = term;
+    auto writer = CreateShardWriter(table, FLAGS_snapshot_shard_num, &snapshot_meta);
+    if (!writer) {
+        return -1;
+    }
+    std::string buffer;
+    bool ok = mem_table->DumpRows(view, FLAGS_make_snapshot_max_pending_rows, [&](::openmldb::api::LogEntry* entry) {
+        entry->set_log_index(view.offset);
+        if (table->IsExpire(*entry)) {
+            snapshot_meta.expired_key_num++;
+            return true;
+        }
+        buffer.clear();
+        entry->SerializeToString(&buffer);
+        if (!writer->Write(*entry, ::openmldb::base::Slice(buffer))) {
+            PDLOG(WARNING, "fail to write snapshot %s", snapshot_meta.snapshot_name.c_str());
+            return false;
+        }
+        snapshot_meta.count++;
+        return true;
+    });
+    if (!writer->Finish() || !ok) {
+        RemoveTmpFiles(snapshot_meta);
+        return -1;
+    }
+    for (uint32_t idx = 0; idx < snapshot_meta.shard_names.size(); idx++) {
+        snapshot_meta.shard_counts.push_back(writer->GetCount(idx));
+    }
+    snapshot_meta.offset = view.offset;
+    auto status = WriteSnapshot(snapshot_meta);
+    if (!status.OK()) {
+        PDLOG(WARNING, "write snapshot failed. tid %u pid %u msg is %s ", tid_, pid_, status.GetMsg().c_str());
+        return -1;
+    }
+    uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+    PDLOG(INFO, "make snapshot[%s] from memory success. offset %lu use %lu second. write key %lu expired key %lu. "
+          "tid %u pid %u", snapshot_meta.snapshot_name.c_str(), view.offset, consumed, snapshot_meta.count,
+          snapshot_meta.expired_key_num, tid_, pid_);
+    out_offset = view.offset;
+    return 0;
+}
+
 int MemTableSnapshot::Truncate(uint64_t offset, uint64_t term) {
     if (making_snapshot_.load(std::memory_order_acquire)) {
         PDLOG(INFO, "snapshot is doing now!");
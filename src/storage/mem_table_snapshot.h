@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -28,11 +29,13 @@
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "base/status.h"
+#include "base/taskpool.hpp"
 #include "codec/schema_codec.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
 #include "storage/snapshot.h"
 
 namespace openmldb {
@@ -59,6 +62,10 @@ struct MemSnapshotMeta : SnapshotMeta {
     std::string snapshot_name_tmp;
     std::string full_path;
     std::string tmp_file_path;
+    // the shard files of snapshot, the snapshot is the single file snapshot_name if it's empty
+    std::vector<std::string> shard_names;
+    std::vector<uint64_t> shard_counts;
+    uint32_t seg_cnt = 0;
 };
 
 enum class DataReaderType {
@@ -82,6 +89,12 @@ class DataReader {
             const std::string& log_path, DataReaderType type, uint64_t end_offset);
     static std::shared_ptr<DataReader> CreateDataReader(LogParts* log_part, const std::string& log_path,
             uint64_t start_offset, uint64_t end_offset);
+    // read a single file of snapshot
+    static std::shared_ptr<DataReader> CreateShardReader(const std::string& snapshot_path,
+            const std::string& shard_name);
+    // read the files of snapshot in order
+    static std::shared_ptr<DataReader> CreateDataReader(const std::string& snapshot_path,
+            const std::vector<std::string>& files);
 
     bool HasNext();
     ::openmldb::api::LogEntry& GetValue() { return entry_; }
@@ -89,6 +102,7 @@ class DataReader {
     bool Init();
 
  private:
+    bool OpenSnapshotFile();
     bool ReadFromSnapshot();
     bool ReadFromBinlog();
 
@@ -102,6 +116,8 @@ class DataReader {
     uint64_t cur_offset_ = 0;
     bool read_snapshot_ = false;
     bool read_binlog_ = false;
+    std::vector<std::string> snapshot_files_;
+    size_t snapshot_file_idx_ = 0;
     std::shared_ptr<::openmldb::log::SequentialFile> seq_file_;
     std::shared_ptr<::openmldb::log::Reader> snapshot_reader_;
     std::shared_ptr<::openmldb::log::LogReader> binlog_reader_;
@@ -140,6 +156,39 @@ class DeleteCollector {
     absl::btree_map<uint64_t, DeleteSpan> no_key_spans_;
 };
 
+// SnapshotShardWriter writes the records of snapshot into several files in parallel. the record goes to
+// the shard which the segment of its first dimension belongs to, and every shard is written by its own thread
+class SnapshotShardWriter {
+ public:
+    SnapshotShardWriter(const std::vector<std::shared_ptr<WriteHandle>>& whs, uint32_t seg_cnt);
+    ~SnapshotShardWriter();
+    SnapshotShardWriter(const SnapshotShardWriter&) = delete;
+    SnapshotShardWriter& operator=(const SnapshotShardWriter&) = delete;
+
+    static uint32_t GetShard(const ::openmldb::api::LogEntry& entry, uint32_t seg_cnt, uint32_t shard_num);
+
+    uint32_t GetShardNum() const { return whs_.size(); }
+    // copy the record and write it in the thread of its shard. return false if writing has failed
+    bool Write(const ::openmldb::api::LogEntry& entry, const ::openmldb::base::Slice& record);
+    // write the record in the caller thread, the caller must be the only writer of the shard
+    bool WriteShard(uint32_t shard, const ::openmldb::base::Slice& record);
+    // wait for the records to be written and end the files
+    bool Finish();
+    // the number of records written to the shard, it's valid after Finish
+    uint64_t GetCount(uint32_t shard) const { return counts_[shard]; }
+
+ private:
+    void WriteBatch(uint32_t shard, const std::shared_ptr<std::vector<std::string>>& batch);
+
+ private:
+    std::vector<std::shared_ptr<WriteHandle>> whs_;
+    uint32_t seg_cnt_;
+    std::vector<std::unique_ptr<::openmldb::base::TaskPool>> pools_;
+    std::vector<std::shared_ptr<std::vector<std::string>>> batches_;
+    std::vector<uint64_t> counts_;
+    std::atomic<bool> has_error_;
+};
+
 class MemTableSnapshot : public Snapshot {
  public:
     MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path);
@@ -150,6 +199,9 @@ class MemTableSnapshot : public Snapshot {
 
     bool Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) override;
 
+    // recover the offsets from manifest only, the data has been loaded into table while the snapshot is received
+    bool RecoverOffset(uint64_t& latest_offset);
+
     void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
 
     int MakeSnapshot(std::shared_ptr<Table> table,
@@ -158,7 +210,7 @@ class MemTableSnapshot : public Snapshot {
                      uint64_t term = 0) override;
 
     int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
-            const std::shared_ptr<WriteHandle>& wh, MemSnapshotMeta* snapshot_meta);
+            SnapshotShardWriter* writer, MemSnapshotMeta* snapshot_meta);
 
     void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
              std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
@@ -166,13 +218,52 @@ class MemTableSnapshot : public Snapshot {
     base::Status ExtractIndexData(const std::shared_ptr<Table>& table,
             const std::vector<::openmldb::common::ColumnKey>& add_indexs,
             const std::vector<std::shared_ptr<::openmldb::log::WriteHandle>>& whs,
-            uint64_t offset, bool dump_data) override;
+            uint64_t offset, bool dump_data, const std::function<void(uint64_t)>& progress) override;
 
     int CheckDeleteAndUpdate(std::shared_ptr<Table> table, ::openmldb::api::LogEntry* new_entry);
 
     int Truncate(uint64_t offset, uint64_t term);
 
+    // dump the memory image of table after making snapshot, it's used to speed up the recovery.
+    // `pin_view` pins the rows of table to dump, the binlog after its offset is replayed on the image
+    int MakeImage(std::shared_ptr<Table> table, const std::function<MemTableView()>& pin_view);
+
+    // make snapshot by dumping the rows of table, the old snapshot and binlog are not replayed.
+    // `pin_view` pins the rows of table to dump like MakeImage, the snapshot offset is its offset
+    int MakeSnapshotFromMemory(std::shared_ptr<Table> table, const std::function<MemTableView()>& pin_view,
+                               uint64_t term, uint64_t& out_offset);  // NOLINT
+
  private:
+    bool LoadImage(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table);
+
+    // load the shards of snapshot in parallel, every shard is read and decoded by its own thread
+    void RecoverFromShards(const ::openmldb::api::Manifest& manifest, std::shared_ptr<Table> table);
+
+    void RecoverShard(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
+                      std::atomic<uint64_t>* g_failed_cnt);
+
+    // filter the shard of old snapshot and write it to the same shard of new snapshot
+    bool TTLShard(std::shared_ptr<Table> table, const ::openmldb::api::SnapshotShard& shard, uint32_t shard_idx,
+                  SnapshotShardWriter* writer, std::atomic<uint64_t>* expired_cnt, std::atomic<uint64_t>* deleted_cnt,
+                  std::atomic<uint64_t>* write_cnt);
+
+    // create the files of new snapshot, it's sharded if shard_num is greater than 1
+    std::unique_ptr<SnapshotShardWriter> CreateShardWriter(std::shared_ptr<Table> table, uint32_t shard_num,
+                                                           MemSnapshotMeta* snapshot_meta);
+
+    void RemoveTmpFiles(const MemSnapshotMeta& snapshot_meta);
+    // remove the image and its rows file
+    void RemoveImage(const std::string& image_name);
+
+    // write the binlog since last snapshot to a delta file, the base snapshot is not rewritten
+    int MakeDeltaSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
+                          uint64_t& out_offset);  // NOLINT
+
+    // whether to write a delta or merge the deltas into a new base snapshot
+    bool NeedCompaction(const ::openmldb::api::Manifest& manifest, uint64_t end_offset);
+
+    void CollectDeleteEntry(const ::openmldb::api::LogEntry& entry);
+
     // load single snapshot to table
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
@@ -181,6 +272,10 @@ class MemTableSnapshot : public Snapshot {
 
     std::string GenSnapshotName();
 
+    std::string GenImageName();
+
+    std::string GenDeltaName(int idx);
+
     ::openmldb::base::Status WriteSnapshot(const MemSnapshotMeta& snapshot_meta);
 
  private:
@@ -20,6 +20,7 @@
 
 #include <memory>
 
+#include "absl/cleanup/cleanup.h"
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -208,6 +209,151 @@ void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t
     }
 }
 
+bool Segment::DumpImage(MemTableImageWriter* writer, uint64_t max_seq, uint64_t limit,
+                        std::optional<std::string>* last_key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::unique_ptr<KeyEntries::Iterator> it(entries_->NewIterator());
+    if (last_key->has_value()) {
+        Slice start(last_key->value());
+        it->Seek(start);
+        if (it->Valid() && it->GetKey().compare(start) == 0) {
+            it->Next();
+        }
+    } else {
+        it->SeekToFirst();
+    }
+    for (; it->Valid(); it->Next()) {
+        writer->WriteKey(it->GetKey());
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            if (it->GetValue() != nullptr) {
+                KeyEntry* entry = ts_cnt_ > 1 ? reinterpret_cast<KeyEntry**>(it->GetValue())[i]
+                                              : reinterpret_cast<KeyEntry*>(it->GetValue());
+                std::unique_ptr<TimeEntries::Iterator> ts_it(entry->entries.NewIterator());
+                for (ts_it->SeekToFirst(); ts_it->Valid(); ts_it->Next()) {
+                    if (ts_it->GetValue()->seq <= max_seq) {
+                        writer->WriteRow(ts_it->GetKey(), ts_it->GetValue());
+                    }
+                }
+            }
+            writer->WriteEndList();
+        }
+        if (writer->GetBufferedSize() >= limit) {
+            *last_key = it->GetKey().ToString();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Segment::DumpRows(uint64_t max_seq, uint64_t limit, std::optional<std::string>* last_key,
+                       const std::function<void(const Slice& key, uint32_t ts_pos, uint64_t ts, DataBlock* row)>& fn) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::unique_ptr<KeyEntries::Iterator> it(entries_->NewIterator());
+    if (last_key->has_value()) {
+        Slice start(last_key->value());
+        it->Seek(start);
+        if (it->Valid() && it->GetKey().compare(start) == 0) {
+            it->Next();
+        }
+    } else {
+        it->SeekToFirst();
+    }
+    uint64_t cnt = 0;
+    for (; it->Valid(); it->Next()) {
+        if (it->GetValue() == nullptr) {
+            continue;
+        }
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            KeyEntry* entry = ts_cnt_ > 1 ? reinterpret_cast<KeyEntry**>(it->GetValue())[i]
+                                          : reinterpret_cast<KeyEntry*>(it->GetValue());
+            std::unique_ptr<TimeEntries::Iterator> ts_it(entry->entries.NewIterator());
+            for (ts_it->SeekToFirst(); ts_it->Valid(); ts_it->Next()) {
+                if (ts_it->GetValue()->seq > max_seq) {
+                    continue;
+                }
+                fn(it->GetKey(), i, ts_it->GetKey(), ts_it->GetValue());
+                cnt++;
+            }
+        }
+        if (cnt >= limit) {
+            *last_key = it->GetKey().ToString();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Segment::LoadImage(MemTableImageReader* reader) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!entries_->IsEmpty()) {
+        PDLOG(WARNING, "segment is not empty, can not load image");
+        return false;
+    }
+    KeyEntries::Appender key_appender(entries_);
+    uint64_t byte_size = 0;
+    uint64_t pk_cnt = 0;
+    std::vector<uint64_t> idx_cnt_vec(ts_cnt_, 0);
+    absl::Cleanup update_stat = [&] {
+        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+        pk_cnt_.fetch_add(pk_cnt, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            idx_cnt_vec_[i]->fetch_add(idx_cnt_vec[i], std::memory_order_relaxed);
+        }
+    };
+    std::string key;
+    uint8_t tag = 0;
+    while (reader->ReadTag(&tag)) {
+        if (tag == kEndSegment) {
+            return true;
+        }
+        if (tag != kKey || !reader->ReadKey(&key)) {
+            return false;
+        }
+        char* pk = new char[key.size()];
+        memcpy(pk, key.data(), key.size());
+        Slice skey(pk, key.size());
+        void* entry = nullptr;
+        if (ts_cnt_ > 1) {
+            auto** entry_arr = new KeyEntry*[ts_cnt_];
+            for (uint32_t i = 0; i < ts_cnt_; i++) {
+                entry_arr[i] = new KeyEntry(key_entry_max_height_);
+            }
+            entry = reinterpret_cast<void*>(entry_arr);
+            uint8_t height = key_appender.Append(skey, entry);
+            byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
+        } else {
+            entry = reinterpret_cast<void*>(new KeyEntry(key_entry_max_height_));
+            uint8_t height = key_appender.Append(skey, entry);
+            byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
+        }
+        pk_cnt++;
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            KeyEntry* key_entry =
+                ts_cnt_ > 1 ? reinterpret_cast<KeyEntry**>(entry)[i] : reinterpret_cast<KeyEntry*>(entry);
+            TimeEntries::Appender time_appender(&key_entry->entries);
+            while (true) {
+                if (!reader->ReadTag(&tag)) {
+                    return false;
+                }
+                if (tag == kEndList) {
+                    break;
+                }
+                uint64_t ts = 0;
+                DataBlock* row = nullptr;
+                if (!reader->ReadRow(tag, &ts, &row)) {
+                    return false;
+                }
+                row->dim_cnt_down++;
+                uint8_t height = time_appender.Append(ts, row);
+                key_entry->count_.fetch_add(1, std::memory_order_relaxed);
+                byte_size += GetRecordTsIdxSize(height);
+                idx_cnt_vec[i]++;
+            }
+        }
+    }
+    return false;
+}
+
 bool Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row, bool put_if_absent) {
     if (ts_map.empty()) {
         return false;
@@ -222,6 +368,10 @@ bool Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
     }
     void* entry_arr = nullptr;
     std::lock_guard<std::mutex> lock(mu_);
+    // check all the lists before putting, so nothing is put if the row exists
+    if (put_if_absent && ContainsUnlock(key, ts_map, row)) {
+        return false;
+    }
     for (const auto& kv : ts_map) {
         uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
@@ -245,9 +395,6 @@ bool Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
             }
         }
         auto entry = reinterpret_cast<KeyEntry**>(entry_arr)[pos->second];
-        if (put_if_absent && ListContains(entry, kv.second, row, pos->first == DEFAULT_TS_COL_ID)) {
-            return false;
-        }
         uint8_t height = entry->entries.Insert(kv.second, row);
         entry->count_.fetch_add(1, std::memory_order_relaxed);
         byte_size += GetRecordTsIdxSize(height);
@@ -667,6 +814,30 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
     }
 }
 
+bool Segment::Contains(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return ContainsUnlock(key, ts_map, row);
+}
+
+bool Segment::ContainsUnlock(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
+    void* entry = nullptr;
+    if (entries_->Get(key, entry) < 0 || entry == nullptr) {
+        return false;
+    }
+    for (const auto& kv : ts_map) {
+        auto pos = ts_idx_map_.find(kv.first);
+        if (pos == ts_idx_map_.end()) {
+            continue;
+        }
+        KeyEntry* key_entry = ts_cnt_ > 1 ? reinterpret_cast<KeyEntry**>(entry)[pos->second]
+                                          : reinterpret_cast<KeyEntry*>(entry);
+        if (ListContains(key_entry, kv.second, row, pos->first == DEFAULT_TS_COL_ID)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Segment::ListContains(KeyEntry* entry, uint64_t time, DataBlock* row, bool check_all_time) {
     // one key-time may have multi records
     std::unique_ptr<TimeEntries::Iterator> it(entry->entries.NewIterator());
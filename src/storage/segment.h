@@ -18,6 +18,7 @@
 #define SRC_STORAGE_SEGMENT_H_
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -30,6 +31,7 @@
 #include "proto/tablet.pb.h"
 #include "storage/iterator.h"
 #include "storage/key_entry.h"
+#include "storage/mem_table_image.h"
 #include "storage/node_cache.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
@@ -81,6 +83,8 @@ class Segment {
     // main put method
     virtual bool Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row,
                      bool put_if_absent = false);
+    // whether a row equal to `row` is in any of the time lists of `ts_map`, it's checked like put_if_absent
+    bool Contains(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
     bool Delete(const std::optional<uint32_t>& idx, const Slice& key);
     bool Delete(const std::optional<uint32_t>& idx, const Slice& key, uint64_t ts,
@@ -145,12 +149,28 @@ class Segment {
 
     void ReleaseAndCount(const std::vector<size_t>& id_vec, StatisticsInfo* statistics_info);
 
+    // dump the keys after `last_key` in order with their time lists to the image, dump from the first key
+    // if `last_key` is empty. the segment is locked while dumping, so the lists can't be changed by put,
+    // delete or gc. the rows put after the put seq `max_seq` are skipped. stop after the buffered size of writer
+    // reaches `limit` and set `last_key`. return false if all the keys have been dumped
+    bool DumpImage(MemTableImageWriter* writer, uint64_t max_seq, uint64_t limit, std::optional<std::string>* last_key);
+
+    // build the empty segment from the image by appending the keys and times to skiplists
+    bool LoadImage(MemTableImageReader* reader);
+
+    // call `fn` with the rows of the keys after `last_key` like DumpImage, the position of time list is passed
+    // to `fn`. stop after `limit` rows have been visited and set `last_key`. return false if all the keys have
+    // been visited. `fn` is called with the segment locked
+    bool DumpRows(uint64_t max_seq, uint64_t limit, std::optional<std::string>* last_key,
+                  const std::function<void(const Slice& key, uint32_t ts_pos, uint64_t ts, DataBlock* row)>& fn);
+
  protected:
     void FreeList(uint32_t ts_idx, ::openmldb::base::Node<uint64_t, DataBlock*>* node, StatisticsInfo* statistics_info);
     void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
     bool GetTsIdx(const std::optional<uint32_t>& idx, uint32_t* ts_idx);
 
     bool ListContains(KeyEntry* entry, uint64_t time, DataBlock* row, bool check_all_time);
+    bool ContainsUnlock(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
     virtual bool PutUnlock(const Slice& key, uint64_t time, DataBlock* row, bool put_if_absent = false,
                            bool check_all_time = false);
@@ -44,15 +44,18 @@ int Snapshot::GenManifest(const SnapshotMeta& snapshot_meta) {
 
 int Snapshot::GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term) {
     DEBUGLOG("record offset[%lu]. add snapshot[%s] key_count[%lu]", offset, snapshot_name.c_str(), key_count);
-    std::string full_path = absl::StrCat(snapshot_path_, MANIFEST);
-    std::string tmp_file = absl::StrCat(snapshot_path_, MANIFEST, ".tmp");
     ::openmldb::api::Manifest manifest;
-    std::string manifest_info;
     manifest.set_offset(offset);
     manifest.set_name(snapshot_name);
     manifest.set_count(key_count);
     manifest.set_term(term);
-    manifest_info.clear();
+    return GenManifest(manifest);
+}
+
+int Snapshot::GenManifest(const ::openmldb::api::Manifest& manifest) {
+    std::string full_path = absl::StrCat(snapshot_path_, MANIFEST);
+    std::string tmp_file = absl::StrCat(snapshot_path_, MANIFEST, ".tmp");
+    std::string manifest_info;
     google::protobuf::TextFormat::PrintToString(manifest, &manifest_info);
     FILE* fd_write = fopen(tmp_file.c_str(), "w");
     if (fd_write == nullptr) {
@@ -93,6 +96,21 @@ int Snapshot::GetLocalManifest(const std::string& full_path, ::openmldb::api::Ma
     return 0;
 }
 
+std::vector<std::string> Snapshot::GetSnapshotFiles(const ::openmldb::api::Manifest& manifest) {
+    std::vector<std::string> files;
+    if (manifest.shard_size() > 0) {
+        for (const auto& shard : manifest.shard()) {
+            files.push_back(shard.name());
+        }
+    } else if (manifest.has_name()) {
+        files.push_back(manifest.name());
+    }
+    for (const auto& delta : manifest.delta()) {
+        files.push_back(delta.name());
+    }
+    return files;
+}
+
 ::openmldb::base::Status Snapshot::DecodeData(const std::shared_ptr<Table>& table,
         openmldb::base::Slice raw_data,
         const std::vector<uint32_t>& cols, std::vector<std::string>* row) {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -51,8 +52,11 @@ class Snapshot {
     uint64_t GetOffset() { return offset_; }
     int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
     int GenManifest(const SnapshotMeta& snapshot_meta);
+    int GenManifest(const ::openmldb::api::Manifest& manifest);
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
+    // the names of the files which make up the snapshot, the deltas are after the base files
+    static std::vector<std::string> GetSnapshotFiles(const ::openmldb::api::Manifest& manifest);
     std::string GetSnapshotPath() { return snapshot_path_; }
 
     ::openmldb::base::Status DecodeData(const std::shared_ptr<Table>& table, base::Slice raw_data,
@@ -61,7 +65,7 @@ class Snapshot {
     virtual base::Status ExtractIndexData(const std::shared_ptr<Table>& table,
             const std::vector<::openmldb::common::ColumnKey>& add_indexs,
             const std::vector<std::shared_ptr<::openmldb::log::WriteHandle>>& whs,
-            uint64_t offset, bool dump_data) = 0;
+            uint64_t offset, bool dump_data, const std::function<void(uint64_t)>& progress) = 0;
 
  protected:
     uint32_t tid_;
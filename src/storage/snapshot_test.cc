@@ -43,6 +43,9 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_shard_num);
+DECLARE_uint32(snapshot_max_delta_num);
+DECLARE_bool(snapshot_image_mapped);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -1839,6 +1842,544 @@ TEST_F(SnapshotTest, DeleteRange) {
     ASSERT_EQ(5, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeImageAndRecover) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/102_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/102_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("card", 0));
+    mapping.insert(std::make_pair("mcc", 1));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    // the row is put to table and then appended to binlog like the leader does
+    auto put = [&](int count, bool put_table) {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_ts(count + 1);
+        entry.set_value("value" + std::to_string(count));
+        entry.set_term(1);
+        ::openmldb::api::Dimension* d1 = entry.add_dimensions();
+        d1->set_key("card" + std::to_string(count % 4));
+        d1->set_idx(0);
+        ::openmldb::api::Dimension* d2 = entry.add_dimensions();
+        d2->set_key("mcc" + std::to_string(count % 3));
+        d2->set_idx(1);
+        if (put_table) {
+            ASSERT_TRUE(table->Put(entry));
+        }
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ASSERT_TRUE(wh->Write(slice).ok());
+    };
+    int count = 0;
+    for (; count < 20; count++) {
+        put(count, true);
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(20u, offset_value);
+    for (; count < 23; count++) {
+        put(count, true);
+    }
+    wh->Sync();
+    ASSERT_EQ(0, snapshot.MakeImage(table, [&] {
+        MemTableView view{offset, table->GetPutSeq()};
+        // the row put after the view is pinned is not dumped, it's recovered from binlog
+        put(count++, true);
+        return view;
+    }));
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(20u, manifest.offset());
+    ASSERT_EQ(23u, manifest.image_offset());
+    ASSERT_TRUE(::openmldb::base::IsExists(snapshot_dir + manifest.image_name()));
+    // the row is not put to table before the process exits
+    for (; count < 25; count++) {
+        put(count, false);
+    }
+    wh->Sync();
+
+    auto check = [&](std::shared_ptr<MemTable> recovered) {
+        ASSERT_EQ(25u, recovered->GetRecordCnt());
+        ASSERT_EQ(50u, recovered->GetRecordIdxCnt());
+        for (int i = 0; i < 4; i++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(recovered->NewIterator(0, "card" + std::to_string(i), ticket));
+            it->SeekToFirst();
+            int expect = 24 - (24 - i) % 4;
+            while (it->Valid()) {
+                ASSERT_EQ(static_cast<uint64_t>(expect + 1), it->GetKey());
+                ASSERT_EQ("value" + std::to_string(expect), it->GetValue().ToString());
+                expect -= 4;
+                it->Next();
+            }
+            ASSERT_LT(expect, 0);
+        }
+        for (int i = 0; i < 3; i++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(recovered->NewIterator(1, "mcc" + std::to_string(i), ticket));
+            it->SeekToFirst();
+            int expect = 24 - (24 - i) % 3;
+            while (it->Valid()) {
+                ASSERT_EQ(static_cast<uint64_t>(expect + 1), it->GetKey());
+                ASSERT_EQ("value" + std::to_string(expect), it->GetValue().ToString());
+                expect -= 3;
+                it->Next();
+            }
+            ASSERT_LT(expect, 0);
+        }
+    };
+    {
+        std::shared_ptr<MemTable> recovered =
+            std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        recovered->Init();
+        MemTableSnapshot recover_snapshot(102, 0, log_part, FLAGS_db_root_path);
+        recover_snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        uint64_t latest_offset = 0;
+        ASSERT_TRUE(recover_snapshot.Recover(recovered, snapshot_offset));
+        // the binlog is replayed after the offset of image
+        ASSERT_EQ(23u, snapshot_offset);
+        ASSERT_EQ(20u, recover_snapshot.GetOffset());
+        ASSERT_EQ(23u, recovered->GetRecordCnt());
+        Binlog binlog(log_part, binlog_dir);
+        binlog.RecoverFromBinlog(recovered, snapshot_offset, latest_offset);
+        ASSERT_EQ(25u, latest_offset);
+        check(recovered);
+    }
+    {
+        // the broken image is skipped and the table is recovered from the snapshot
+        std::string image_path = snapshot_dir + manifest.image_name();
+        uint64_t image_size = 0;
+        ASSERT_TRUE(::openmldb::base::GetFileSize(image_path, image_size));
+        ASSERT_EQ(0, truncate(image_path.c_str(), image_size / 2));
+        std::shared_ptr<MemTable> recovered =
+            std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        recovered->Init();
+        MemTableSnapshot recover_snapshot(102, 0, log_part, FLAGS_db_root_path);
+        recover_snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        uint64_t latest_offset = 0;
+        ASSERT_TRUE(recover_snapshot.Recover(recovered, snapshot_offset));
+        ASSERT_EQ(20u, snapshot_offset);
+        ASSERT_EQ(20u, recovered->GetRecordCnt());
+        Binlog binlog(log_part, binlog_dir);
+        binlog.RecoverFromBinlog(recovered, snapshot_offset, latest_offset);
+        check(recovered);
+    }
+    // a new snapshot removes the image
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_FALSE(::openmldb::base::IsExists(snapshot_dir + manifest.image_name()));
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_FALSE(manifest.has_image_name());
+}
+
+TEST_F(SnapshotTest, MakeMappedImageAndRecover) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/106_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/106_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("card", 0));
+    mapping.insert(std::make_pair("mcc", 1));
+    auto new_table = [&mapping]() {
+        auto table = std::make_shared<MemTable>("test", 106, 0, 8, mapping, 0,
+                                                ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        return table;
+    };
+    auto table = new_table();
+    for (int count = 0; count < 20; count++) {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_ts(count + 1);
+        entry.set_value("value" + std::to_string(count));
+        entry.set_term(1);
+        ::openmldb::api::Dimension* d1 = entry.add_dimensions();
+        d1->set_key("card" + std::to_string(count % 4));
+        d1->set_idx(0);
+        ::openmldb::api::Dimension* d2 = entry.add_dimensions();
+        d2->set_key("mcc" + std::to_string(count % 3));
+        d2->set_idx(1);
+        ASSERT_TRUE(table->Put(entry));
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    wh->Sync();
+    MemTableSnapshot snapshot(106, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    FLAGS_snapshot_image_mapped = true;
+    ASSERT_EQ(0, snapshot.MakeImage(table, [&] { return MemTableView{offset, table->GetPutSeq()}; }));
+    FLAGS_snapshot_image_mapped = false;
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    std::string rows_path = snapshot_dir + manifest.image_name() + ".rows";
+    uint64_t rows_size = 0;
+    ASSERT_TRUE(::openmldb::base::GetFileSize(rows_path, rows_size));
+    // the row shared by two indexes is written once
+    ASSERT_EQ(130u, rows_size);
+    {
+        auto recovered = new_table();
+        MemTableSnapshot recover_snapshot(106, 0, log_part, FLAGS_db_root_path);
+        recover_snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(recover_snapshot.Recover(recovered, snapshot_offset));
+        ASSERT_EQ(20u, snapshot_offset);
+        ASSERT_EQ(20u, recovered->GetRecordCnt());
+        ASSERT_EQ(40u, recovered->GetRecordIdxCnt());
+        // the rows are readable after the files are removed
+        ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+        ASSERT_FALSE(::openmldb::base::IsExists(rows_path));
+        for (int i = 0; i < 4; i++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(recovered->NewIterator(0, "card" + std::to_string(i), ticket));
+            it->SeekToFirst();
+            int expect = 19 - (19 - i) % 4;
+            while (it->Valid()) {
+                ASSERT_EQ(static_cast<uint64_t>(expect + 1), it->GetKey());
+                ASSERT_EQ("value" + std::to_string(expect), it->GetValue().ToString());
+                expect -= 4;
+                it->Next();
+            }
+            ASSERT_LT(expect, 0);
+        }
+        // the mapped rows are released without being freed
+        ::openmldb::api::LogEntry entry;
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        auto dimension = entry.add_dimensions();
+        dimension->set_key("card0");
+        dimension->set_idx(0);
+        ASSERT_TRUE(recovered->Delete(entry));
+        recovered->SchedGc();
+        recovered->SchedGc();
+    }
+}
+
+TEST_F(SnapshotTest, MakeShardedSnapshot) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/103_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/103_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    auto write_entries = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                       "value" + std::to_string(count), count + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+        wh->Sync();
+    };
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    auto new_table = [&mapping]() {
+        auto table = std::make_shared<MemTable>("test", 103, 0, 8, mapping, 0,
+                                                ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        return table;
+    };
+    auto recover = [&](uint64_t expect_cnt) {
+        auto table = new_table();
+        MemTableSnapshot snapshot(103, 0, log_part, FLAGS_db_root_path);
+        snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(snapshot.Recover(table, snapshot_offset));
+        ASSERT_EQ(offset, snapshot_offset);
+        ASSERT_EQ(expect_cnt, table->GetRecordCnt());
+    };
+    FLAGS_snapshot_shard_num = 4;
+    write_entries(0, 100);
+    auto table = new_table();
+    MemTableSnapshot snapshot(103, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(8u, manifest.seg_cnt());
+    ASSERT_EQ(4, manifest.shard_size());
+    uint64_t total = 0;
+    for (int idx = 0; idx < manifest.shard_size(); idx++) {
+        auto reader = DataReader::CreateShardReader(snapshot_dir, manifest.shard(idx).name());
+        ASSERT_TRUE(reader);
+        uint64_t count = 0;
+        while (reader->HasNext()) {
+            ASSERT_EQ(static_cast<uint32_t>(idx), SnapshotShardWriter::GetShard(reader->GetValue(), 8, 4));
+            count++;
+        }
+        ASSERT_EQ(manifest.shard(idx).count(), count);
+        total += count;
+    }
+    ASSERT_EQ(100u, total);
+    recover(100);
+
+    // the shards of old snapshot are filtered in parallel
+    write_entries(100, 150);
+    {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key("key0");
+        dimension->set_idx(0);
+        entry.set_term(1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        wh->Sync();
+    }
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    std::vector<std::string> old_files = Snapshot::GetSnapshotFiles(manifest);
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(135u, manifest.count());
+    ASSERT_EQ(4, manifest.shard_size());
+    for (const auto& file : old_files) {
+        ASSERT_FALSE(::openmldb::base::IsExists(snapshot_dir + file));
+    }
+    for (const auto& file : Snapshot::GetSnapshotFiles(manifest)) {
+        ASSERT_TRUE(::openmldb::base::IsExists(snapshot_dir + file));
+    }
+    recover(135);
+    auto data_reader = DataReader::CreateDataReader(snapshot_dir, nullptr, "", DataReaderType::kSnapshot);
+    ASSERT_TRUE(data_reader);
+    total = 0;
+    while (data_reader->HasNext()) {
+        total++;
+    }
+    ASSERT_EQ(135u, total);
+
+    // a sharded snapshot can be merged into a single file
+    FLAGS_snapshot_shard_num = 1;
+    write_entries(150, 160);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(145u, manifest.count());
+    ASSERT_EQ(0, manifest.shard_size());
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_dir, vec));
+    ASSERT_EQ(2u, vec.size());
+    recover(145);
+}
+
+TEST_F(SnapshotTest, MakeDeltaSnapshot) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/104_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/104_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    auto write_entries = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                       "value" + std::to_string(count), count + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        }
+        wh->Sync();
+    };
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    auto new_table = [&mapping]() {
+        auto table = std::make_shared<MemTable>("test", 104, 0, 8, mapping, 0,
+                                                ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        return table;
+    };
+    auto count_key = [](std::shared_ptr<MemTable> table, const std::string& key) {
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator(0, key, ticket));
+        uint32_t count = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            count++;
+        }
+        return count;
+    };
+    auto recover = [&](uint32_t key0_cnt, uint32_t key1_cnt) {
+        auto table = new_table();
+        MemTableSnapshot snapshot(104, 0, log_part, FLAGS_db_root_path);
+        snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(snapshot.Recover(table, snapshot_offset));
+        ASSERT_EQ(offset, snapshot_offset);
+        ASSERT_EQ(key0_cnt, count_key(table, "key0"));
+        ASSERT_EQ(key1_cnt, count_key(table, "key1"));
+    };
+    FLAGS_snapshot_max_delta_num = 2;
+    write_entries(0, 100);
+    auto table = new_table();
+    MemTableSnapshot snapshot(104, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    uint64_t offset_value = 0;
+    // the first snapshot is a base one
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(0, manifest.delta_size());
+    std::string base_name = manifest.name();
+
+    // the new rows and the delete entry are written to a delta, the base snapshot is not rewritten
+    write_entries(100, 120);
+    {
+        offset++;
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(offset);
+        entry.set_method_type(::openmldb::api::MethodType::kDelete);
+        ::openmldb::api::Dimension* dimension = entry.add_dimensions();
+        dimension->set_key("key0");
+        dimension->set_idx(0);
+        entry.set_term(1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+        wh->Sync();
+    }
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(offset, offset_value);
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(base_name, manifest.name());
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(offset, manifest.offset());
+    ASSERT_EQ(1, manifest.delta_size());
+    ASSERT_EQ(21u, manifest.delta(0).count());
+    ASSERT_EQ(offset, manifest.delta(0).offset());
+    recover(0, 12);
+
+    write_entries(120, 130);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(2, manifest.delta_size());
+    ASSERT_EQ(10u, manifest.delta(1).count());
+    std::vector<std::string> old_files = Snapshot::GetSnapshotFiles(manifest);
+    ASSERT_EQ(3u, old_files.size());
+    for (const auto& file : old_files) {
+        ASSERT_TRUE(::openmldb::base::IsExists(snapshot_dir + file));
+    }
+    recover(1, 13);
+
+    // the deltas reach the limit, they are merged into a new base snapshot
+    write_entries(130, 140);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(0, manifest.delta_size());
+    ASSERT_EQ(128u, manifest.count());
+    ASSERT_EQ(offset, manifest.offset());
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_dir, vec));
+    ASSERT_EQ(2u, vec.size());
+    recover(2, 14);
+    FLAGS_snapshot_max_delta_num = 0;
+}
+
+TEST_F(SnapshotTest, MakeSnapshotFromMemory) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/105_0/snapshot/";
+    std::string binlog_dir = FLAGS_db_root_path + "/105_0/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    auto new_table = [&mapping]() {
+        auto table = std::make_shared<MemTable>("test", 105, 0, 8, mapping, 0,
+                                                ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        return table;
+    };
+    auto table = new_table();
+    auto write_entries = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            offset++;
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count % 10),
+                                                       "value" + std::to_string(count), count + 1, 1);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+            ASSERT_TRUE(table->Put(entry));
+        }
+        wh->Sync();
+    };
+    auto recover = [&](uint32_t key_cnt) {
+        auto new_tb = new_table();
+        MemTableSnapshot snapshot(105, 0, log_part, FLAGS_db_root_path);
+        snapshot.Init();
+        uint64_t snapshot_offset = 0;
+        ASSERT_TRUE(snapshot.Recover(new_tb, snapshot_offset));
+        Binlog binlog(log_part, binlog_dir);
+        uint64_t latest_offset = 0;
+        ASSERT_TRUE(binlog.RecoverFromBinlog(new_tb, snapshot_offset, latest_offset));
+        ASSERT_EQ(offset, latest_offset);
+        for (int idx = 0; idx < 10; idx++) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(new_tb->NewIterator(0, "key" + std::to_string(idx), ticket));
+            uint32_t count = 0;
+            for (it->SeekToFirst(); it->Valid(); it->Next()) {
+                count++;
+            }
+            ASSERT_EQ(key_cnt, count);
+        }
+    };
+    write_entries(0, 100);
+    MemTableSnapshot snapshot(105, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    uint64_t offset_value = 0;
+    // the rows put after the view are not dumped, they are replayed from the binlog after the snapshot
+    auto pin_view = [&] {
+        MemTableView view{offset, table->GetPutSeq()};
+        write_entries(100, 110);
+        return view;
+    };
+    ASSERT_EQ(0, snapshot.MakeSnapshotFromMemory(table, pin_view, 1, offset_value));
+    ASSERT_EQ(100u, offset_value);
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(100u, manifest.count());
+    ASSERT_EQ(100u, manifest.offset());
+    recover(11);
+
+    // the rows with the same key, ts and value as the old ones are kept
+    write_entries(0, 10);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(offset, offset_value);
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_dir + "MANIFEST", &manifest));
+    ASSERT_EQ(120u, manifest.count());
+    recover(12);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -78,6 +78,11 @@ class Table {
 
     virtual bool IsExpire(const ::openmldb::api::LogEntry& entry) = 0;
 
+    // the rows expired are skipped by IsExpireOnRecover between BeginRecover and EndRecover
+    virtual void BeginRecover() {}
+    virtual void EndRecover() {}
+    virtual bool IsExpireOnRecover(const ::openmldb::api::LogEntry& entry) { return false; }
+
     virtual uint64_t GetExpireTime(const TTLSt& ttl_st) = 0;
 
     inline std::string GetName() const { return name_; }
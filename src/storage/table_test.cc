@@ -209,6 +209,40 @@ TEST_P(TableTest, MultiDimissionPut0) {
     delete table;
 }
 
+TEST_P(TableTest, PutIfAbsentToAllIndexes) {
+    ::openmldb::common::StorageMode storageMode = GetParam();
+    if (storageMode != ::openmldb::common::kMemory) {
+        // disk table updates the row of the same key and time
+        return;
+    }
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    mapping.insert(std::make_pair("idx1", 1));
+    std::unique_ptr<Table> table(
+        CreateTable("tx_log", 1, 1, 8, mapping, 10, ::openmldb::type::kAbsoluteTime, "", storageMode));
+    table->Init();
+    auto meta = ::openmldb::test::GetTableMeta({"idx0", "idx1"});
+    ::openmldb::codec::SDKCodec sdk_codec(meta);
+    std::string row;
+    sdk_codec.EncodeRow({"d0", "d1"}, &row);
+    Dimensions dimensions;
+    ::openmldb::api::Dimension* d1 = dimensions.Add();
+    d1->set_key("d1");
+    d1->set_idx(1);
+    ASSERT_TRUE(table->Put(1, row, dimensions).ok());
+    ASSERT_EQ(0u, table->GetRecordIdxCnt());
+    ::openmldb::api::Dimension* d0 = dimensions.Add();
+    d0->set_key("d0");
+    d0->set_idx(0);
+    // the row exists in the second index, so it's put to none of the indexes
+    ASSERT_TRUE(absl::IsAlreadyExists(table->Put(1, row, dimensions, true)));
+    ASSERT_EQ(0u, table->GetRecordIdxCnt());
+    std::string new_row;
+    sdk_codec.EncodeRow({"d0", "d2"}, &new_row);
+    ASSERT_TRUE(table->Put(2, new_row, dimensions, true).ok());
+    ASSERT_EQ(1u, table->GetRecordIdxCnt());
+}
+
 TEST_P(TableTest, IsExpired) {
     ::openmldb::common::StorageMode storageMode = GetParam();
     std::map<std::string, uint32_t> mapping;
@@ -1625,6 +1659,43 @@ TEST_F(TableTest, Release) {
     delete table;
 }
 
+TEST_F(TableTest, IsExpireOnRecover) {
+    std::map<std::string, uint32_t> mapping = {{"idx0", 0}};
+    auto new_entry = [](const std::string& key, uint64_t ts) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_pk(key);
+        entry.set_ts(ts);
+        entry.set_value(::openmldb::test::EncodeKV(key, "value"));
+        return entry;
+    };
+    {
+        // keep the latest 2 rows
+        MemTable table("tx_log", 1, 1, 8, mapping, 2, ::openmldb::type::kLatestTime);
+        table.Init();
+        table.BeginRecover();
+        for (uint64_t ts : {10, 30, 20}) {
+            auto entry = new_entry("test", ts);
+            ASSERT_FALSE(table.IsExpireOnRecover(entry));
+            ASSERT_TRUE(table.Put(entry.pk(), entry.ts(), entry.value().data(), entry.value().size()));
+        }
+        // there are 2 newer rows, but a delete loaded later may remove them, so latest ttl is not checked
+        ASSERT_FALSE(table.IsExpireOnRecover(new_entry("test", 15)));
+        table.EndRecover();
+    }
+    {
+        // ttl is 10 minutes
+        MemTable table("tx_log", 1, 1, 8, mapping, 10, ::openmldb::type::kAbsoluteTime);
+        table.Init();
+        uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+        table.BeginRecover();
+        ASSERT_TRUE(table.IsExpireOnRecover(new_entry("test", now - 20 * 60 * 1000)));
+        ASSERT_FALSE(table.IsExpireOnRecover(new_entry("test", now)));
+        table.SetExpire(false);
+        ASSERT_FALSE(table.IsExpireOnRecover(new_entry("test", now - 20 * 60 * 1000)));
+        table.EndRecover();
+    }
+}
+
 TEST_P(TableTest, TSColIDLength) {
     ::openmldb::common::StorageMode storageMode = GetParam();
     ::openmldb::api::TableMeta table_meta;
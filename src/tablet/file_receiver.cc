@@ -16,15 +16,28 @@
 
 #include "tablet/file_receiver.h"
 
+#include <unistd.h>
+
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "base/strings.h"
+#include "gflags/gflags.h"
+
+DECLARE_uint32(stream_checkpoint_interval);
 
 namespace openmldb {
 namespace tablet {
 
 FileReceiver::FileReceiver(const std::string& file_name, const std::string& dir_name, const std::string& path)
-    : file_name_(file_name), dir_name_(dir_name), path_(path), size_(0), block_id_(0), file_(NULL) {}
+    : file_name_(file_name),
+      dir_name_(dir_name),
+      path_(path),
+      size_(0),
+      block_id_(0),
+      file_(NULL),
+      file_size_(0),
+      received_size_(0),
+      checkpoint_size_(0) {}
 
 FileReceiver::~FileReceiver() {
     if (file_) fclose(file_);
@@ -43,6 +56,7 @@ bool FileReceiver::Init() {
         return false;
     }
     std::string full_path = path_ + file_name_ + ".tmp";
+    unlink(GetCheckpointPath().c_str());
     FILE* file = fopen(full_path.c_str(), "wb");
     if (file == NULL) {
         PDLOG(WARNING, "fail to open file %s", full_path.c_str());
@@ -80,9 +94,137 @@ int FileReceiver::WriteData(const std::string& data, uint64_t block_id) {
     return 0;
 }
 
+bool FileReceiver::Init(uint64_t file_size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (file_ && file_size_ == file_size && received_size_ > 0) {
+        // the sender retries, continue with the data received in memory
+        PDLOG(INFO, "resume file %s%s from %lu, file size %lu", path_.c_str(), file_name_.c_str(), received_size_,
+              file_size);
+        block_id_ = 0;
+        pending_blocks_.clear();
+        return true;
+    }
+    if (file_) {
+        fclose(file_);
+        file_ = NULL;
+    }
+    if (path_.back() != '/') {
+        path_.append("/");
+    }
+    if (!::openmldb::base::MkdirRecur(path_)) {
+        PDLOG(WARNING, "mkdir failed! path[%s]", path_.c_str());
+        return false;
+    }
+    std::string full_path = path_ + file_name_ + ".tmp";
+    uint64_t received_size = 0;
+    FILE* checkpoint = fopen(GetCheckpointPath().c_str(), "r");
+    if (checkpoint != NULL) {
+        uint64_t checkpoint_file_size = 0;
+        uint64_t checkpoint_size = 0;
+        if (fscanf(checkpoint, "%lu %lu", &checkpoint_file_size, &checkpoint_size) == 2 &&
+            checkpoint_file_size == file_size && checkpoint_size <= file_size &&
+            ::openmldb::base::IsExists(full_path)) {
+            received_size = checkpoint_size;
+        }
+        fclose(checkpoint);
+    }
+    if (received_size == 0) {
+        unlink(GetCheckpointPath().c_str());
+    }
+    // keep the data of the broken transfer, or truncate the tmp file
+    FILE* file = fopen(full_path.c_str(), received_size > 0 ? "r+b" : "wb");
+    if (file == NULL) {
+        PDLOG(WARNING, "fail to open file %s", full_path.c_str());
+        return false;
+    }
+    if (received_size > 0) {
+        PDLOG(INFO, "resume file %s from %lu, file size %lu", full_path.c_str(), received_size, file_size);
+    }
+    file_ = file;
+    block_id_ = 0;
+    file_size_ = file_size;
+    received_size_ = received_size;
+    checkpoint_size_ = received_size;
+    size_ = received_size;
+    pending_blocks_.clear();
+    return true;
+}
+
+uint64_t FileReceiver::GetReceivedSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return received_size_;
+}
+
+int FileReceiver::WriteBlock(uint64_t offset, butil::IOBuf* data) {
+    uint64_t len = data->size();
+    std::lock_guard<std::mutex> lock(mu_);
+    if (file_ == NULL) {
+        PDLOG(WARNING, "file is NULL");
+        return -1;
+    }
+    if (offset + len > file_size_) {
+        PDLOG(WARNING, "block [%lu, %lu) exceeds file size %lu. name %s%s", offset, offset + len, file_size_,
+              path_.c_str(), file_name_.c_str());
+        return -1;
+    }
+    if (offset + len <= received_size_) {
+        DEBUGLOG("block at offset %lu has been received", offset);
+        return 0;
+    }
+    // the file is only written by pwrite in the pipelined transfer
+    int fd = fileno(file_);
+    uint64_t cur_offset = offset;
+    while (!data->empty()) {
+        ssize_t r = data->pcut_into_file_descriptor(fd, cur_offset);
+        if (r < 0) {
+            PDLOG(WARNING, "write error. name %s%s, errno %d", path_.c_str(), file_name_.c_str(), errno);
+            return -1;
+        }
+        cur_offset += r;
+    }
+    pending_blocks_[offset] = offset + len;
+    auto iter = pending_blocks_.begin();
+    while (iter != pending_blocks_.end() && iter->first <= received_size_) {
+        if (iter->second > received_size_) {
+            size_ += iter->second - received_size_;
+            received_size_ = iter->second;
+        }
+        iter = pending_blocks_.erase(iter);
+    }
+    if (received_size_ - checkpoint_size_ >= FLAGS_stream_checkpoint_interval && received_size_ < file_size_) {
+        Checkpoint();
+    }
+    return 0;
+}
+
+std::string FileReceiver::GetCheckpointPath() const { return path_ + file_name_ + ".tmp.checkpoint"; }
+
+void FileReceiver::Checkpoint() {
+    // the data must be on disk before the checkpoint says it is received
+    if (fdatasync(fileno(file_)) != 0) {
+        PDLOG(WARNING, "fail to sync file %s%s, errno %d", path_.c_str(), file_name_.c_str(), errno);
+        return;
+    }
+    std::string checkpoint_path = GetCheckpointPath();
+    std::string tmp_path = checkpoint_path + ".tmp";
+    FILE* checkpoint = fopen(tmp_path.c_str(), "w");
+    if (checkpoint == NULL) {
+        PDLOG(WARNING, "fail to open file %s", tmp_path.c_str());
+        return;
+    }
+    bool ok = fprintf(checkpoint, "%lu %lu\n", file_size_, received_size_) > 0;
+    ok = fclose(checkpoint) == 0 && ok;
+    if (!ok || rename(tmp_path.c_str(), checkpoint_path.c_str()) != 0) {
+        PDLOG(WARNING, "fail to write checkpoint %s", checkpoint_path.c_str());
+        return;
+    }
+    checkpoint_size_ = received_size_;
+}
+
 void FileReceiver::SaveFile() {
     std::string full_path = path_ + file_name_;
     std::string tmp_file_path = full_path + ".tmp";
+    unlink(GetCheckpointPath().c_str());
     if (::openmldb::base::IsExists(full_path)) {
         std::string backup_file = full_path + "." + ::openmldb::base::GetNowTime();
         rename(full_path.c_str(), backup_file.c_str());
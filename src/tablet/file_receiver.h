@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <string>
 
+#include "butil/iobuf.h"
+
 namespace openmldb {
 namespace tablet {
 
@@ -32,13 +36,31 @@ class FileReceiver {
     void SaveFile();
     uint64_t GetBlockId();
 
+    // init for the pipelined transfer. if the tmp file of a broken transfer with the same
+    // file size exists, the data received continuously from the start of file is kept
+    bool Init(uint64_t file_size);
+    // write the block at offset. blocks can be written in any order
+    int WriteBlock(uint64_t offset, butil::IOBuf* data);
+    // the size of the data received continuously from the start of file
+    uint64_t GetReceivedSize();
+
  private:
+    std::string GetCheckpointPath() const;
+    void Checkpoint();
+
     std::string file_name_;
     std::string dir_name_;
     std::string path_;
     uint64_t size_;
     uint64_t block_id_;
     FILE* file_;
+
+    std::mutex mu_;
+    uint64_t file_size_;
+    uint64_t received_size_;
+    uint64_t checkpoint_size_;
+    // the blocks received after received_size_, offset -> end
+    std::map<uint64_t, uint64_t> pending_blocks_;
 };
 
 }  // namespace tablet
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/file_receiver.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "base/file_util.h"
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "test/util.h"
+
+DECLARE_uint32(stream_checkpoint_interval);
+
+namespace openmldb::tablet {
+
+class FileReceiverTest : public ::testing::Test {
+ protected:
+    ::openmldb::test::TempPath tmp_path_;
+};
+
+static std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static int WriteBlock(FileReceiver* receiver, const std::string& data, uint64_t offset, uint64_t len) {
+    butil::IOBuf buf;
+    buf.append(data.data() + offset, len);
+    return receiver->WriteBlock(offset, &buf);
+}
+
+TEST_F(FileReceiverTest, OutOfOrder) {
+    std::string path = tmp_path_.GetTempPath();
+    std::string data(1000, 'a');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    FileReceiver receiver("data", "", path);
+    ASSERT_TRUE(receiver.Init(data.size()));
+    ASSERT_EQ(0u, receiver.GetReceivedSize());
+    ASSERT_EQ(0, WriteBlock(&receiver, data, 300, 300));
+    ASSERT_EQ(0u, receiver.GetReceivedSize());
+    ASSERT_EQ(0, WriteBlock(&receiver, data, 600, 400));
+    ASSERT_EQ(0, WriteBlock(&receiver, data, 0, 300));
+    ASSERT_EQ(1000u, receiver.GetReceivedSize());
+    // duplicate block
+    ASSERT_EQ(0, WriteBlock(&receiver, data, 300, 300));
+    // exceed the file size
+    butil::IOBuf buf;
+    buf.append("b");
+    ASSERT_EQ(-1, receiver.WriteBlock(1000, &buf));
+    receiver.SaveFile();
+    ASSERT_EQ(data, ReadFile(path + "/data"));
+}
+
+TEST_F(FileReceiverTest, Resume) {
+    FLAGS_stream_checkpoint_interval = 100;
+    std::string path = tmp_path_.GetTempPath();
+    std::string data(1000, 'x');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    {
+        auto receiver = std::make_shared<FileReceiver>("data", "", path);
+        ASSERT_TRUE(receiver->Init(data.size()));
+        ASSERT_EQ(0, WriteBlock(receiver.get(), data, 0, 200));
+        ASSERT_EQ(0, WriteBlock(receiver.get(), data, 200, 50));
+        ASSERT_EQ(250u, receiver->GetReceivedSize());
+        // retry with the same receiver
+        ASSERT_TRUE(receiver->Init(data.size()));
+        ASSERT_EQ(250u, receiver->GetReceivedSize());
+    }
+    {
+        // the receiver restarts, resume from the checkpoint
+        FileReceiver receiver("data", "", path);
+        ASSERT_TRUE(receiver.Init(data.size()));
+        ASSERT_EQ(200u, receiver.GetReceivedSize());
+        ASSERT_EQ(0, WriteBlock(&receiver, data, 200, 800));
+        ASSERT_EQ(1000u, receiver.GetReceivedSize());
+        receiver.SaveFile();
+        ASSERT_EQ(data, ReadFile(path + "/data"));
+        ASSERT_FALSE(::openmldb::base::IsExists(path + "/data.tmp.checkpoint"));
+    }
+    {
+        // the checkpoint of another file size is not used
+        FileReceiver receiver("data", "", path);
+        ASSERT_TRUE(receiver.Init(data.size()));
+        ASSERT_EQ(0, WriteBlock(&receiver, data, 0, 500));
+        FileReceiver receiver2("data", "", path);
+        ASSERT_TRUE(receiver2.Init(data.size() + 1));
+        ASSERT_EQ(0u, receiver2.GetReceivedSize());
+    }
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -16,12 +16,19 @@
 
 #include "tablet/file_sender.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "base/file_util.h"
 #include "base/glog_wrapper.h"
 #include "boost/algorithm/string/predicate.hpp"
+#include "butil/iobuf.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "nameserver/system_table.h"
@@ -29,9 +36,9 @@
 DECLARE_int32(send_file_max_try);
 DECLARE_uint32(stream_block_size);
 DECLARE_int32(stream_bandwidth_limit);
-DECLARE_uint32(stream_block_size);
-DECLARE_int32(stream_bandwidth_limit);
 DECLARE_int32(stream_close_wait_time_ms);
+DECLARE_uint32(stream_send_window);
+DECLARE_uint32(stream_send_file_concurrency);
 DECLARE_int32(retry_send_file_wait_time_ms);
 DECLARE_int32(request_max_retry);
 DECLARE_int32(request_timeout_ms);
@@ -39,6 +46,53 @@ DECLARE_int32(request_timeout_ms);
 namespace openmldb {
 namespace tablet {
 
+namespace {
+
+// the requests in flight of a pipelined transfer
+struct SendWindow {
+    std::mutex mu;
+    std::condition_variable cv;
+    uint32_t in_flight = 0;
+    bool failed = false;
+};
+
+class SendBlockClosure : public google::protobuf::Closure {
+ public:
+    explicit SendBlockClosure(SendWindow* window) : window_(window) {}
+
+    void Run() override {
+        bool ok = true;
+        if (cntl.Failed()) {
+            PDLOG(WARNING, "send data failed. tid %u pid %u file %s block %lu error msg %s", request.tid(),
+                  request.pid(), request.file_name().c_str(), request.block_id(), cntl.ErrorText().c_str());
+            ok = false;
+        } else if (response.code() != 0) {
+            PDLOG(WARNING, "send data failed. tid %u pid %u file %s block %lu error msg %s", request.tid(),
+                  request.pid(), request.file_name().c_str(), request.block_id(), response.msg().c_str());
+            ok = false;
+        }
+        {
+            // notify under the lock, the window may be destroyed once the waiter sees no request in flight
+            std::lock_guard<std::mutex> lock(window_->mu);
+            window_->in_flight--;
+            if (!ok) {
+                window_->failed = true;
+            }
+            window_->cv.notify_all();
+        }
+        delete this;
+    }
+
+    brpc::Controller cntl;
+    ::openmldb::api::SendDataRequest request;
+    ::openmldb::api::SendDataResponse response;
+
+ private:
+    SendWindow* window_;
+};
+
+}  // namespace
+
 FileSender::FileSender(uint32_t tid, uint32_t pid, common::StorageMode storage_mode, const std::string& endpoint)
     : tid_(tid),
       pid_(pid),
@@ -46,9 +100,9 @@ FileSender::FileSender(uint32_t tid, uint32_t pid, common::StorageMode storage_m
       endpoint_(endpoint),
       cur_try_time_(0),
       max_try_time_(FLAGS_send_file_max_try),
-      limit_time_(0),
       channel_(NULL),
-      stub_(NULL) {}
+      stub_(NULL),
+      next_send_time_(0) {}
 
 FileSender::~FileSender() {
     delete channel_;
@@ -56,12 +110,6 @@ FileSender::~FileSender() {
 }
 
 bool FileSender::Init() {
-    // compute the used time(microseconds) that send a block by limit bandwidth.
-    // limit_time = (FLAGS_stream_block_size / FLAGS_stream_bandwidth_limit) *
-    // 1000 * 1000
-    if (FLAGS_stream_bandwidth_limit > 0) {
-        limit_time_ = (FLAGS_stream_block_size * 1000000) / FLAGS_stream_bandwidth_limit;
-    }
     channel_ = new brpc::Channel();
     brpc::ChannelOptions options;
     options.auth = &client_authenticator_;
@@ -76,21 +124,51 @@ bool FileSender::Init() {
     return true;
 }
 
+void FileSender::LimitBandwidth(uint64_t len) {
+    if (governor_ != nullptr) {
+        governor_->ThrottleIO(WorkClass::kBackground, len);
+    }
+    if (FLAGS_stream_bandwidth_limit <= 0) {
+        return;
+    }
+    // the used time(microseconds) that send len bytes by limit bandwidth
+    uint64_t limit_time = len * 1000000 / FLAGS_stream_bandwidth_limit;
+    uint64_t sleep_time = 0;
+    {
+        std::lock_guard<std::mutex> lock(limit_mu_);
+        uint64_t cur_time = ::baidu::common::timer::get_micros();
+        if (next_send_time_ < cur_time) {
+            next_send_time_ = cur_time;
+        }
+        sleep_time = next_send_time_ - cur_time;
+        next_send_time_ += limit_time;
+    }
+    if (sleep_time > 0) {
+        DEBUGLOG("sleep %lu us, limit_time %lu", sleep_time, limit_time);
+        std::this_thread::sleep_for(std::chrono::microseconds(sleep_time));
+    }
+}
+
+void FileSender::BuildRequest(const std::string& file_name, const std::string& dir_name, uint64_t block_id,
+                              ::openmldb::api::SendDataRequest* request) {
+    request->set_tid(tid_);
+    request->set_pid(pid_);
+    request->set_storage_mode(storage_mode_);
+    request->set_file_name(file_name);
+    if (!dir_name.empty()) {
+        request->set_dir_name(dir_name);
+    }
+    request->set_block_id(block_id);
+}
+
 int FileSender::WriteData(const std::string& file_name, const std::string& dir_name, const char* buffer, size_t len,
                           uint64_t block_id) {
     if (buffer == NULL) {
         return -1;
     }
-    uint64_t cur_time = ::baidu::common::timer::get_micros();
+    LimitBandwidth(len);
     ::openmldb::api::SendDataRequest request;
-    request.set_tid(tid_);
-    request.set_pid(pid_);
-    request.set_storage_mode(storage_mode_);
-    request.set_file_name(file_name);
-    if (!dir_name.empty()) {
-        request.set_dir_name(dir_name);
-    }
-    request.set_block_id(block_id);
+    BuildRequest(file_name, dir_name, block_id, &request);
     request.set_block_size(len);
     brpc::Controller cntl;
     if (block_id > 0) {
@@ -99,7 +177,7 @@ int FileSender::WriteData(const std::string& file_name, const std::string& dir_n
     if (len > 0 && len < FLAGS_stream_block_size) {
         request.set_eof(true);
     }
-    ::openmldb::api::GeneralResponse response;
+    ::openmldb::api::SendDataResponse response;
     stub_->SendData(&cntl, &request, &response, NULL);
     if (cntl.Failed()) {
         PDLOG(WARNING, "send data failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
@@ -110,12 +188,31 @@ int FileSender::WriteData(const std::string& file_name, const std::string& dir_n
               response.msg().c_str());
         return -1;
     }
-    uint64_t time_used = ::baidu::common::timer::get_micros() - cur_time;
-    if (limit_time_ > time_used && len > FLAGS_stream_block_size / 2) {
-        uint64_t sleep_time = limit_time_ - time_used;
-        DEBUGLOG("sleep %lu us, limit_time %lu time_used %lu", sleep_time, limit_time_, time_used);
-        std::this_thread::sleep_for(std::chrono::microseconds(sleep_time));
+    return 0;
+}
+
+int FileSender::InitReceiver(const std::string& file_name, const std::string& dir_name, uint64_t file_size,
+                             bool* pipelined, uint64_t* received_size) {
+    ::openmldb::api::SendDataRequest request;
+    BuildRequest(file_name, dir_name, 0, &request);
+    request.set_block_size(0);
+    request.set_offset(0);
+    request.set_file_size(file_size);
+    brpc::Controller cntl;
+    ::openmldb::api::SendDataResponse response;
+    stub_->SendData(&cntl, &request, &response, NULL);
+    if (cntl.Failed()) {
+        PDLOG(WARNING, "send data failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
+              cntl.ErrorText().c_str());
+        return -1;
+    } else if (response.code() != 0) {
+        PDLOG(WARNING, "send data failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
+              response.msg().c_str());
+        return -1;
     }
+    // the receiver of old version ignores offset and does not return received_size
+    *pipelined = response.has_received_size();
+    *received_size = response.received_size();
     return 0;
 }
 
@@ -161,6 +258,17 @@ int FileSender::SendFileInternal(const std::string& file_name, const std::string
         PDLOG(WARNING, "fail to open file %s", full_path.c_str());
         return -1;
     }
+    bool pipelined = false;
+    uint64_t received_size = 0;
+    if (InitReceiver(file_name, dir_name, file_size, &pipelined, &received_size) < 0) {
+        PDLOG(WARNING, "Init file receiver failed. tid[%u] pid[%u] file %s", tid_, pid_, file_name.c_str());
+        fclose(file);
+        return -1;
+    }
+    if (pipelined) {
+        fclose(file);
+        return SendFilePipelined(file_name, dir_name, full_path, file_size, received_size);
+    }
     char buffer[FLAGS_stream_block_size];
 
     uint64_t block_num = file_size / FLAGS_stream_block_size + 1;
@@ -168,11 +276,6 @@ int FileSender::SendFileInternal(const std::string& file_name, const std::string
     int ret = 0;
     uint64_t block_count = 0;
     do {
-        if (block_count == 0 && WriteData(file_name, dir_name, buffer, 0, block_count) < 0) {
-            PDLOG(WARNING, "Init file receiver failed. tid[%u] pid[%u] file %s", tid_, pid_, file_name.c_str());
-            ret = -1;
-            break;
-        }
         block_count++;
 
 #ifdef __APPLE__
@@ -208,6 +311,98 @@ int FileSender::SendFileInternal(const std::string& file_name, const std::string
     return ret;
 }
 
+int FileSender::SendFilePipelined(const std::string& file_name, const std::string& dir_name,
+                                  const std::string& full_path, uint64_t file_size, uint64_t offset) {
+    int fd = open(full_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to open file %s", full_path.c_str());
+        return -1;
+    }
+    if (offset > 0) {
+        PDLOG(INFO, "resume sending file %s from %lu. tid[%u] pid[%u] endpoint[%s]", full_path.c_str(), offset, tid_,
+              pid_, endpoint_.c_str());
+    }
+    uint64_t block_size = std::max(FLAGS_stream_block_size, 1u);
+    uint32_t window_size = std::max(FLAGS_stream_send_window, 1u);
+    uint64_t block_id = offset / block_size + 1;
+    uint64_t block_num = file_size / block_size + 1;
+    uint64_t report_block_num = block_num / 100;
+    SendWindow window;
+    int ret = 0;
+    while (offset < file_size) {
+        {
+            std::unique_lock<std::mutex> lock(window.mu);
+            window.cv.wait(lock, [&window, window_size] { return window.failed || window.in_flight < window_size; });
+            if (window.failed) {
+                ret = -1;
+                break;
+            }
+        }
+        uint64_t len = std::min(block_size, file_size - offset);
+        LimitBandwidth(len);
+        // read into the blocks of IOBuf directly, which are sent without copy
+        butil::IOPortal data;
+        while (data.size() < len) {
+            ssize_t r = data.pappend_from_file_descriptor(fd, offset + data.size(), len - data.size());
+            if (r <= 0) {
+                break;
+            }
+        }
+        if (data.size() < len) {
+            PDLOG(WARNING, "read file %s error. error message: %s", full_path.c_str(), strerror(errno));
+            ret = -1;
+            break;
+        }
+        auto closure = new SendBlockClosure(&window);
+        BuildRequest(file_name, dir_name, block_id, &closure->request);
+        closure->request.set_block_size(len);
+        closure->request.set_offset(offset);
+        closure->request.set_file_size(file_size);
+        closure->cntl.request_attachment().swap(data);
+        {
+            std::lock_guard<std::mutex> lock(window.mu);
+            window.in_flight++;
+        }
+        stub_->SendData(&closure->cntl, &closure->request, &closure->response, closure);
+        if (report_block_num == 0 || block_id % report_block_num == 0) {
+            PDLOG(INFO,
+                  "send block num[%lu] total block num[%lu]. tid[%u] pid[%u] "
+                  "file[%s] endpoint[%s]",
+                  block_id, block_num, tid_, pid_, file_name.c_str(), endpoint_.c_str());
+        }
+        offset += len;
+        block_id++;
+    }
+    close(fd);
+    {
+        std::unique_lock<std::mutex> lock(window.mu);
+        window.cv.wait(lock, [&window] { return window.in_flight == 0; });
+        if (window.failed) {
+            ret = -1;
+        }
+    }
+    if (ret < 0) {
+        PDLOG(WARNING, "data write failed. tid[%u] pid[%u] file %s", tid_, pid_, file_name.c_str());
+        return ret;
+    }
+    // all the blocks are acknowledged, let the receiver save the file
+    ::openmldb::api::SendDataRequest request;
+    BuildRequest(file_name, dir_name, block_id, &request);
+    request.set_block_size(0);
+    request.set_offset(file_size);
+    request.set_file_size(file_size);
+    request.set_eof(true);
+    brpc::Controller cntl;
+    ::openmldb::api::SendDataResponse response;
+    stub_->SendData(&cntl, &request, &response, NULL);
+    if (cntl.Failed() || response.code() != 0) {
+        PDLOG(WARNING, "send eof failed. tid %u pid %u file %s error msg %s", tid_, pid_, file_name.c_str(),
+              cntl.Failed() ? cntl.ErrorText().c_str() : response.msg().c_str());
+        return -1;
+    }
+    return 0;
+}
+
 int FileSender::CheckFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size) {
     ::openmldb::api::CheckFileRequest check_request;
     ::openmldb::api::GeneralResponse response;
@@ -237,12 +432,28 @@ int FileSender::CheckFile(const std::string& file_name, const std::string& dir_n
 int FileSender::SendDir(const std::string& dir_name, const std::string& full_path) {
     std::vector<std::string> file_vec;
     ::openmldb::base::GetFileName(full_path, file_vec);
-    for (const std::string& file : file_vec) {
-        if (SendFile(file.substr(file.find_last_of("/") + 1), dir_name, file) < 0) {
-            return -1;
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto send_files = [&]() {
+        size_t idx = 0;
+        while (!failed.load(std::memory_order_relaxed) && (idx = next.fetch_add(1)) < file_vec.size()) {
+            const std::string& file = file_vec[idx];
+            if (SendFile(file.substr(file.find_last_of("/") + 1), dir_name, file) < 0) {
+                failed.store(true, std::memory_order_relaxed);
+            }
         }
+    };
+    size_t thread_num = std::max(FLAGS_stream_send_file_concurrency, 1u);
+    thread_num = std::min(thread_num, file_vec.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_num; i++) {
+        threads.emplace_back(send_files);
     }
-    return 0;
+    send_files();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return failed.load() ? -1 : 0;
 }
 
 }  // namespace tablet
@@ -19,10 +19,12 @@
 #include <brpc/channel.h>
 #include <brpc/controller.h>
 
+#include <mutex>
 #include <string>
 
 #include "proto/tablet.pb.h"
 #include "auth/brpc_authenticator.h"
+#include "tablet/resource_governor.h"
 
 namespace openmldb {
 namespace tablet {
@@ -40,17 +42,32 @@ class FileSender {
     int WriteData(const std::string& file_name, const std::string& dir_name, const char* buffer, size_t len,
                   uint64_t block_id);
     int CheckFile(const std::string& file_name, const std::string& dir_name, uint64_t file_size);
+    // the data sent is throttled as the background io by the governor
+    void SetResourceGovernor(ResourceGovernor* governor) { governor_ = governor; }
 
  private:
+    // send block 0. set pipelined if the receiver supports the pipelined transfer
+    int InitReceiver(const std::string& file_name, const std::string& dir_name, uint64_t file_size, bool* pipelined,
+                     uint64_t* received_size);
+    // send blocks from offset with at most FLAGS_stream_send_window requests in flight
+    int SendFilePipelined(const std::string& file_name, const std::string& dir_name, const std::string& full_path,
+                          uint64_t file_size, uint64_t offset);
+    void BuildRequest(const std::string& file_name, const std::string& dir_name, uint64_t block_id,
+                      ::openmldb::api::SendDataRequest* request);
+    // sleep before sending len bytes if the bandwidth limit is reached. it is shared by the files sent in parallel
+    void LimitBandwidth(uint64_t len);
+
     uint32_t tid_;
     uint32_t pid_;
     common::StorageMode storage_mode_;
     std::string endpoint_;
     uint32_t cur_try_time_;
     uint32_t max_try_time_;
-    uint64_t limit_time_;
     brpc::Channel* channel_;
     ::openmldb::api::TabletServer_Stub* stub_;
+    std::mutex limit_mu_;
+    uint64_t next_send_time_;
+    ResourceGovernor* governor_ = nullptr;
     openmldb::authn::BRPCAuthenticator client_authenticator_;
 };
 
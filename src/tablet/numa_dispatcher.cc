@@ -0,0 +1,193 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/numa_dispatcher.h"
+
+#include "base/glog_wrapper.h"
+#include "base/numa_util.h"
+#include "bthread/countdown_event.h"
+
+namespace openmldb {
+namespace tablet {
+
+static thread_local int current_node = -1;
+
+NumaDispatcher::NumaDispatcher(const std::vector<std::vector<int>>& node_cpus, uint32_t thread_num_per_node,
+                               uint32_t max_pending_task_num)
+    : max_pending_task_num_(max_pending_task_num) {
+    for (size_t id = 0; id < node_cpus.size(); id++) {
+        if (node_cpus[id].empty()) {
+            continue;
+        }
+        auto node = std::make_unique<Node>();
+        node->id = id;
+        node->cpus = node_cpus[id];
+        nodes_.push_back(std::move(node));
+    }
+    for (auto& node : nodes_) {
+        for (uint32_t i = 0; i < thread_num_per_node; i++) {
+            node->threads.emplace_back(&NumaDispatcher::Run, this, node.get());
+        }
+    }
+}
+
+NumaDispatcher::~NumaDispatcher() { Stop(); }
+
+void NumaDispatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    for (auto& node : nodes_) {
+        {
+            std::lock_guard<std::mutex> lock(node->mu);
+            node->cv.notify_all();
+        }
+        for (auto& thread : node->threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+}
+
+int NumaDispatcher::BindPartition(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (nodes_.empty()) {
+        return -1;
+    }
+    auto it = partitions_.find({tid, pid});
+    if (it != partitions_.end()) {
+        return nodes_[it->second]->id;
+    }
+    size_t idx = 0;
+    for (size_t i = 1; i < nodes_.size(); i++) {
+        if (nodes_[i]->partition_num < nodes_[idx]->partition_num) {
+            idx = i;
+        }
+    }
+    nodes_[idx]->partition_num++;
+    partitions_.emplace(std::make_pair(tid, pid), idx);
+    PDLOG(INFO, "bind partition to numa node %d. tid %u pid %u", nodes_[idx]->id, tid, pid);
+    return nodes_[idx]->id;
+}
+
+void NumaDispatcher::UnbindPartition(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = partitions_.find({tid, pid});
+    if (it != partitions_.end()) {
+        nodes_[it->second]->partition_num--;
+        partitions_.erase(it);
+    }
+}
+
+int NumaDispatcher::GetNode(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = partitions_.find({tid, pid});
+    return it == partitions_.end() ? -1 : nodes_[it->second]->id;
+}
+
+int NumaDispatcher::GetCurrentNode() { return current_node; }
+
+bool NumaDispatcher::Dispatch(uint32_t tid, uint32_t pid, std::function<void()> task) {
+    Node* node = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = partitions_.find({tid, pid});
+        if (stop_ || it == partitions_.end()) {
+            return false;
+        }
+        node = nodes_[it->second].get();
+    }
+    if (node->id == current_node || node->threads.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(node->mu);
+    if (node->tasks.size() >= max_pending_task_num_) {
+        // the workers are busy, don't let the task wait behind the others
+        return false;
+    }
+    node->tasks.push_back(std::move(task));
+    node->cv.notify_one();
+    return true;
+}
+
+void NumaDispatcher::RunOnNode(uint32_t tid, uint32_t pid, std::function<void()> task) {
+    bthread::CountdownEvent event(1);
+    if (!Dispatch(tid, pid, [&task, &event] {
+            task();
+            event.signal();
+        })) {
+        task();
+        return;
+    }
+    event.wait();
+}
+
+void NumaDispatcher::Run(Node* node) {
+    if (!::openmldb::base::BindThreadToNumaNode(node->id, node->cpus)) {
+        PDLOG(WARNING, "fail to bind the worker to numa node %d", node->id);
+    }
+    current_node = node->id;
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(node->mu);
+            node->cv.wait(lock, [this, node] {
+                std::lock_guard<std::mutex> stop_lock(mu_);
+                return stop_ || !node->tasks.empty();
+            });
+            if (node->tasks.empty()) {
+                return;
+            }
+            task = std::move(node->tasks.front());
+            node->tasks.pop_front();
+        }
+        task();
+    }
+}
+
+NumaDispatcher::PinScope::PinScope(NumaDispatcher* dispatcher, uint32_t tid, uint32_t pid) {
+    if (dispatcher == nullptr) {
+        return;
+    }
+    int node = dispatcher->GetNode(tid, pid);
+    if (node < 0) {
+        return;
+    }
+    if (!::openmldb::base::GetThreadNumaState(&saved_state_)) {
+        PDLOG(WARNING, "fail to get the numa state of the thread. tid %u pid %u", tid, pid);
+        return;
+    }
+    for (const auto& cur : dispatcher->nodes_) {
+        if (cur->id == node) {
+            pinned_ = ::openmldb::base::BindThreadToNumaNode(node, cur->cpus);
+            break;
+        }
+    }
+}
+
+NumaDispatcher::PinScope::~PinScope() {
+    if (pinned_ && !::openmldb::base::SetThreadNumaState(saved_state_)) {
+        PDLOG(WARNING, "fail to restore the numa state of the thread");
+    }
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "base/numa_util.h"
+
+namespace openmldb {
+namespace tablet {
+
+// NumaDispatcher binds each partition of the tablet to a numa node and runs the tasks of the partition on the
+// worker threads pinned to the node, so the memory of the partition is allocated and accessed locally. A new
+// partition is bound to the node with the fewest partitions
+class NumaDispatcher {
+ public:
+    // node_cpus is the cpus of each node, the nodes without cpu are not used. at most max_pending_task_num tasks
+    // wait in the queue of each node
+    NumaDispatcher(const std::vector<std::vector<int>>& node_cpus, uint32_t thread_num_per_node,
+                   uint32_t max_pending_task_num);
+    ~NumaDispatcher();
+    NumaDispatcher(const NumaDispatcher&) = delete;
+    NumaDispatcher& operator=(const NumaDispatcher&) = delete;
+
+    // return the node of the partition, the partition bound before keeps its node
+    int BindPartition(uint32_t tid, uint32_t pid);
+    void UnbindPartition(uint32_t tid, uint32_t pid);
+    // -1 if the partition is not bound
+    int GetNode(uint32_t tid, uint32_t pid);
+    // run the task on a worker of the node of the partition. return false if the partition is not bound, the
+    // current thread is a worker of the node or the queue of the node is full, the task should be run in place then
+    bool Dispatch(uint32_t tid, uint32_t pid, std::function<void()> task);
+    // run the task on a worker of the node of the partition and wait until it's done. it can be called in a bthread,
+    // which must not be pinned since it may be resumed on another pthread. the task is run in place if it can't be
+    // dispatched
+    void RunOnNode(uint32_t tid, uint32_t pid, std::function<void()> task);
+    // pin the current thread to the node until the scope exits, it's used for the long tasks of the partition run by
+    // a dedicated pthread, e.g. loading the data. the cpu affinity and the memory policy of the thread are restored
+    // when the scope exits. it does nothing if the partition is not bound
+    class PinScope {
+     public:
+        PinScope(NumaDispatcher* dispatcher, uint32_t tid, uint32_t pid);
+        ~PinScope();
+        PinScope(const PinScope&) = delete;
+        PinScope& operator=(const PinScope&) = delete;
+
+     private:
+        bool pinned_ = false;
+        ::openmldb::base::ThreadNumaState saved_state_;
+    };
+
+    uint32_t GetNodeNum() const { return nodes_.size(); }
+    // the node which the current thread works for, -1 if it's not a worker
+    static int GetCurrentNode();
+    void Stop();
+
+ private:
+    struct Node {
+        int id;
+        std::vector<int> cpus;
+        std::mutex mu;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> tasks;
+        std::vector<std::thread> threads;
+        uint32_t partition_num = 0;
+    };
+
+    void Run(Node* node);
+
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::mutex mu_;
+    // (tid, pid) -> the index in nodes_
+    std::map<std::pair<uint32_t, uint32_t>, size_t> partitions_;
+    uint32_t max_pending_task_num_;
+    bool stop_ = false;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/numa_dispatcher.h"
+
+#include <atomic>
+#include <future>  // NOLINT
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class NumaDispatcherTest : public ::testing::Test {};
+
+TEST_F(NumaDispatcherTest, BindPartition) {
+    // node 1 has no cpu
+    NumaDispatcher dispatcher({{0}, {}, {0}}, 0, 16);
+    ASSERT_EQ(2u, dispatcher.GetNodeNum());
+    ASSERT_EQ(0, dispatcher.BindPartition(1, 0));
+    ASSERT_EQ(2, dispatcher.BindPartition(1, 1));
+    ASSERT_EQ(0, dispatcher.BindPartition(1, 2));
+    ASSERT_EQ(2, dispatcher.BindPartition(2, 0));
+    // the partition keeps its node
+    ASSERT_EQ(0, dispatcher.BindPartition(1, 0));
+    ASSERT_EQ(2, dispatcher.GetNode(1, 1));
+    dispatcher.UnbindPartition(1, 0);
+    dispatcher.UnbindPartition(1, 2);
+    ASSERT_EQ(-1, dispatcher.GetNode(1, 0));
+    ASSERT_EQ(0, dispatcher.BindPartition(3, 0));
+    // no node
+    NumaDispatcher empty({}, 1, 16);
+    ASSERT_EQ(-1, empty.BindPartition(1, 0));
+    ASSERT_FALSE(empty.Dispatch(1, 0, [] {}));
+}
+
+TEST_F(NumaDispatcherTest, Dispatch) {
+    NumaDispatcher dispatcher({{0}, {0}}, 2, 1000);
+    ASSERT_EQ(-1, NumaDispatcher::GetCurrentNode());
+    ASSERT_FALSE(dispatcher.Dispatch(1, 0, [] {}));
+    ASSERT_EQ(0, dispatcher.BindPartition(1, 0));
+    ASSERT_EQ(1, dispatcher.BindPartition(1, 1));
+    for (uint32_t pid = 0; pid < 2; pid++) {
+        std::promise<std::pair<int, bool>> promise;
+        auto future = promise.get_future();
+        ASSERT_TRUE(dispatcher.Dispatch(1, pid, [&dispatcher, &promise, pid] {
+            // the task of the same node runs in place
+            bool dispatched = dispatcher.Dispatch(1, pid, [] {});
+            promise.set_value({NumaDispatcher::GetCurrentNode(), dispatched});
+        }));
+        auto result = future.get();
+        ASSERT_EQ(static_cast<int>(pid), result.first);
+        ASSERT_FALSE(result.second);
+    }
+    // wait for the task run on the node, or run it in place if the partition is not bound
+    int node = -1;
+    dispatcher.RunOnNode(1, 1, [&node] { node = NumaDispatcher::GetCurrentNode(); });
+    ASSERT_EQ(1, node);
+    dispatcher.RunOnNode(2, 0, [&node] { node = NumaDispatcher::GetCurrentNode(); });
+    ASSERT_EQ(-1, node);
+    // the tasks dispatched are run before stopping
+    std::atomic<int> cnt{0};
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(dispatcher.Dispatch(1, i % 2, [&cnt] { cnt++; }));
+    }
+    dispatcher.Stop();
+    ASSERT_EQ(100, cnt.load());
+    ASSERT_FALSE(dispatcher.Dispatch(1, 0, [] {}));
+    {
+        NumaDispatcher::PinScope scope(&dispatcher, 1, 0);
+    }
+    NumaDispatcher::PinScope scope(nullptr, 1, 0);
+}
+
+TEST_F(NumaDispatcherTest, QueueFull) {
+    NumaDispatcher dispatcher({{0}}, 1, 1);
+    ASSERT_EQ(0, dispatcher.BindPartition(1, 0));
+    std::promise<void> started;
+    std::promise<void> blocked;
+    auto wait_blocked = blocked.get_future().share();
+    ASSERT_TRUE(dispatcher.Dispatch(1, 0, [&started, wait_blocked] {
+        started.set_value();
+        wait_blocked.wait();
+    }));
+    started.get_future().wait();
+    std::atomic<int> cnt{0};
+    ASSERT_TRUE(dispatcher.Dispatch(1, 0, [&cnt] { cnt++; }));
+    // the queue is full, the task is run in place by the caller
+    ASSERT_FALSE(dispatcher.Dispatch(1, 0, [&cnt] { cnt++; }));
+    blocked.set_value();
+    dispatcher.Stop();
+    ASSERT_EQ(1, cnt.load());
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/procedure_result_cache.h"
+
+#include <iterator>
+#include <utility>
+
+namespace openmldb {
+namespace tablet {
+
+ProcedureResultCache::ProcedureResultCache(uint64_t capacity, uint64_t ttl_ms) : capacity_(capacity), ttl_(ttl_ms) {}
+
+std::string ProcedureResultCache::MakeKey(const std::string& db, const std::string& sp_name, const std::string& row) {
+    // the names can't contain '\0', so the key of different deployments never collides
+    std::string key;
+    key.reserve(db.size() + sp_name.size() + row.size() + 2);
+    key.append(db).append(1, '\0').append(sp_name).append(1, '\0').append(row);
+    return key;
+}
+
+bool ProcedureResultCache::Get(const std::string& db, const std::string& sp_name, const std::string& row,
+                               uint64_t version, std::string* result) {
+    std::string key = MakeKey(db, sp_name, row);
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+        return false;
+    }
+    auto entry_it = it->second;
+    if (entry_it->version != version ||
+        (ttl_.count() > 0 && std::chrono::steady_clock::now() - entry_it->put_time > ttl_)) {
+        EraseEntry(entry_it);
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, entry_it);
+    result->assign(entry_it->result);
+    return true;
+}
+
+void ProcedureResultCache::Put(const std::string& db, const std::string& sp_name, const std::string& row,
+                               uint64_t version, const std::string& result) {
+    std::string key = MakeKey(db, sp_name, row);
+    uint64_t charge = key.size() * 2 + db.size() + sp_name.size() + result.size() + sizeof(Entry);
+    if (charge > capacity_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+        EraseEntry(it->second);
+    }
+    while (!lru_.empty() && size_ + charge > capacity_) {
+        EraseEntry(std::prev(lru_.end()));
+    }
+    lru_.push_front(Entry{key, db, sp_name, version, result, std::chrono::steady_clock::now(), charge});
+    map_.emplace(std::move(key), lru_.begin());
+    size_ += charge;
+}
+
+void ProcedureResultCache::Erase(const std::string& db, const std::string& sp_name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto cur = it++;
+        if (cur->db == db && cur->sp_name == sp_name) {
+            EraseEntry(cur);
+        }
+    }
+}
+
+void ProcedureResultCache::Clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    map_.clear();
+    lru_.clear();
+    size_ = 0;
+}
+
+uint64_t ProcedureResultCache::GetSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return size_;
+}
+
+uint64_t ProcedureResultCache::GetCnt() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return lru_.size();
+}
+
+void ProcedureResultCache::EraseEntry(std::list<Entry>::iterator it) {
+    size_ -= it->charge;
+    map_.erase(it->key);
+    lru_.erase(it);
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>  // NOLINT
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+
+namespace openmldb {
+namespace tablet {
+
+// ProcedureResultCache keeps the output rows of deployments in request mode, keyed by the deployment and the
+// encoded request row. An entry is valid only if the data version of the tables used by the deployment is not
+// changed and it's not older than ttl, so a request row retried in a short time skips running the plan again.
+// The total bytes of the entries are bounded by capacity and the least recently used ones are evicted
+class ProcedureResultCache {
+ public:
+    // capacity is in bytes, ttl_ms 0 means no expiration
+    ProcedureResultCache(uint64_t capacity, uint64_t ttl_ms);
+    ProcedureResultCache(const ProcedureResultCache&) = delete;
+    ProcedureResultCache& operator=(const ProcedureResultCache&) = delete;
+
+    // return true and fill result if the row has been cached with the same version
+    bool Get(const std::string& db, const std::string& sp_name, const std::string& row, uint64_t version,
+             std::string* result);
+    // the result larger than capacity is not cached
+    void Put(const std::string& db, const std::string& sp_name, const std::string& row, uint64_t version,
+             const std::string& result);
+    // drop the entries of the deployment
+    void Erase(const std::string& db, const std::string& sp_name);
+    void Clear();
+
+    uint64_t GetSize();
+    uint64_t GetCnt();
+
+ private:
+    struct Entry {
+        std::string key;
+        std::string db;
+        std::string sp_name;
+        uint64_t version;
+        std::string result;
+        std::chrono::steady_clock::time_point put_time;
+        uint64_t charge;
+    };
+
+    static std::string MakeKey(const std::string& db, const std::string& sp_name, const std::string& row);
+    void EraseEntry(std::list<Entry>::iterator it);
+
+    uint64_t capacity_;
+    std::chrono::milliseconds ttl_;
+    std::mutex mu_;
+    // the most recently used entry is at the front
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> map_;
+    uint64_t size_ = 0;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
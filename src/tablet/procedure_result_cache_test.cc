@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/procedure_result_cache.h"
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class ProcedureResultCacheTest : public ::testing::Test {};
+
+TEST_F(ProcedureResultCacheTest, GetAndPut) {
+    ProcedureResultCache cache(1 << 20, 0);
+    std::string result;
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row1", 1, &result));
+    cache.Put("db1", "sp1", "row1", 1, "result1");
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row1", 1, &result));
+    ASSERT_EQ("result1", result);
+    // the other deployments and rows don't share the entry
+    ASSERT_FALSE(cache.Get("db1", "sp2", "row1", 1, &result));
+    ASSERT_FALSE(cache.Get("db2", "sp1", "row1", 1, &result));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row2", 1, &result));
+    // the data is changed
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row1", 2, &result));
+    ASSERT_EQ(0u, cache.GetCnt());
+    ASSERT_EQ(0u, cache.GetSize());
+    cache.Put("db1", "sp1", "row1", 2, "result2");
+    cache.Put("db1", "sp1", "row1", 2, "result3");
+    ASSERT_EQ(1u, cache.GetCnt());
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row1", 2, &result));
+    ASSERT_EQ("result3", result);
+}
+
+TEST_F(ProcedureResultCacheTest, Evict) {
+    std::string value(1000, 'a');
+    ProcedureResultCache cache(10 * 1024, 0);
+    for (int i = 0; i < 100; i++) {
+        cache.Put("db1", "sp1", "row" + std::to_string(i), 1, value);
+        ASSERT_LE(cache.GetSize(), 10 * 1024u);
+    }
+    std::string result;
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row99", 1, &result));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row0", 1, &result));
+    // the recently used entry is kept
+    uint64_t cnt = cache.GetCnt();
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row" + std::to_string(100 - cnt), 1, &result));
+    cache.Put("db1", "sp1", "row100", 1, value);
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row" + std::to_string(100 - cnt), 1, &result));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row" + std::to_string(101 - cnt), 1, &result));
+    // too large to be cached
+    cache.Put("db1", "sp1", "large", 1, std::string(20 * 1024, 'a'));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "large", 1, &result));
+}
+
+TEST_F(ProcedureResultCacheTest, Expire) {
+    ProcedureResultCache cache(1 << 20, 10);
+    std::string result;
+    cache.Put("db1", "sp1", "row1", 1, "result1");
+    ASSERT_TRUE(cache.Get("db1", "sp1", "row1", 1, &result));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row1", 1, &result));
+}
+
+TEST_F(ProcedureResultCacheTest, Erase) {
+    ProcedureResultCache cache(1 << 20, 0);
+    cache.Put("db1", "sp1", "row1", 1, "result1");
+    cache.Put("db1", "sp1", "row2", 1, "result2");
+    cache.Put("db1", "sp2", "row1", 1, "result1");
+    cache.Erase("db1", "sp1");
+    std::string result;
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row1", 1, &result));
+    ASSERT_FALSE(cache.Get("db1", "sp1", "row2", 1, &result));
+    ASSERT_TRUE(cache.Get("db1", "sp2", "row1", 1, &result));
+    cache.Clear();
+    ASSERT_EQ(0u, cache.GetCnt());
+    ASSERT_EQ(0u, cache.GetSize());
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
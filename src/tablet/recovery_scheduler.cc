@@ -0,0 +1,158 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/recovery_scheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include "base/glog_wrapper.h"
+
+namespace openmldb {
+namespace tablet {
+
+RecoveryScheduler::RecoveryScheduler(uint32_t thread_num, uint64_t memory_budget) : memory_budget_(memory_budget) {
+    thread_num = std::max(thread_num, 1u);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads_.emplace_back(&RecoveryScheduler::Run, this);
+    }
+}
+
+RecoveryScheduler::~RecoveryScheduler() { Stop(); }
+
+void RecoveryScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+        cv_.notify_all();
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void RecoveryScheduler::Submit(uint32_t tid, uint32_t pid, uint32_t priority, uint64_t estimated_size,
+                               std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mu_);
+    Task t;
+    t.tid = tid;
+    t.pid = pid;
+    t.priority = priority;
+    t.estimated_size = estimated_size;
+    t.fn = std::move(task);
+    waiting_.emplace(TaskKey(priority, seq_++), std::move(t));
+    PDLOG(INFO, "submit recovery. priority %u, estimated size %lu, waiting num %lu. tid %u pid %u", priority,
+          estimated_size, waiting_.size(), tid, pid);
+    cv_.notify_all();
+}
+
+bool RecoveryScheduler::CanStart() {
+    if (waiting_.empty()) {
+        return false;
+    }
+    return memory_budget_ == 0 || running_.empty() ||
+           running_size_ + waiting_.begin()->second.estimated_size <= memory_budget_;
+}
+
+void RecoveryScheduler::Run() {
+    while (true) {
+        uint64_t seq = 0;
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return stop_ || CanStart(); });
+            if (stop_) {
+                return;
+            }
+            auto iter = waiting_.begin();
+            seq = iter->first.second;
+            fn = std::move(iter->second.fn);
+            iter->second.start_time = std::chrono::steady_clock::now();
+            running_size_ += iter->second.estimated_size;
+            running_.emplace(seq, std::move(iter->second));
+            waiting_.erase(iter);
+        }
+        fn();
+        std::lock_guard<std::mutex> lock(mu_);
+        auto iter = running_.find(seq);
+        const Task& task = iter->second;
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - task.start_time;
+        running_size_ -= task.estimated_size;
+        finished_size_ += task.estimated_size;
+        finished_seconds_ += elapsed.count();
+        PDLOG(INFO, "recovery finished. estimated size %lu, consumed %.3fs. tid %u pid %u", task.estimated_size,
+              elapsed.count(), task.tid, task.pid);
+        running_.erase(iter);
+        cv_.notify_all();
+    }
+}
+
+std::vector<RecoveryStatus> RecoveryScheduler::GetStatus() {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::vector<RecoveryStatus> result;
+    // the bytes recovered per second by one thread
+    double throughput = finished_seconds_ > 0 ? finished_size_ / finished_seconds_ : 0;
+    auto now = std::chrono::steady_clock::now();
+    // the seconds after which the threads are free
+    std::priority_queue<double, std::vector<double>, std::greater<double>> free_time;
+    for (size_t i = running_.size(); i < threads_.size(); i++) {
+        free_time.push(0);
+    }
+    for (const auto& kv : running_) {
+        const Task& task = kv.second;
+        RecoveryStatus status;
+        status.tid = task.tid;
+        status.pid = task.pid;
+        status.priority = task.priority;
+        status.estimated_size = task.estimated_size;
+        status.running = true;
+        double remain = 0;
+        if (throughput > 0) {
+            std::chrono::duration<double> elapsed = now - task.start_time;
+            remain = std::max(0.0, task.estimated_size / throughput - elapsed.count());
+            status.eta = static_cast<int64_t>(remain);
+        }
+        free_time.push(remain);
+        result.push_back(status);
+    }
+    for (const auto& kv : waiting_) {
+        const Task& task = kv.second;
+        RecoveryStatus status;
+        status.tid = task.tid;
+        status.pid = task.pid;
+        status.priority = task.priority;
+        status.estimated_size = task.estimated_size;
+        if (throughput > 0 && !free_time.empty()) {
+            double finish = free_time.top() + task.estimated_size / throughput;
+            free_time.pop();
+            free_time.push(finish);
+            status.eta = static_cast<int64_t>(finish);
+        }
+        result.push_back(status);
+    }
+    return result;
+}
+
+uint64_t RecoveryScheduler::GetRunningSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return running_size_;
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <map>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace openmldb {
+namespace tablet {
+
+struct RecoveryStatus {
+    uint32_t tid = 0;
+    uint32_t pid = 0;
+    uint32_t priority = 0;
+    uint64_t estimated_size = 0;
+    bool running = false;
+    // the estimated seconds until the partition is recovered, -1 if it's unknown
+    int64_t eta = -1;
+};
+
+// RecoveryScheduler recovers the partitions of a tablet in the order of priority, the partitions with the same
+// priority are recovered in the order of submission. At most thread_num partitions are recovered at the same time,
+// and a partition starts only if the sum of the estimated size of the running ones fits in memory_budget, unless
+// nothing is running. The throughput of the finished recoveries is used to estimate when the others finish
+class RecoveryScheduler {
+ public:
+    // memory_budget is in bytes, 0 means no limit
+    RecoveryScheduler(uint32_t thread_num, uint64_t memory_budget);
+    ~RecoveryScheduler();
+    RecoveryScheduler(const RecoveryScheduler&) = delete;
+    RecoveryScheduler& operator=(const RecoveryScheduler&) = delete;
+
+    // higher priority is recovered first. estimated_size is the bytes of data to be loaded into memory
+    void Submit(uint32_t tid, uint32_t pid, uint32_t priority, uint64_t estimated_size, std::function<void()> task);
+    // the partitions being recovered and then the waiting ones in the order they start. the eta of waiting ones
+    // doesn't take memory budget into account
+    std::vector<RecoveryStatus> GetStatus();
+    uint64_t GetRunningSize();
+    // the tasks which have not started are dropped
+    void Stop();
+
+ private:
+    struct Task {
+        uint32_t tid;
+        uint32_t pid;
+        uint32_t priority;
+        uint64_t estimated_size;
+        std::function<void()> fn;
+        std::chrono::steady_clock::time_point start_time;
+    };
+    // higher priority first, then the smaller sequence
+    using TaskKey = std::pair<uint32_t, uint64_t>;
+    struct TaskKeyCmp {
+        bool operator()(const TaskKey& lhs, const TaskKey& rhs) const {
+            return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+        }
+    };
+
+    void Run();
+    bool CanStart();
+
+    uint64_t memory_budget_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::map<TaskKey, Task, TaskKeyCmp> waiting_;
+    std::map<uint64_t, Task> running_;
+    uint64_t running_size_ = 0;
+    uint64_t seq_ = 0;
+    // the sum of bytes and seconds of the finished recoveries
+    uint64_t finished_size_ = 0;
+    double finished_seconds_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/recovery_scheduler.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class RecoverySchedulerTest : public ::testing::Test {};
+
+TEST_F(RecoverySchedulerTest, Priority) {
+    RecoveryScheduler scheduler(1, 0);
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    std::mutex mu;
+    std::vector<uint32_t> order;
+    // the thread is blocked by the first task, so the others are ordered by priority
+    scheduler.Submit(1, 0, 0, 0, [blocked] { blocked.wait(); });
+    while (scheduler.GetStatus().empty() || !scheduler.GetStatus()[0].running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (uint32_t pid = 1; pid <= 4; pid++) {
+        scheduler.Submit(1, pid, pid % 2, 0, [&mu, &order, pid] {
+            std::lock_guard<std::mutex> lock(mu);
+            order.push_back(pid);
+        });
+    }
+    auto status = scheduler.GetStatus();
+    ASSERT_EQ(5u, status.size());
+    ASSERT_TRUE(status[0].running);
+    ASSERT_EQ(1u, status[1].pid);
+    ASSERT_EQ(3u, status[2].pid);
+    ASSERT_FALSE(status[1].running);
+    // no recovery has finished, the throughput is unknown
+    ASSERT_EQ(-1, status[1].eta);
+    blocker.set_value();
+    while (!scheduler.GetStatus().empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::vector<uint32_t> expected = {1, 3, 2, 4};
+    ASSERT_EQ(expected, order);
+}
+
+TEST_F(RecoverySchedulerTest, MemoryBudget) {
+    RecoveryScheduler scheduler(4, 100);
+    std::atomic<uint32_t> running{0};
+    std::atomic<uint32_t> max_running{0};
+    std::atomic<uint32_t> finished{0};
+    auto task = [&] {
+        uint32_t cur = ++running;
+        uint32_t max = max_running.load();
+        while (cur > max && !max_running.compare_exchange_weak(max, cur)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        running--;
+        finished++;
+    };
+    for (uint32_t pid = 0; pid < 6; pid++) {
+        scheduler.Submit(1, pid, 0, 40, task);
+    }
+    // larger than the budget, it starts when nothing is running
+    scheduler.Submit(1, 6, 0, 200, task);
+    while (finished.load() < 7) {
+        ASSERT_LE(scheduler.GetRunningSize(), 200u);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(2u, max_running.load());
+}
+
+TEST_F(RecoverySchedulerTest, Eta) {
+    RecoveryScheduler scheduler(1, 0);
+    scheduler.Submit(1, 0, 0, 1000, [] { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    while (!scheduler.GetStatus().empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    scheduler.Submit(1, 1, 0, 1000, [blocked] { blocked.wait(); });
+    scheduler.Submit(1, 2, 0, 100000, [] {});
+    auto status = scheduler.GetStatus();
+    ASSERT_EQ(2u, status.size());
+    // 1000 bytes are recovered in about 0.1s
+    ASSERT_GE(status[0].eta, 0);
+    ASSERT_LE(status[0].eta, 1);
+    ASSERT_GE(status[1].eta, 5);
+    ASSERT_LE(status[1].eta, 11);
+    blocker.set_value();
+}
+
+TEST_F(RecoverySchedulerTest, Stop) {
+    std::atomic<uint32_t> finished{0};
+    std::promise<void> blocker;
+    auto blocked = blocker.get_future().share();
+    RecoveryScheduler scheduler(1, 0);
+    scheduler.Submit(1, 0, 0, 0, [&finished, blocked] {
+        blocked.wait();
+        finished++;
+    });
+    scheduler.Submit(1, 1, 0, 0, [&finished] { finished++; });
+    while (!scheduler.GetStatus()[0].running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    blocker.set_value();
+    scheduler.Stop();
+    // the running task finishes and the waiting one is dropped
+    ASSERT_LE(finished.load(), 2u);
+    ASSERT_GE(finished.load(), 1u);
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
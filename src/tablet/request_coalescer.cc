@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_coalescer.h"
+
+#include <errno.h>
+
+#include <utility>
+
+#include "butil/time.h"
+
+namespace openmldb {
+namespace tablet {
+
+RequestCoalescer::RequestCoalescer(uint64_t window_us, uint32_t max_batch_size)
+    : window_us_(window_us), max_batch_size_(max_batch_size > 0 ? max_batch_size : 1) {}
+
+bool RequestCoalescer::Run(const std::string& key, const hybridse::codec::Row& row, const BatchRunner& runner,
+                           hybridse::codec::Row* output) {
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    auto it = pending_.find(key);
+    if (it != pending_.end()) {
+        // join the batch gathering rows
+        auto batch = it->second;
+        size_t idx = batch->rows.size();
+        batch->rows.push_back(row);
+        if (batch->rows.size() >= max_batch_size_) {
+            pending_.erase(it);
+            batch->cv.notify_all();
+        }
+        while (!batch->done) {
+            batch->cv.wait(lock);
+        }
+        if (!batch->ok) {
+            return false;
+        }
+        *output = batch->outputs[idx];
+        return true;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->rows.push_back(row);
+    if (max_batch_size_ > 1) {
+        pending_.emplace(key, batch);
+        timespec deadline = butil::microseconds_from_now(window_us_);
+        while (batch->rows.size() < max_batch_size_) {
+            if (batch->cv.wait_until(lock, deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        auto cur = pending_.find(key);
+        if (cur != pending_.end() && cur->second == batch) {
+            pending_.erase(cur);
+        }
+    }
+    // no row joins the batch from now on
+    std::vector<hybridse::codec::Row> rows = std::move(batch->rows);
+    lock.unlock();
+
+    std::vector<hybridse::codec::Row> outputs;
+    bool ok = runner(rows, &outputs) && outputs.size() == rows.size();
+    batch_cnt_.fetch_add(1, std::memory_order_relaxed);
+    row_cnt_.fetch_add(rows.size(), std::memory_order_relaxed);
+    if (ok) {
+        *output = outputs[0];
+    }
+
+    lock.lock();
+    batch->ok = ok;
+    batch->outputs = std::move(outputs);
+    batch->done = true;
+    batch->cv.notify_all();
+    return ok;
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "bthread/condition_variable.h"
+#include "codec/row.h"
+
+namespace openmldb {
+namespace tablet {
+
+// RequestCoalescer gathers the concurrent request rows with the same key and runs them as one batch. The first row
+// of a batch waits for the others up to window_us or until max_batch_size rows arrive, then runs the batch in its
+// own thread and hands the outputs to the others
+class RequestCoalescer {
+ public:
+    // run the rows and fill one output for each row, return false if it fails
+    using BatchRunner =
+        std::function<bool(const std::vector<hybridse::codec::Row>&, std::vector<hybridse::codec::Row>*)>;
+
+    RequestCoalescer(uint64_t window_us, uint32_t max_batch_size);
+    RequestCoalescer(const RequestCoalescer&) = delete;
+    RequestCoalescer& operator=(const RequestCoalescer&) = delete;
+
+    // block the bthread until the row is run. the runner of the first row in the batch is used, so the rows with the same key
+    // must be able to run with any of their runners. return false if the batch fails, and the row should be run
+    // alone to get its own error
+    bool Run(const std::string& key, const hybridse::codec::Row& row, const BatchRunner& runner,
+             hybridse::codec::Row* output);
+
+    uint64_t GetBatchCnt() const { return batch_cnt_.load(std::memory_order_relaxed); }
+    uint64_t GetRowCnt() const { return row_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct Batch {
+        std::vector<hybridse::codec::Row> rows;
+        std::vector<hybridse::codec::Row> outputs;
+        bthread::ConditionVariable cv;
+        bool done = false;
+        bool ok = false;
+    };
+
+    uint64_t window_us_;
+    uint32_t max_batch_size_;
+    bthread::Mutex mu_;
+    // the batches which are still gathering rows
+    std::unordered_map<std::string, std::shared_ptr<Batch>> pending_;
+    std::atomic<uint64_t> batch_cnt_{0};
+    std::atomic<uint64_t> row_cnt_{0};
+};
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/request_coalescer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class RequestCoalescerTest : public ::testing::Test {};
+
+using hybridse::codec::Row;
+
+static Row MakeRow(const std::string& value) {
+    auto buf = reinterpret_cast<int8_t*>(malloc(value.size()));
+    memcpy(buf, value.data(), value.size());
+    return Row(hybridse::base::RefCountedSlice::CreateManaged(buf, value.size()));
+}
+
+// the output of a row is the row with the suffix
+static RequestCoalescer::BatchRunner MakeRunner(const std::string& suffix, std::atomic<int>* max_batch) {
+    return [suffix, max_batch](const std::vector<Row>& rows, std::vector<Row>* outputs) {
+        int size = rows.size();
+        int cur = max_batch->load();
+        while (size > cur && !max_batch->compare_exchange_weak(cur, size)) {
+        }
+        for (const auto& row : rows) {
+            outputs->push_back(MakeRow(row.ToString() + suffix));
+        }
+        return true;
+    };
+}
+
+TEST_F(RequestCoalescerTest, Coalesce) {
+    RequestCoalescer coalescer(200 * 1000, 8);
+    std::atomic<int> max_batch{0};
+    std::atomic<int> failed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; i++) {
+        threads.emplace_back([&, i] {
+            std::string key = i % 2 == 0 ? "sp1" : "sp2";
+            Row output;
+            std::string value = "row" + std::to_string(i);
+            if (!coalescer.Run(key, MakeRow(value), MakeRunner("_" + key, &max_batch), &output) ||
+                output.ToString() != value + "_" + key) {
+                failed++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0, failed.load());
+    ASSERT_EQ(16u, coalescer.GetRowCnt());
+    ASSERT_LT(coalescer.GetBatchCnt(), 16u);
+    ASSERT_LE(max_batch.load(), 8);
+}
+
+TEST_F(RequestCoalescerTest, Fail) {
+    RequestCoalescer coalescer(50 * 1000, 4);
+    std::atomic<int> failed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            Row output;
+            auto runner = [](const std::vector<Row>& rows, std::vector<Row>* outputs) { return false; };
+            if (!coalescer.Run("sp1", MakeRow("row"), runner, &output)) {
+                failed++;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(4, failed.load());
+    // the runner misses some outputs
+    Row output;
+    auto runner = [](const std::vector<Row>& rows, std::vector<Row>* outputs) { return true; };
+    ASSERT_FALSE(coalescer.Run("sp1", MakeRow("row"), runner, &output));
+}
+
+TEST_F(RequestCoalescerTest, NoWait) {
+    // the row runs alone without waiting if the batch size is 1
+    RequestCoalescer coalescer(10 * 1000 * 1000, 1);
+    std::atomic<int> max_batch{0};
+    Row output;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(coalescer.Run("sp1", MakeRow("row"), MakeRunner("_out", &max_batch), &output));
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    ASSERT_EQ("row_out", output.ToString());
+    ASSERT_EQ(1, max_batch.load());
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/resource_governor.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "bvar/bvar.h"
+
+namespace openmldb {
+namespace tablet {
+
+// the share of the background work never drops below it, so the background work always makes progress
+constexpr double MIN_BACKGROUND_RATIO = 0.05;
+constexpr double BACKGROUND_RATIO_STEP = 0.1;
+// the latency below it lets the share of the background work grow
+constexpr double SLO_SAFE_RATIO = 0.8;
+// too few samples in an adjustment are not taken as a sign of missing the slo
+constexpr uint64_t MIN_LATENCY_SAMPLES = 20;
+// the max time a call is blocked
+constexpr uint64_t MAX_THROTTLE_US = 1000 * 1000;
+
+const char* WorkClassName(WorkClass cls) {
+    switch (cls) {
+        case WorkClass::kOnlineQuery:
+            return "online_query";
+        case WorkClass::kPut:
+            return "put";
+        case WorkClass::kReplication:
+            return "replication";
+        case WorkClass::kBackground:
+            return "background";
+    }
+    return "unknown";
+}
+
+static uint64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+ResourceGovernor::ResourceGovernor(uint64_t latency_slo_us, uint64_t background_io_limit)
+    : latency_slo_us_(latency_slo_us), background_io_limit_(background_io_limit) {
+    for (auto& bucket : online_latency_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+ResourceGovernor::~ResourceGovernor() = default;
+
+uint32_t ResourceGovernor::GetBucket(uint64_t latency_us) {
+    if (latency_us < 2) {
+        return latency_us;
+    }
+    uint32_t bits = 63 - __builtin_clzll(latency_us);
+    uint32_t bucket = 2 * bits + ((latency_us >> (bits - 1)) & 1);
+    return std::min(bucket, BUCKET_NUM - 1);
+}
+
+uint64_t ResourceGovernor::GetBucketUpperBound(uint32_t bucket) {
+    if (bucket < 2) {
+        return bucket;
+    }
+    uint32_t bits = bucket / 2;
+    if (bucket % 2 == 1) {
+        return (1ULL << (bits + 1)) - 1;
+    }
+    return (1ULL << bits) + (1ULL << (bits - 1)) - 1;
+}
+
+void ResourceGovernor::Record(WorkClass cls, uint64_t latency_us, uint64_t bytes) {
+    auto& counter = counters_[static_cast<uint32_t>(cls)];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.busy_us.fetch_add(latency_us, std::memory_order_relaxed);
+    if (bytes > 0) {
+        counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    if (cls == WorkClass::kOnlineQuery) {
+        online_latency_[GetBucket(latency_us)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ResourceGovernor::ThrottleIO(WorkClass cls, uint64_t bytes) {
+    auto& counter = counters_[static_cast<uint32_t>(cls)];
+    counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (cls != WorkClass::kBackground || background_io_limit_ == 0) {
+        return;
+    }
+    double rate = background_io_limit_ * GetBackgroundRatio();
+    uint64_t cost_us = static_cast<uint64_t>(bytes * 1000000.0 / rate);
+    uint64_t sleep_us = 0;
+    {
+        std::lock_guard<std::mutex> lock(io_mu_);
+        uint64_t now = NowMicros();
+        if (next_io_time_ < now) {
+            next_io_time_ = now;
+        }
+        sleep_us = next_io_time_ - now;
+        next_io_time_ += cost_us;
+    }
+    Sleep(cls, sleep_us);
+}
+
+void ResourceGovernor::ThrottleCpu(WorkClass cls, uint64_t busy_us) {
+    auto& counter = counters_[static_cast<uint32_t>(cls)];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.busy_us.fetch_add(busy_us, std::memory_order_relaxed);
+    if (cls != WorkClass::kBackground) {
+        return;
+    }
+    double ratio = GetBackgroundRatio();
+    if (ratio >= 1.0) {
+        return;
+    }
+    // the work is busy for ratio of the time
+    Sleep(cls, static_cast<uint64_t>(busy_us * (1.0 - ratio) / ratio));
+}
+
+void ResourceGovernor::Sleep(WorkClass cls, uint64_t sleep_us) {
+    sleep_us = std::min(sleep_us, MAX_THROTTLE_US);
+    if (sleep_us == 0) {
+        return;
+    }
+    counters_[static_cast<uint32_t>(cls)].throttled_us.fetch_add(sleep_us, std::memory_order_relaxed);
+    std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+}
+
+void ResourceGovernor::Adjust() {
+    std::array<uint64_t, BUCKET_NUM> buckets;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; i++) {
+        buckets[i] = online_latency_[i].exchange(0, std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    uint64_t p99 = 0;
+    if (total > 0) {
+        uint64_t rank = total - total / 100;
+        uint64_t cnt = 0;
+        for (uint32_t i = 0; i < BUCKET_NUM; i++) {
+            cnt += buckets[i];
+            if (cnt >= rank) {
+                p99 = GetBucketUpperBound(i);
+                break;
+            }
+        }
+    }
+    online_p99_.store(p99, std::memory_order_relaxed);
+    if (latency_slo_us_ == 0) {
+        return;
+    }
+    double ratio = GetBackgroundRatio();
+    double new_ratio = ratio;
+    if (total >= MIN_LATENCY_SAMPLES && p99 > latency_slo_us_) {
+        new_ratio = std::max(MIN_BACKGROUND_RATIO, ratio / 2);
+    } else if (total < MIN_LATENCY_SAMPLES || p99 < latency_slo_us_ * SLO_SAFE_RATIO) {
+        new_ratio = std::min(1.0, ratio + BACKGROUND_RATIO_STEP);
+    }
+    if (new_ratio != ratio) {
+        background_ratio_.store(new_ratio, std::memory_order_relaxed);
+        DEBUGLOG("online p99 latency %lu us with %lu samples, background ratio %f -> %f", p99, total, ratio,
+                 new_ratio);
+    }
+}
+
+WorkClassStat ResourceGovernor::GetStat(WorkClass cls) const {
+    const auto& counter = counters_[static_cast<uint32_t>(cls)];
+    WorkClassStat stat;
+    stat.count = counter.count.load(std::memory_order_relaxed);
+    stat.bytes = counter.bytes.load(std::memory_order_relaxed);
+    stat.busy_us = counter.busy_us.load(std::memory_order_relaxed);
+    stat.throttled_us = counter.throttled_us.load(std::memory_order_relaxed);
+    return stat;
+}
+
+void ResourceGovernor::Expose(const std::string& prefix) {
+    vars_.clear();
+    auto get_counter = [](void* arg) -> int64_t {
+        return static_cast<std::atomic<uint64_t>*>(arg)->load(std::memory_order_relaxed);
+    };
+    for (uint32_t i = 0; i < WORK_CLASS_NUM; i++) {
+        std::string name = std::string("governor_") + WorkClassName(static_cast<WorkClass>(i));
+        auto& counter = counters_[i];
+        vars_.emplace_back(new bvar::PassiveStatus<int64_t>(prefix, name + "_count", get_counter, &counter.count));
+        vars_.emplace_back(new bvar::PassiveStatus<int64_t>(prefix, name + "_bytes", get_counter, &counter.bytes));
+        vars_.emplace_back(
+            new bvar::PassiveStatus<int64_t>(prefix, name + "_busy_us", get_counter, &counter.busy_us));
+        vars_.emplace_back(
+            new bvar::PassiveStatus<int64_t>(prefix, name + "_throttled_us", get_counter, &counter.throttled_us));
+    }
+    vars_.emplace_back(new bvar::PassiveStatus<double>(
+        prefix, "governor_background_ratio",
+        [](void* arg) { return static_cast<ResourceGovernor*>(arg)->GetBackgroundRatio(); }, this));
+    vars_.emplace_back(new bvar::PassiveStatus<int64_t>(
+        prefix, "governor_online_p99_us",
+        [](void* arg) -> int64_t { return static_cast<ResourceGovernor*>(arg)->GetOnlineP99(); }, this));
+}
+
+}  // namespace tablet
+}  // namespace openmldb
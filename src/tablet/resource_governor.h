@@ -0,0 +1,108 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace bvar {
+class Variable;
+}
+
+namespace openmldb {
+namespace tablet {
+
+enum class WorkClass : uint32_t {
+    kOnlineQuery = 0,
+    kPut = 1,
+    kReplication = 2,
+    kBackground = 3,
+};
+constexpr uint32_t WORK_CLASS_NUM = 4;
+
+const char* WorkClassName(WorkClass cls);
+
+struct WorkClassStat {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t busy_us = 0;
+    uint64_t throttled_us = 0;
+};
+
+// ResourceGovernor tracks the work of each class and throttles the background work when the p99 latency of the
+// online queries exceeds the slo. The share of the background work is halved once the slo is missed in an
+// adjustment and grows slowly back to 1 after the latency recovers, it limits both the cpu time of the background
+// tasks and the bytes they read or send per second
+class ResourceGovernor {
+ public:
+    // latency_slo_us 0 means the background work is never throttled. background_io_limit is the bytes per second
+    // of the background io at the full share, 0 means no limit
+    ResourceGovernor(uint64_t latency_slo_us, uint64_t background_io_limit);
+    ~ResourceGovernor();
+    ResourceGovernor(const ResourceGovernor&) = delete;
+    ResourceGovernor& operator=(const ResourceGovernor&) = delete;
+
+    // record a finished request
+    void Record(WorkClass cls, uint64_t latency_us, uint64_t bytes = 0);
+    // called before the io of bytes, block until the bytes fit in the budget of the class
+    void ThrottleIO(WorkClass cls, uint64_t bytes);
+    // called after the work which is busy for busy_us, block to keep the cpu share of the class
+    void ThrottleCpu(WorkClass cls, uint64_t busy_us);
+    // update the share of the background work by the online latency since the last adjustment
+    void Adjust();
+
+    double GetBackgroundRatio() const { return background_ratio_.load(std::memory_order_relaxed); }
+    // the p99 latency of the online queries in the last adjustment
+    uint64_t GetOnlineP99() const { return online_p99_.load(std::memory_order_relaxed); }
+    WorkClassStat GetStat(WorkClass cls) const;
+    // expose the state as bvars with the prefix
+    void Expose(const std::string& prefix);
+
+ private:
+    // the latency histogram with two buckets for each power of two
+    static constexpr uint32_t BUCKET_NUM = 64;
+    static uint32_t GetBucket(uint64_t latency_us);
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+    void Sleep(WorkClass cls, uint64_t sleep_us);
+
+    struct ClassCounter {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> busy_us{0};
+        std::atomic<uint64_t> throttled_us{0};
+    };
+
+    uint64_t latency_slo_us_;
+    uint64_t background_io_limit_;
+    std::array<ClassCounter, WORK_CLASS_NUM> counters_;
+    std::array<std::atomic<uint64_t>, BUCKET_NUM> online_latency_;
+    std::atomic<double> background_ratio_{1.0};
+    std::atomic<uint64_t> online_p99_{0};
+    std::mutex io_mu_;
+    // the time in microseconds when the next background io is allowed
+    uint64_t next_io_time_ = 0;
+    std::vector<std::unique_ptr<bvar::Variable>> vars_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
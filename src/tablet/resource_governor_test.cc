@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/resource_governor.h"
+
+#include <chrono>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class ResourceGovernorTest : public ::testing::Test {};
+
+TEST_F(ResourceGovernorTest, Adjust) {
+    ResourceGovernor governor(10 * 1000, 0);
+    ASSERT_DOUBLE_EQ(1.0, governor.GetBackgroundRatio());
+    // the online queries are slow
+    for (int i = 0; i < 100; i++) {
+        governor.Record(WorkClass::kOnlineQuery, 50 * 1000);
+    }
+    governor.Adjust();
+    ASSERT_GE(governor.GetOnlineP99(), 50 * 1000u);
+    ASSERT_LT(governor.GetOnlineP99(), 100 * 1000u);
+    ASSERT_DOUBLE_EQ(0.5, governor.GetBackgroundRatio());
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 100; i++) {
+            governor.Record(WorkClass::kOnlineQuery, i == 0 ? 1000 * 1000 : 50 * 1000);
+        }
+        governor.Adjust();
+    }
+    ASSERT_DOUBLE_EQ(0.05, governor.GetBackgroundRatio());
+    // the p99 is fast though a few queries are slow
+    for (int i = 0; i < 1000; i++) {
+        governor.Record(WorkClass::kOnlineQuery, i < 5 ? 1000 * 1000 : 100);
+    }
+    governor.Adjust();
+    ASSERT_LT(governor.GetOnlineP99(), 1000u);
+    ASSERT_NEAR(0.15, governor.GetBackgroundRatio(), 1e-9);
+    // no queries
+    for (int i = 0; i < 20; i++) {
+        governor.Adjust();
+    }
+    ASSERT_DOUBLE_EQ(1.0, governor.GetBackgroundRatio());
+    auto stat = governor.GetStat(WorkClass::kOnlineQuery);
+    ASSERT_EQ(2100u, stat.count);
+    ASSERT_EQ(0u, stat.throttled_us);
+}
+
+TEST_F(ResourceGovernorTest, NoSlo) {
+    ResourceGovernor governor(0, 0);
+    for (int i = 0; i < 100; i++) {
+        governor.Record(WorkClass::kOnlineQuery, 50 * 1000);
+    }
+    governor.Adjust();
+    ASSERT_DOUBLE_EQ(1.0, governor.GetBackgroundRatio());
+    auto start = std::chrono::steady_clock::now();
+    governor.ThrottleCpu(WorkClass::kBackground, 1000 * 1000);
+    governor.ThrottleIO(WorkClass::kBackground, 1 << 30);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+    auto stat = governor.GetStat(WorkClass::kBackground);
+    ASSERT_EQ(1u, stat.count);
+    ASSERT_EQ(1000u * 1000, stat.busy_us);
+    ASSERT_EQ(1u << 30, stat.bytes);
+}
+
+TEST_F(ResourceGovernorTest, Throttle) {
+    // 1MB per second at the full share
+    ResourceGovernor governor(1000, 1 << 20);
+    for (int i = 0; i < 100; i++) {
+        governor.Record(WorkClass::kOnlineQuery, 10 * 1000);
+    }
+    governor.Adjust();
+    ASSERT_DOUBLE_EQ(0.5, governor.GetBackgroundRatio());
+    auto start = std::chrono::steady_clock::now();
+    // busy for 50ms at half of the share, sleep for 50ms
+    governor.ThrottleCpu(WorkClass::kBackground, 50 * 1000);
+    auto cost = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(cost, std::chrono::milliseconds(50));
+    // the other classes are not throttled
+    start = std::chrono::steady_clock::now();
+    governor.ThrottleCpu(WorkClass::kReplication, 1000 * 1000);
+    governor.ThrottleIO(WorkClass::kPut, 1 << 30);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    // 512KB per second
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; i++) {
+        governor.ThrottleIO(WorkClass::kBackground, 32 * 1024);
+    }
+    cost = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(cost, std::chrono::milliseconds(120));
+    auto stat = governor.GetStat(WorkClass::kBackground);
+    ASSERT_GT(stat.throttled_us, 150u * 1000);
+    ASSERT_EQ(96u * 1024, stat.bytes);
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/snapshot_stream_loader.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/glog_wrapper.h"
+#include "base/slice.h"
+#include "gflags/gflags.h"
+#include "log/log_format.h"
+#include "log/log_reader.h"
+#include "log/sequential_file.h"
+#include "log/status.h"
+#include "proto/tablet.pb.h"
+
+DECLARE_bool(binlog_enable_crc);
+
+namespace openmldb {
+namespace tablet {
+
+// the file being received, Read blocks until the data is received
+class SnapshotStreamLoader::StreamSequentialFile : public ::openmldb::log::SequentialFile {
+ public:
+    StreamSequentialFile(SnapshotStreamLoader* loader, size_t idx, FILE* fd)
+        : loader_(loader), idx_(idx), fd_(fd), pos_(0) {}
+    ~StreamSequentialFile() override { fclose(fd_); }
+
+    ::openmldb::log::Status Read(size_t n, ::openmldb::base::Slice* result, char* scratch) override {
+        uint64_t received_size = 0;
+        if (!loader_->WaitData(idx_, pos_ + n, &received_size)) {
+            error_ = true;
+            return ::openmldb::log::Status::IOError("loading is aborted");
+        }
+        size_t len = received_size > pos_ ? std::min<uint64_t>(n, received_size - pos_) : 0;
+        size_t read = 0;
+        while (read < len) {
+            ssize_t ret = pread(fileno(fd_), scratch + read, len - read, pos_ + read);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                error_ = true;
+                return ::openmldb::log::Status::IOError("fail to read received file", strerror(errno));
+            }
+            read += ret;
+        }
+        pos_ += read;
+        *result = ::openmldb::base::Slice(scratch, read);
+        return ::openmldb::log::Status::OK();
+    }
+
+    ::openmldb::log::Status Skip(uint64_t n) override {
+        pos_ += n;
+        return ::openmldb::log::Status::OK();
+    }
+
+    ::openmldb::log::Status Tell(uint64_t* pos) override {
+        *pos = pos_;
+        return ::openmldb::log::Status::OK();
+    }
+
+    ::openmldb::log::Status Seek(uint64_t pos) override {
+        pos_ = pos;
+        return ::openmldb::log::Status::OK();
+    }
+
+    // log::Reader takes the failed read as the end of file, so the error is kept here
+    bool HasError() const { return error_; }
+
+ private:
+    SnapshotStreamLoader* loader_;
+    size_t idx_;
+    FILE* fd_;
+    uint64_t pos_;
+    bool error_ = false;
+};
+
+SnapshotStreamLoader::SnapshotStreamLoader(std::shared_ptr<storage::Table> table) : table_(std::move(table)) {
+    thread_ = std::thread(&SnapshotStreamLoader::Run, this);
+}
+
+SnapshotStreamLoader::~SnapshotStreamLoader() {
+    Abort();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    // the files which have not been loaded
+    for (size_t idx = loaded_file_num_; idx < files_.size(); idx++) {
+        if (files_[idx].fd != nullptr) {
+            fclose(files_[idx].fd);
+        }
+    }
+}
+
+bool SnapshotStreamLoader::AddFile(const std::string& file_name, const std::string& path, uint64_t received_size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (aborted_ || failed_) {
+        return false;
+    }
+    for (auto& file : files_) {
+        if (file.name == file_name) {
+            // the sender retries, the data received before is kept only if the transfer is resumed
+            if (file.finished || received_size < file.received_size) {
+                PDLOG(WARNING, "file %s is received again from %lu. tid %u pid %u", file_name.c_str(), received_size,
+                      table_->GetId(), table_->GetPid());
+                return false;
+            }
+            file.received_size = received_size;
+            cv_.notify_all();
+            return true;
+        }
+    }
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == nullptr) {
+        PDLOG(WARNING, "fail to open file %s. tid %u pid %u", path.c_str(), table_->GetId(), table_->GetPid());
+        return false;
+    }
+    StreamFile file;
+    file.name = file_name;
+    file.fd = fd;
+    file.received_size = received_size;
+    files_.push_back(std::move(file));
+    cv_.notify_all();
+    return true;
+}
+
+void SnapshotStreamLoader::UpdateReceivedSize(const std::string& file_name, uint64_t received_size) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& file : files_) {
+        if (file.name == file_name) {
+            if (received_size > file.received_size) {
+                file.received_size = received_size;
+                cv_.notify_all();
+            }
+            return;
+        }
+    }
+}
+
+void SnapshotStreamLoader::FinishFile(const std::string& file_name) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& file : files_) {
+        if (file.name == file_name) {
+            file.finished = true;
+            cv_.notify_all();
+            return;
+        }
+    }
+}
+
+void SnapshotStreamLoader::Abort() {
+    std::lock_guard<std::mutex> lock(mu_);
+    aborted_ = true;
+    cv_.notify_all();
+}
+
+bool SnapshotStreamLoader::IsReceived() {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const auto& file : files_) {
+        if (!file.finished) {
+            return false;
+        }
+    }
+    return !aborted_ && !failed_;
+}
+
+bool SnapshotStreamLoader::Wait() {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return aborted_ || failed_ || loaded_file_num_ == files_.size(); });
+    return !aborted_ && !failed_;
+}
+
+std::vector<std::string> SnapshotStreamLoader::GetFiles() {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::vector<std::string> names;
+    for (const auto& file : files_) {
+        names.push_back(file.name);
+    }
+    return names;
+}
+
+bool SnapshotStreamLoader::WaitData(size_t idx, uint64_t size, uint64_t* received_size) {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this, idx, size] {
+        return aborted_ || files_[idx].finished || files_[idx].received_size >= size;
+    });
+    *received_size = files_[idx].received_size;
+    return !aborted_;
+}
+
+void SnapshotStreamLoader::Run() {
+    while (true) {
+        size_t idx = 0;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return aborted_ || loaded_file_num_ < files_.size(); });
+            if (aborted_) {
+                return;
+            }
+            idx = loaded_file_num_;
+        }
+        bool ok = LoadFile(idx);
+        std::lock_guard<std::mutex> lock(mu_);
+        loaded_file_num_ = idx + 1;
+        if (!ok) {
+            failed_ = true;
+            cv_.notify_all();
+            return;
+        }
+        cv_.notify_all();
+    }
+}
+
+bool SnapshotStreamLoader::LoadFile(size_t idx) {
+    std::string file_name;
+    FILE* fd = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        file_name = files_[idx].name;
+        fd = files_[idx].fd;
+    }
+    bool compressed = file_name.find(::openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
+                      file_name.find(::openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos;
+    StreamSequentialFile seq_file(this, idx, fd);
+    ::openmldb::log::Reader reader(&seq_file, nullptr, FLAGS_binlog_enable_crc, 0, compressed);
+    std::string buffer;
+    ::openmldb::api::LogEntry entry;
+    uint64_t succ_cnt = 0;
+    uint64_t failed_cnt = 0;
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            failed_cnt++;
+            continue;
+        }
+        if (!entry.ParseFromArray(record.data(), record.size())) {
+            failed_cnt++;
+            continue;
+        }
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            table_->Delete(entry);
+        } else if (!table_->IsExpireOnRecover(entry)) {
+            table_->Put(entry);
+        }
+        succ_cnt++;
+    }
+    if (seq_file.HasError()) {
+        PDLOG(WARNING, "fail to load received file %s. tid %u pid %u", file_name.c_str(), table_->GetId(),
+              table_->GetPid());
+        return false;
+    }
+    loaded_cnt_.fetch_add(succ_cnt, std::memory_order_relaxed);
+    PDLOG(INFO, "load received file %s completed. succ_cnt %lu, failed_cnt %lu. tid %u pid %u", file_name.c_str(),
+          succ_cnt, failed_cnt, table_->GetId(), table_->GetPid());
+    return true;
+}
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "storage/table.h"
+
+namespace openmldb {
+namespace tablet {
+
+// SnapshotStreamLoader loads the snapshot files of a partition into a memory table while they are being received,
+// so LoadTable takes the loaded table instead of parsing the files again after the transfer. The files are loaded
+// one by one in the order they start to be received, and a file is read up to the size received continuously
+class SnapshotStreamLoader {
+ public:
+    explicit SnapshotStreamLoader(std::shared_ptr<storage::Table> table);
+    ~SnapshotStreamLoader();
+    SnapshotStreamLoader(const SnapshotStreamLoader&) = delete;
+    SnapshotStreamLoader& operator=(const SnapshotStreamLoader&) = delete;
+
+    // load the file being received at path, the data before received_size has been received. return false if
+    // the file can't be opened or it's received again from a smaller size, the loaded rows can't be undone
+    bool AddFile(const std::string& file_name, const std::string& path, uint64_t received_size);
+    void UpdateReceivedSize(const std::string& file_name, uint64_t received_size);
+    // all the data of the file has been received
+    void FinishFile(const std::string& file_name);
+    // stop loading, the table should be discarded
+    void Abort();
+    // whether all the files added have been received
+    bool IsReceived();
+    // wait for the files to be loaded, return false if loading is aborted or fails
+    bool Wait();
+
+    std::shared_ptr<storage::Table> GetTable() const { return table_; }
+    // the names of the files added in order
+    std::vector<std::string> GetFiles();
+    uint64_t GetLoadedCnt() const { return loaded_cnt_.load(std::memory_order_relaxed); }
+
+ private:
+    struct StreamFile {
+        std::string name;
+        FILE* fd = nullptr;
+        uint64_t received_size = 0;
+        bool finished = false;
+    };
+    class StreamSequentialFile;
+
+    void Run();
+    bool LoadFile(size_t idx);
+    // wait until the data before size is received or the file is finished, return the size received.
+    // return false if loading is aborted
+    bool WaitData(size_t idx, uint64_t size, uint64_t* received_size);
+
+    std::shared_ptr<storage::Table> table_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<StreamFile> files_;
+    size_t loaded_file_num_ = 0;
+    bool aborted_ = false;
+    bool failed_ = false;
+    std::atomic<uint64_t> loaded_cnt_{0};
+    std::thread thread_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/snapshot_stream_loader.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "log/log_writer.h"
+#include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
+#include "test/util.h"
+
+namespace openmldb::tablet {
+
+class SnapshotStreamLoaderTest : public ::testing::Test {
+ protected:
+    ::openmldb::test::TempPath tmp_path_;
+};
+
+static std::shared_ptr<storage::MemTable> CreateTable() {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("card", 0));
+    auto table = std::make_shared<storage::MemTable>("test", 1, 0, 8, mapping, 0,
+                                                     ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    return table;
+}
+
+// write count entries to the snapshot file at path and return the file size
+static uint64_t WriteSnapshot(const std::string& path, int count) {
+    FILE* fd = fopen(path.c_str(), "ab+");
+    ::openmldb::log::WriteHandle wh("off", path, fd);
+    for (int i = 0; i < count; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_log_index(i + 1);
+        entry.set_ts(i + 1);
+        entry.set_value("value" + std::to_string(i));
+        auto dim = entry.add_dimensions();
+        dim->set_key("card" + std::to_string(i % 10));
+        dim->set_idx(0);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        wh.Write(::openmldb::base::Slice(buffer));
+    }
+    wh.EndLog();
+    wh.Sync();
+    return wh.GetSize();
+}
+
+TEST_F(SnapshotStreamLoaderTest, LoadWhileReceiving) {
+    std::string path = tmp_path_.CreateTempPath("stream_loader");
+    std::string name1 = "20240101.sdb";
+    std::string name2 = "20240101.sdb.delta.1";
+    uint64_t size1 = WriteSnapshot(path + "/" + name1, 1000);
+    uint64_t size2 = WriteSnapshot(path + "/" + name2, 100);
+    auto table = CreateTable();
+    SnapshotStreamLoader loader(table);
+    ASSERT_TRUE(loader.AddFile(name1, path + "/" + name1, 0));
+    ASSERT_FALSE(loader.IsReceived());
+    // the data is received in blocks which are smaller than the records
+    for (uint64_t received = 0; received < size1;) {
+        received = std::min<uint64_t>(received + 1000, size1);
+        loader.UpdateReceivedSize(name1, received);
+    }
+    loader.FinishFile(name1);
+    ASSERT_TRUE(loader.AddFile(name2, path + "/" + name2, size2));
+    loader.FinishFile(name2);
+    ASSERT_TRUE(loader.IsReceived());
+    ASSERT_TRUE(loader.Wait());
+    ASSERT_EQ(1100u, loader.GetLoadedCnt());
+    ASSERT_EQ(1100u, table->GetRecordCnt());
+    std::vector<std::string> files = {name1, name2};
+    ASSERT_EQ(files, loader.GetFiles());
+    // the file has been received can't be received again
+    ASSERT_FALSE(loader.AddFile(name1, path + "/" + name1, 0));
+}
+
+TEST_F(SnapshotStreamLoaderTest, Abort) {
+    std::string path = tmp_path_.CreateTempPath("stream_loader");
+    std::string name = "20240101.sdb";
+    uint64_t size = WriteSnapshot(path + "/" + name, 1000);
+    auto table = CreateTable();
+    {
+        SnapshotStreamLoader loader(table);
+        ASSERT_TRUE(loader.AddFile(name, path + "/" + name, size / 2));
+        // the transfer restarts from the beginning
+        ASSERT_FALSE(loader.AddFile(name, path + "/" + name, 0));
+        loader.Abort();
+        ASSERT_FALSE(loader.IsReceived());
+        ASSERT_FALSE(loader.Wait());
+        ASSERT_FALSE(loader.AddFile("20240101.sdb.delta.1", path + "/" + name, 0));
+    }
+    {
+        // the file doesn't exist
+        SnapshotStreamLoader loader(CreateTable());
+        ASSERT_FALSE(loader.AddFile(name, path + "/not_exist", 0));
+    }
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
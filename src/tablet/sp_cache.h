@@ -78,6 +78,26 @@ class SpCache : public hybridse::vm::CompileInfoCache {
         db_sp_map_[db].erase(sp_name);
         return;
     }
+    // whether the table is used by any procedure or deployment
+    bool IsTableUsed(const std::string& db, const std::string& table) const {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        for (const auto& db_kv : db_sp_map_) {
+            for (const auto& sp_kv : db_kv.second) {
+                const auto& procedure_info = sp_kv.second.procedure_info;
+                if (!procedure_info) {
+                    continue;
+                }
+                const auto& dbs = procedure_info->GetDbs();
+                const auto& tables = procedure_info->GetTables();
+                for (size_t i = 0; i < tables.size() && i < dbs.size(); i++) {
+                    if (tables[i] == table && dbs[i] == db) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
     const bool ProcedureExist(const std::string& db, const std::string& sp_name) {
         std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
         auto& sp_map_of_db = db_sp_map_[db];
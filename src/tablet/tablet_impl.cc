@@ -28,6 +28,8 @@
 #include <snappy.h>
 
 #include <algorithm>
+#include <atomic>
+#include <shared_mutex>
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
@@ -40,14 +42,17 @@
 #include "base/glog_wrapper.h"
 #include "base/hash.h"
 #include "base/memory_stat.h"
+#include "base/numa_util.h"
 #include "base/proto_util.h"
 #include "base/status.h"
 #include "base/strings.h"
 #include "base/sys_info.h"
+#include "base/taskpool.hpp"
 #include "boost/bind.hpp"
 #include "boost/container/deque.hpp"
 #include "brpc/controller.h"
 #include "butil/iobuf.h"
+#include "bvar/bvar.h"
 #include "codec/codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
@@ -62,6 +67,7 @@
 #include "google/protobuf/text_format.h"
 #include "nameserver/task.h"
 #include "schema/schema_adapter.h"
+#include "storage/background_throttle.h"
 #include "storage/binlog.h"
 #include "storage/disk_table_snapshot.h"
 #include "storage/index_organized_table.h"
@@ -105,7 +111,15 @@ DECLARE_uint32(load_index_max_wait_time);
 DECLARE_bool(use_name);
 DECLARE_bool(enable_distsql);
 DECLARE_string(snapshot_compression);
+DECLARE_bool(make_snapshot_image);
+DECLARE_bool(make_snapshot_from_memory);
+DECLARE_uint32(index_data_thread_num);
+DECLARE_uint32(snapshot_read_ahead_size);
 DECLARE_string(file_compression);
+DECLARE_string(binlog_sync_compress_type);
+DECLARE_int32(binlog_apply_pool_size);
+DECLARE_uint32(binlog_semi_sync_ack_num);
+DECLARE_uint32(binlog_semi_sync_timeout_ms);
 DECLARE_int32(request_timeout_ms);
 
 // cluster config
@@ -127,11 +141,33 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_bool(stream_load_snapshot);
+DECLARE_uint32(recover_thread_num);
+DECLARE_uint32(recover_memory_budget_mb);
+DECLARE_uint32(procedure_result_cache_size_mb);
+DECLARE_uint32(procedure_result_cache_ttl_ms);
+DECLARE_uint32(request_coalesce_window_us);
+DECLARE_uint32(request_coalesce_max_batch_size);
+DECLARE_bool(numa_mode);
+DECLARE_uint32(numa_thread_num_per_node);
+DECLARE_uint32(numa_max_pending_task_num);
+DECLARE_uint32(online_latency_slo_ms);
+DECLARE_uint32(background_io_limit_mb);
+DECLARE_uint32(resource_governor_interval_ms);
+DECLARE_uint32(traverse_cursor_max_num);
+DECLARE_uint32(traverse_cursor_idle_timeout_ms);
+DECLARE_string(jit_object_cache_dir);
+DECLARE_uint32(jit_object_cache_max_size_mb);
+DECLARE_uint32(procedure_compile_thread_num);
+DECLARE_bool(enable_parameterize_literal);
+DECLARE_uint32(tiered_compile_threshold);
 
 namespace openmldb {
 namespace tablet {
 
 static const uint32_t SEED = 0xe17a1465;
+static constexpr uint32_t LOAD_INDEX_BATCH = 1024;
+static constexpr uint64_t LOAD_INDEX_PROGRESS_INTERVAL = 1000000;
 
 static constexpr const char DEPLOY_STATS[] = "deploy_stats";
 
@@ -146,6 +182,10 @@ TabletImpl::TabletImpl()
       task_pool_(FLAGS_task_pool_size),
       io_pool_(FLAGS_io_pool_size),
       snapshot_pool_(FLAGS_snapshot_pool_size),
+      binlog_apply_pool_(FLAGS_binlog_apply_pool_size),
+      recovery_scheduler_(FLAGS_recover_thread_num, static_cast<uint64_t>(FLAGS_recover_memory_budget_mb) << 20),
+      resource_governor_(static_cast<uint64_t>(FLAGS_online_latency_slo_ms) * 1000,
+                         static_cast<uint64_t>(FLAGS_background_io_limit_mb) << 20),
       mode_root_paths_(),
       mode_recycle_root_paths_(),
       follower_(false),
@@ -155,17 +195,31 @@ TabletImpl::TabletImpl()
       zk_path_(),
       endpoint_(),
       sp_cache_(std::shared_ptr<SpCache>(new SpCache())),
+      result_cache_(FLAGS_procedure_result_cache_size_mb > 0
+                        ? std::make_unique<ProcedureResultCache>(
+                              static_cast<uint64_t>(FLAGS_procedure_result_cache_size_mb) << 20,
+                              FLAGS_procedure_result_cache_ttl_ms)
+                        : nullptr),
+      request_coalescer_(FLAGS_request_coalesce_window_us > 0
+                             ? std::make_unique<RequestCoalescer>(FLAGS_request_coalesce_window_us,
+                                                                  FLAGS_request_coalesce_max_batch_size)
+                             : nullptr),
       notify_path_(),
       globalvar_changed_notify_path_(),
       startup_mode_(::openmldb::type::StartupMode::kStandalone),
       user_access_manager_(GetSystemTableIterator()) {}
 
 TabletImpl::~TabletImpl() {
+    recovery_scheduler_.Stop();
+    if (numa_dispatcher_) {
+        numa_dispatcher_->Stop();
+    }
     task_pool_.Stop(true);
     trivial_task_pool_.Stop(true);
     gc_pool_.Stop(true);
     io_pool_.Stop(true);
     snapshot_pool_.Stop(true);
+    binlog_apply_pool_.Stop(true);
     if (zk_client_) {
         delete zk_client_;
     }
@@ -201,6 +255,21 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     // rpc_server_<port> if standalone, diy
     deploy_collector_ = std::make_unique<::openmldb::statistics::DeploymentMetricCollector>(
         "rpc_server_" + endpoint.substr(endpoint.find(":") + 1));
+    resource_governor_.Expose("rpc_server_" + endpoint.substr(endpoint.find(":") + 1));
+    if (FLAGS_numa_mode) {
+        std::vector<std::vector<int>> node_cpus;
+        if (::openmldb::base::GetNumaNodeCpus(&node_cpus)) {
+            numa_dispatcher_ = std::make_unique<NumaDispatcher>(node_cpus, FLAGS_numa_thread_num_per_node,
+                                                                FLAGS_numa_max_pending_task_num);
+            PDLOG(INFO, "numa mode is enabled with %u nodes", numa_dispatcher_->GetNodeNum());
+        } else {
+            PDLOG(WARNING, "fail to get numa topology, numa mode is disabled");
+        }
+    }
+    if (FLAGS_traverse_cursor_max_num > 0) {
+        traverse_cursors_ = std::make_unique<TraverseCursorManager>(FLAGS_traverse_cursor_max_num,
+                                                                    FLAGS_traverse_cursor_idle_timeout_ms);
+    }
 
     if (!zk_cluster.empty()) {
         zk_client_ = new ZkClient(zk_cluster, real_endpoint, FLAGS_zk_session_timeout, endpoint, zk_path,
@@ -222,7 +291,12 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.jit_options().SetObjectCacheDir(FLAGS_jit_object_cache_dir);
+    options.jit_options().SetObjectCacheMaxSize(static_cast<uint64_t>(FLAGS_jit_object_cache_max_size_mb) << 20);
+    options.SetEnableParameterizeLiteral(FLAGS_enable_parameterize_literal);
+    options.SetTieredCompileThreshold(FLAGS_tiered_compile_threshold);
     engine_ = std::make_unique<::hybridse::vm::Engine>(catalog_, options);
+    ExposeEngineCacheStat("rpc_server_" + endpoint.substr(endpoint.find(":") + 1));
     catalog_->SetLocalTablet(std::make_shared<::hybridse::vm::LocalTablet>(engine_.get(), sp_cache_));
     std::set<std::string> snapshot_compression_set{"off", "zlib", "snappy"};
     if (snapshot_compression_set.find(FLAGS_snapshot_compression) == snapshot_compression_set.end()) {
@@ -234,6 +308,11 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         LOG(ERROR) << "wrong FLAGS_file_compression: " << FLAGS_file_compression;
         return false;
     }
+    std::set<std::string> binlog_sync_compress_set{"off", "snappy"};
+    if (binlog_sync_compress_set.find(FLAGS_binlog_sync_compress_type) == binlog_sync_compress_set.end()) {
+        LOG(ERROR) << "wrong binlog_sync_compress_type: " << FLAGS_binlog_sync_compress_type;
+        return false;
+    }
     if (FLAGS_make_snapshot_time < 0 || FLAGS_make_snapshot_time > 23) {
         PDLOG(ERROR, "make_snapshot_time[%d] is illegal.", FLAGS_make_snapshot_time);
         return false;
@@ -327,6 +406,12 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
 #if defined(__linux__)
     trivial_task_pool_.DelayTask(FLAGS_get_sys_mem_interval, boost::bind(&TabletImpl::UpdateMemoryUsage, this));
 #endif
+    trivial_task_pool_.DelayTask(FLAGS_resource_governor_interval_ms,
+                                 boost::bind(&TabletImpl::AdjustResourceGovernor, this));
+    if (traverse_cursors_) {
+        trivial_task_pool_.DelayTask(FLAGS_traverse_cursor_idle_timeout_ms,
+                                     boost::bind(&TabletImpl::ExpireTraverseCursor, this));
+    }
     return true;
 }
 
@@ -448,6 +533,44 @@ bool TabletImpl::CheckGetDone(::openmldb::api::GetType type, uint64_t ts, uint64
     return false;
 }
 
+void TabletImpl::AdjustResourceGovernor() {
+    resource_governor_.Adjust();
+    trivial_task_pool_.DelayTask(FLAGS_resource_governor_interval_ms,
+                                 boost::bind(&TabletImpl::AdjustResourceGovernor, this));
+}
+
+void TabletImpl::ExposeEngineCacheStat(const std::string& prefix) {
+    using GetStatFn = int64_t (*)(void*);
+    const std::vector<std::pair<std::string, GetStatFn>> stats = {
+        {"engine_cache_hit",
+         [](void* arg) -> int64_t { return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().hit; }},
+        {"engine_cache_miss",
+         [](void* arg) -> int64_t { return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().miss; }},
+        {"engine_cache_shared",
+         [](void* arg) -> int64_t { return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().shared; }},
+        {"engine_compile_count",
+         [](void* arg) -> int64_t { return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().compile_cnt; }},
+        {"engine_compile_time_us",
+         [](void* arg) -> int64_t {
+             return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().compile_time_us;
+         }},
+        {"engine_recompile_count",
+         [](void* arg) -> int64_t {
+             return static_cast<::hybridse::vm::Engine*>(arg)->GetCacheStat().recompile_cnt;
+         }},
+    };
+    engine_cache_vars_.clear();
+    for (const auto& [name, fn] : stats) {
+        engine_cache_vars_.emplace_back(new bvar::PassiveStatus<int64_t>(prefix, name, fn, engine_.get()));
+    }
+}
+
+void TabletImpl::ExpireTraverseCursor() {
+    traverse_cursors_->ExpireIdle();
+    trivial_task_pool_.DelayTask(FLAGS_traverse_cursor_idle_timeout_ms,
+                                 boost::bind(&TabletImpl::ExpireTraverseCursor, this));
+}
+
 void TabletImpl::UpdateMemoryUsage() {
     base::SysInfo info;
     if (auto status = base::GetSysMem(&info); status.OK()) {
@@ -713,7 +836,19 @@ void TabletImpl::Get(RpcController* controller, const ::openmldb::api::GetReques
 
 void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
                      ::openmldb::api::PutResponse* response, Closure* done) {
+    // the memory of the rows is allocated on the node of the partition
+    if (numa_dispatcher_ && numa_dispatcher_->Dispatch(request->tid(), request->pid(),
+                                                       [this, controller, request, response, done] {
+                                                           Put(controller, request, response, done);
+                                                       })) {
+        return;
+    }
     brpc::ClosureGuard done_guard(done);
+    auto start = absl::Now();
+    absl::Cleanup record_task = [this, request, start]() {
+        resource_governor_.Record(WorkClass::kPut, absl::ToInt64Microseconds(absl::Now() - start),
+                                  request->value().size());
+    };
     if (follower_.load(std::memory_order_relaxed)) {
         response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
         response->set_msg("is follower cluster");
@@ -753,6 +888,12 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
     }
 
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    // the rows of table are pinned while no put is between the table and binlog
+    std::shared_lock<std::shared_mutex> write_lock;
+    if (replicator) {
+        write_lock = std::shared_lock<std::shared_mutex>(replicator->GetWriteMutex());
+    }
     absl::Status st;
     if (request->dimensions_size() > 0) {
         int32_t ret_code = CheckDimessionPut(request, table->GetIdxCnt());
@@ -814,10 +955,8 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
-    std::shared_ptr<LogReplicator> replicator;
     bool ok = false;
     do {
-        replicator = GetReplicator(request->tid(), request->pid());
         if (!replicator) {
             PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
             break;
@@ -839,6 +978,9 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
             return;
         }
     } while (false);
+    if (write_lock.owns_lock()) {
+        write_lock.unlock();
+    }
 
     uint64_t end_time = ::baidu::common::timer::get_micros();
     if (start_time + FLAGS_put_slow_log_threshold < end_time) {
@@ -858,8 +1000,9 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         PDLOG(INFO, "slow log[put]. key %s time %lu. tid %u, pid %u", key.c_str(), end_time - start_time, tid, pid);
     }
 
+    bool semi_sync = replicator && FLAGS_binlog_semi_sync_ack_num > 0;
     if (replicator) {
-        if (FLAGS_binlog_notify_on_put) {
+        if (FLAGS_binlog_notify_on_put || semi_sync) {
             replicator->Notify();
         }
     }
@@ -868,6 +1011,11 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
         UpdateGlobalVarTable();
     }
+    if (semi_sync) {
+        // the response is sent after followers ack or timeout, the worker is not blocked
+        replicator->WaitForAck(entry.log_index(), FLAGS_binlog_semi_sync_ack_num, FLAGS_binlog_semi_sync_timeout_ms,
+                               done_guard.release());
+    }
 }
 
 int32_t TabletImpl::ScanIndex(const ::openmldb::api::ScanRequest* request, const ::openmldb::api::TableMeta& meta,
@@ -1281,49 +1429,73 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
         response->set_msg("idx name not found");
         return;
     }
-    ::openmldb::storage::TableIterator* it = table->NewTraverseIterator(index_def->GetId());
-    if (it == nullptr) {
-        response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
-        response->set_msg("create iterator failed");
-        return;
+    std::unique_ptr<TraverseCursor> cursor;
+    if (traverse_cursors_ && request->cursor_id() > 0) {
+        cursor = traverse_cursors_->Take(request->cursor_id());
+        if (cursor && (cursor->tid != tid || cursor->pid != pid || cursor->idx != index_def->GetId())) {
+            cursor.reset();
+        }
     }
+    std::unique_ptr<::openmldb::storage::TableIterator> it;
     uint64_t last_time = 0;
     std::string last_pk;
     uint32_t ts_pos = 0;
-    if (request->has_pk() && request->pk().size() > 0) {
-        DLOG(INFO) << "tid " << tid << ", pid " << pid << " seek pk " << request->pk() << " ts " << request->ts();
-        it->Seek(request->pk(), request->ts());
-        last_pk = request->pk();
-        last_time = request->ts();
-        if (request->has_ts_pos()) {
-            ts_pos = request->ts_pos();
-        }
-        auto traverse_it = dynamic_cast<::openmldb::storage::TraverseIterator*>(it);
-        if (traverse_it && traverse_it->Valid() && traverse_it->GetPK() == last_pk) {
-            if (request->skip_current_pk()) {
-                traverse_it->NextPK();
-            } else if (traverse_it->GetKey() == last_time) {
-                uint32_t skip_cnt = request->has_ts_pos() ? request->ts_pos() : 1;
-                while (skip_cnt > 0 && traverse_it->Valid() && traverse_it->GetPK() == last_pk &&
-                       traverse_it->GetKey() == last_time) {
-                    traverse_it->Next();
-                    skip_cnt--;
+    uint64_t gc_round = 0;
+    if (cursor) {
+        // continue from the record after the last request, the seek is not required
+        DEBUGLOG("tid %u, pid %u resume from cursor %lu", tid, pid, request->cursor_id());
+        it = std::move(cursor->it);
+        it->ResetCount();
+        last_pk = std::move(cursor->last_pk);
+        last_time = cursor->last_time;
+        ts_pos = cursor->ts_pos;
+    } else {
+        if (traverse_cursors_) {
+            gc_round = traverse_cursors_->GetGcRound(tid, pid);
+        }
+        it.reset(table->NewTraverseIterator(index_def->GetId()));
+        if (!it) {
+            response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
+            response->set_msg("create iterator failed");
+            return;
+        }
+        if (request->has_pk() && request->pk().size() > 0) {
+            DLOG(INFO) << "tid " << tid << ", pid " << pid << " seek pk " << request->pk() << " ts " << request->ts();
+            it->Seek(request->pk(), request->ts());
+            last_pk = request->pk();
+            last_time = request->ts();
+            if (request->has_ts_pos()) {
+                ts_pos = request->ts_pos();
+            }
+            auto traverse_it = dynamic_cast<::openmldb::storage::TraverseIterator*>(it.get());
+            if (traverse_it && traverse_it->Valid() && traverse_it->GetPK() == last_pk) {
+                if (request->skip_current_pk()) {
+                    traverse_it->NextPK();
+                } else if (traverse_it->GetKey() == last_time) {
+                    uint32_t skip_cnt = request->has_ts_pos() ? request->ts_pos() : 1;
+                    while (skip_cnt > 0 && traverse_it->Valid() && traverse_it->GetPK() == last_pk &&
+                           traverse_it->GetKey() == last_time) {
+                        traverse_it->Next();
+                        skip_cnt--;
+                    }
                 }
             }
+        } else {
+            DEBUGLOG("tid %u, pid %u seek to first", tid, pid);
+            it->SeekToFirst();
         }
-    } else {
-        DEBUGLOG("tid %u, pid %u seek to first", tid, pid);
-        it->SeekToFirst();
     }
     bool remove_duplicated_record = false;
     if (request->has_enable_remove_duplicated_record()) {
         remove_duplicated_record = request->enable_remove_duplicated_record();
     }
     uint32_t scount = 0;
+    bool reach_limit = false;
     butil::IOBuf buf;
     for (; it->Valid(); it->Next()) {
         if (request->limit() > 0 && scount > request->limit() - 1) {
             DEBUGLOG("reache the limit %u ", request->limit());
+            reach_limit = true;
             break;
         }
         DEBUGLOG("traverse pk %s ts %lu", it->GetPK().c_str(), it->GetKey());
@@ -1365,7 +1537,26 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
         is_finish = true;
     }
     buf.copy_to(response->mutable_pairs());
-    delete it;
+    // the iterator stops at the first record not returned only if the limit is reached
+    if (traverse_cursors_ && request->keep_cursor() && reach_limit && !is_finish && it->Valid()) {
+        if (!cursor) {
+            cursor = std::make_unique<TraverseCursor>();
+            cursor->gc_round = gc_round;
+        }
+        cursor->tid = tid;
+        cursor->pid = pid;
+        cursor->idx = index_def->GetId();
+        cursor->table = table;
+        cursor->it = std::move(it);
+        cursor->last_pk = last_pk;
+        cursor->last_time = last_time;
+        cursor->ts_pos = ts_pos;
+        // the cursor is dropped if a gc round of the partition started after the iterator is created
+        uint64_t cursor_id = traverse_cursors_->Put(std::move(cursor));
+        if (cursor_id > 0) {
+            response->set_cursor_id(cursor_id);
+        }
+    }
     DLOG(INFO) << "tid " << tid << " pid " << pid << " traverse count " << scount << " last_pk " << last_pk
                << " last_time " << last_time << " ts_pos " << ts_pos;
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -1727,6 +1918,7 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
                               ::openmldb::api::QueryResponse* response, butil::IOBuf* buf) {
     auto start = absl::Now();
     absl::Cleanup deploy_collect_task = [this, is_sub, request, start]() {
+        this->resource_governor_.Record(WorkClass::kOnlineQuery, absl::ToInt64Microseconds(absl::Now() - start));
         if (this->IsCollectDeployStatsEnabled()) {
             if (!is_sub && request->is_procedure() && request->has_db() && request->has_sp_name()) {
                 this->TryCollectDeployStats(request->db(), request->sp_name(), start);
@@ -1831,7 +2023,11 @@ void TabletImpl::ProcessQuery(bool is_sub, RpcController* ctrl, const openmldb::
                 }
                 session.SetCompileInfo(request_compile_info);
                 session.SetSpName(sp_name);
-                RunRequestQuery(ctrl, *request, session, *response, *buf);
+                if (result_cache_ && !request->has_task_id() && !request->is_debug()) {
+                    RunCachedRequestQuery(ctrl, *request, session, *response, *buf);
+                } else {
+                    RunRequestQuery(ctrl, *request, session, *response, *buf);
+                }
             } else {
                 bool ok = engine_->Get(request->sql(), request->db(), session, status);
                 if (!ok || session.GetCompileInfo() == nullptr) {
@@ -1934,6 +2130,7 @@ void TabletImpl::ProcessBatchRequestQuery(bool is_sub, RpcController* ctrl,
                                           openmldb::api::SQLBatchRequestQueryResponse* response, butil::IOBuf& buf) {
     absl::Time start = absl::Now();
     absl::Cleanup deploy_collect_task = [this, is_sub, request, start]() {
+        this->resource_governor_.Record(WorkClass::kOnlineQuery, absl::ToInt64Microseconds(absl::Now() - start));
         if (this->IsCollectDeployStatsEnabled()) {
             if (!is_sub && request->is_procedure() && request->has_db() && request->has_sp_name()) {
                 this->TryCollectDeployStats(request->db(), request->sp_name(), start);
@@ -2329,6 +2526,12 @@ void TabletImpl::DelReplica(RpcController* controller, const ::openmldb::api::Re
 void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                                ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
+    auto start = absl::Now();
+    // the entries are sent in the request rather than the attachment
+    absl::Cleanup record_task = [this, request, start]() {
+        resource_governor_.Record(WorkClass::kReplication, absl::ToInt64Microseconds(absl::Now() - start),
+                                  request->ByteSizeLong());
+    };
     uint32_t tid = request->tid();
     uint32_t pid = request->pid();
     auto table = GetTable(tid, pid);
@@ -2361,8 +2564,12 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
     uint64_t last_log_offset = replicator->GetOffset();
-    if (request->pre_log_index() == 0 && request->entries_size() == 0) {
+    if (request->pre_log_index() == 0 && request->entries_size() == 0 && !request->has_compressed_entries()) {
         response->set_log_offset(last_log_offset);
+        // accept the compress type proposed by leader
+        if (request->compress_type() == ::openmldb::type::CompressType::kSnappy) {
+            response->set_compress_type(::openmldb::type::CompressType::kSnappy);
+        }
         if (!FLAGS_zk_cluster.empty() && request->term() > term) {
             replicator->SetLeaderTerm(request->term());
             PDLOG(INFO, "get log_offset %lu and set term %lu. tid %u, pid %u", last_log_offset, request->term(), tid,
@@ -2372,19 +2579,62 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
-    for (int32_t i = 0; i < request->entries_size(); i++) {
-        const auto& entry = request->entries(i);
+    if (request->compress_type() == ::openmldb::type::CompressType::kSnappy) {
+        // uncompressing and parsing the batch don't block the rpc thread. ApplyEntries serializes the batches of
+        // the partition, so a batch resent by the leader can't be applied concurrently with the stale one
+        std::move(record_task).Cancel();
+        binlog_apply_pool_.AddTask([this, request, response, done = done_guard.release(), table, replicator,
+                                    start] {
+            brpc::ClosureGuard done_guard(done);
+            uint32_t tid = request->tid();
+            uint32_t pid = request->pid();
+            std::string raw;
+            ::openmldb::api::LogEntryBatch batch;
+            if (!::snappy::Uncompress(request->compressed_entries().data(), request->compressed_entries().size(),
+                                      &raw) ||
+                !batch.ParseFromString(raw)) {
+                PDLOG(WARNING, "fail to uncompress entries. tid %u pid %u", tid, pid);
+                response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+                response->set_msg("fail to uncompress entries");
+            } else {
+                ApplyEntries(tid, pid, batch.entries(), table, replicator, response);
+            }
+            resource_governor_.Record(WorkClass::kReplication, absl::ToInt64Microseconds(absl::Now() - start),
+                                      request->ByteSizeLong());
+        });
+        return;
+    }
+    ApplyEntries(tid, pid, request->entries(), table, replicator, response);
+}
+
+void TabletImpl::ApplyEntries(uint32_t tid, uint32_t pid,
+                              const ::google::protobuf::RepeatedPtrField<::openmldb::api::LogEntry>& entries,
+                              const std::shared_ptr<Table>& table, const std::shared_ptr<LogReplicator>& replicator,
+                              ::openmldb::api::AppendEntriesResponse* response) {
+    // the batches of a partition may run both in the rpc thread and in binlog_apply_pool_, the offset is only
+    // checked and advanced under the lock
+    std::lock_guard<std::mutex> apply_lock(replicator->GetApplyMutex());
+    // the entry is appended before it's put, the rows of table can't be pinned until the batch has been put
+    std::shared_lock<std::shared_mutex> write_lock(replicator->GetWriteMutex());
+    uint64_t last_log_offset = replicator->GetOffset();
+    for (const auto& entry : entries) {
         if (entry.log_index() <= last_log_offset) {
-            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", request->entries(i).log_index(),
-                  last_log_offset, tid, pid);
+            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", entry.log_index(), last_log_offset,
+                  tid, pid);
             continue;
         }
-        if (!replicator->ApplyEntry(entry)) {
+        bool appended = false;
+        if (!replicator->ApplyEntry(entry, &appended)) {
             PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entries to replicator");
             return;
         }
+        if (!appended) {
+            // it has been written to the binlog and the table already
+            continue;
+        }
+        last_log_offset = entry.log_index();
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
             table->Delete(entry);         // TODO(hw): error handle
         } else if (!table->Put(entry)) {  // put if type is not delete
@@ -2497,6 +2747,10 @@ void TabletImpl::UpdateTableMetaForAddField(RpcController* controller,
 void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api::GetTableStatusRequest* request,
                                 ::openmldb::api::GetTableStatusResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
+    std::map<std::pair<uint32_t, uint32_t>, int64_t> recover_eta;
+    for (const auto& status : recovery_scheduler_.GetStatus()) {
+        recover_eta.emplace(std::make_pair(status.tid, status.pid), status.eta);
+    }
     std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
     for (auto it = tables_.begin(); it != tables_.end(); ++it) {
         if (request->has_tid() && request->tid() != it->first) {
@@ -2526,6 +2780,10 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
                 status->set_offset(replicator->GetOffset());
             }
             status->set_record_cnt(table->GetRecordCnt());
+            auto recover_iter = recover_eta.find(std::make_pair(table->GetId(), table->GetPid()));
+            if (recover_iter != recover_eta.end()) {
+                status->set_recover_eta(recover_iter->second);
+            }
             if (table->GetStorageMode() == common::kMemory) {
                 if (MemTable* mem_table = dynamic_cast<MemTable*>(table.get())) {
                     status->set_is_expire(mem_table->GetExpireStatus());
@@ -2612,6 +2870,9 @@ void TabletImpl::SetExpire(RpcController* controller, const ::openmldb::api::Set
 void TabletImpl::MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_offset,
                                       std::shared_ptr<::openmldb::api::TaskInfo> task, bool is_force) {
     PDLOG(INFO, "MakeSnapshotInternal begin, tid[%u] pid[%u]", tid, pid);
+    // throttled while the task runs, the loops of the task report the busy time in slices
+    ::openmldb::storage::BackgroundThrottle throttle(
+        [this](uint64_t busy_us) { resource_governor_.ThrottleCpu(WorkClass::kBackground, busy_us); });
     std::shared_ptr<Table> table;
     std::shared_ptr<Snapshot> snapshot;
     std::shared_ptr<LogReplicator> replicator;
@@ -2660,9 +2921,35 @@ void TabletImpl::MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_o
               tid, pid, cur_offset, snapshot_offset, end_offset);
     } else {
         uint64_t offset = 0;
-        ret = snapshot->MakeSnapshot(table, offset, end_offset, replicator->GetLeaderTerm());
+        auto mem_snapshot = std::dynamic_pointer_cast<::openmldb::storage::MemTableSnapshot>(snapshot);
+        auto mem_table = std::dynamic_pointer_cast<::openmldb::storage::MemTable>(table);
+        // the rows of bulk load are loaded to table long after their entries are appended to binlog, the table
+        // isn't dumped until they are loaded
+        bool is_mem_table = mem_snapshot && mem_table &&
+                            !std::dynamic_pointer_cast<::openmldb::storage::IndexOrganizedTable>(table) &&
+                            !bulk_load_mgr_.GetDataReceiver(tid, pid, BulkLoadMgr::DO_NOT_CREATE);
+        auto pin_view = [replicator, mem_table] {
+            std::unique_lock<std::shared_mutex> lock(replicator->GetWriteMutex());
+            return ::openmldb::storage::MemTableView{replicator->GetOffset(), mem_table->GetPutSeq()};
+        };
+        ret = -1;
+        if (FLAGS_make_snapshot_from_memory && end_offset == 0 && is_mem_table) {
+            ret = mem_snapshot->MakeSnapshotFromMemory(table, pin_view, replicator->GetLeaderTerm(), offset);
+            if (ret < 0) {
+                PDLOG(WARNING, "fail to make snapshot from memory, replay binlog instead. tid[%u] pid[%u]", tid, pid);
+            }
+        }
+        if (ret < 0) {
+            ret = snapshot->MakeSnapshot(table, offset, end_offset, replicator->GetLeaderTerm());
+        }
         if (ret == 0) {
             replicator->SetSnapshotLogPartIndex(offset);
+            if (FLAGS_make_snapshot_image && end_offset == 0 && is_mem_table) {
+                // the image only speeds up the recovery, the snapshot is still available if it fails
+                if (mem_snapshot->MakeImage(table, pin_view) < 0) {
+                    PDLOG(WARNING, "fail to make image. tid[%u] pid[%u]", tid, pid);
+                }
+            }
         }
     }
     {
@@ -2768,7 +3055,7 @@ void TabletImpl::SchedMakeSnapshot() {
 }
 
 void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::SendDataRequest* request,
-                          ::openmldb::api::GeneralResponse* response, Closure* done) {
+                          ::openmldb::api::SendDataResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
     brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
     uint32_t tid = request->tid();
@@ -2817,7 +3104,8 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
                     std::make_pair(combine_key, std::make_shared<FileReceiver>(request->file_name(), dir_name, path)));
                 iter = file_receiver_map_.find(combine_key);
             }
-            if (!iter->second->Init()) {
+            bool init_ok = request->has_offset() ? iter->second->Init(request->file_size()) : iter->second->Init();
+            if (!init_ok) {
                 PDLOG(WARNING, "file receiver init failed. tid %u, pid %u, file_name %s", tid, pid,
                       request->file_name().c_str());
                 response->set_code(::openmldb::base::ReturnCode::kFileReceiverInitFailed);
@@ -2826,6 +3114,9 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
                 return;
             }
             PDLOG(INFO, "file receiver init ok. tid %u, pid %u, file_name %s", tid, pid, request->file_name().c_str());
+            if (request->has_offset()) {
+                response->set_received_size(iter->second->GetReceivedSize());
+            }
             response->set_code(::openmldb::base::ReturnCode::kOk);
             response->set_msg("ok");
         } else if (iter == file_receiver_map_.end()) {
@@ -2843,6 +3134,62 @@ void TabletImpl::SendData(RpcController* controller, const ::openmldb::api::Send
         response->set_msg("cannot find receiver");
         return;
     }
+    if (request->has_offset()) {
+        if (request->block_id() == 0) {
+            if (FLAGS_stream_load_snapshot && mode == ::openmldb::common::kMemory && request->dir_name().empty() &&
+                request->file_name() != "MANIFEST") {
+                AddStreamFile(tid, pid, GetDBPath(db_root_path, tid, pid), request->file_name(),
+                              response->received_size());
+            }
+            return;
+        }
+        std::shared_ptr<SnapshotStreamLoader> loader;
+        if (FLAGS_stream_load_snapshot && mode == ::openmldb::common::kMemory && request->dir_name().empty()) {
+            loader = GetStreamLoader(tid, pid);
+        }
+        if (cntl->request_attachment().size() != request->block_size()) {
+            PDLOG(WARNING, "receive data error. tid %u, pid %u, file_name %s, expected length %u real length %lu", tid,
+                  pid, request->file_name().c_str(), request->block_size(), cntl->request_attachment().size());
+            response->set_code(::openmldb::base::ReturnCode::kReceiveDataError);
+            response->set_msg("receive data error");
+            return;
+        }
+        if (receiver->WriteBlock(request->offset(), &cntl->request_attachment()) < 0) {
+            PDLOG(WARNING, "receiver write data failed. tid %u, pid %u, file_name %s", tid, pid,
+                  request->file_name().c_str());
+            if (loader) {
+                loader->Abort();
+            }
+            response->set_code(::openmldb::base::ReturnCode::kWriteDataFailed);
+            response->set_msg("write data failed");
+            return;
+        }
+        if (loader) {
+            loader->UpdateReceivedSize(request->file_name(), receiver->GetReceivedSize());
+        }
+        if (request->eof()) {
+            // the sender sends eof after all the other blocks are acknowledged
+            if (receiver->GetReceivedSize() != request->file_size()) {
+                PDLOG(WARNING, "file is incomplete. tid %u, pid %u, file_name %s, received %lu file size %lu", tid,
+                      pid, request->file_name().c_str(), receiver->GetReceivedSize(), request->file_size());
+                if (loader) {
+                    loader->Abort();
+                }
+                response->set_code(::openmldb::base::ReturnCode::kReceiveDataError);
+                response->set_msg("file is incomplete");
+                return;
+            }
+            if (loader) {
+                loader->FinishFile(request->file_name());
+            }
+            receiver->SaveFile();
+            std::lock_guard<std::mutex> lock(mu_);
+            file_receiver_map_.erase(combine_key);
+        }
+        response->set_msg("ok");
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+        return;
+    }
     if (receiver->GetBlockId() == request->block_id()) {
         response->set_msg("ok");
         response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -2966,6 +3313,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
             real_endpoint = iter->second;
         }
         FileSender sender(remote_tid, pid, table->GetStorageMode(), real_endpoint);
+        sender.SetResourceGovernor(&resource_governor_);
         if (!sender.Init()) {
             PDLOG(WARNING, "Init FileSender failed. tid[%u] pid[%u] endpoint[%s]", tid, pid, endpoint.c_str());
             break;
@@ -2979,7 +3327,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         }
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
-        std::string snapshot_file;
+        std::vector<std::string> snapshot_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2994,20 +3342,26 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 PDLOG(WARNING, "parse manifest failed. tid[%u] pid[%u]", tid, pid);
                 break;
             }
-            snapshot_file = manifest.name();
+            snapshot_files = Snapshot::GetSnapshotFiles(manifest);
         }
-        if (table->GetStorageMode() == common::kMemory) {
-            // send snapshot file
-            if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
-                PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
-                break;
+        bool send_failed = false;
+        for (const auto& snapshot_file : snapshot_files) {
+            int ret = 0;
+            if (table->GetStorageMode() == common::kMemory) {
+                // send snapshot file
+                ret = sender.SendFile(snapshot_file, full_path + snapshot_file);
+            } else {
+                ret = sender.SendDir(snapshot_file, full_path + snapshot_file);
             }
-        } else {
-            if (sender.SendDir(snapshot_file, full_path + snapshot_file) < 0) {
-                PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
+            if (ret < 0) {
+                PDLOG(WARNING, "send snapshot %s failed. tid[%u] pid[%u]", snapshot_file.c_str(), tid, pid);
+                send_failed = true;
                 break;
             }
         }
+        if (send_failed) {
+            break;
+        }
         // send manifest file
         file_name = "MANIFEST";
         if (sender.SendFile(file_name, full_path + file_name) < 0) {
@@ -3183,7 +3537,11 @@ void TabletImpl::LoadTable(RpcController* controller, const ::openmldb::api::Loa
         }
         std::string msg;
         if (table_meta.storage_mode() == openmldb::common::kMemory) {
-            if (CreateTableInternal(&table_meta, msg) < 0) {
+            std::shared_ptr<SnapshotStreamLoader> loader;
+            if (FLAGS_stream_load_snapshot) {
+                loader = TakeStreamLoader(tid, pid, db_path, table_meta);
+            }
+            if (CreateTableInternal(&table_meta, msg, loader ? loader->GetTable() : nullptr) < 0) {
                 response->set_code(::openmldb::base::ReturnCode::kCreateTableFailed);
                 response->set_msg(msg.c_str());
                 break;
@@ -3195,9 +3553,15 @@ void TabletImpl::LoadTable(RpcController* controller, const ::openmldb::api::Loa
             }
             PDLOG(INFO, "start to recover table with id %u pid %u name %s seg_cnt %d ", tid, pid, name.c_str(),
                   seg_cnt);
-            task_pool_.AddTask(boost::bind(&TabletImpl::LoadTableInternal, this, tid, pid, task_ptr));
+            // the data loaded while receiving the snapshot has been in memory
+            uint64_t estimated_size = loader ? 0 : EstimateRecoverSize(db_path);
+            recovery_scheduler_.Submit(tid, pid, GetRecoverPriority(table_meta), estimated_size,
+                                       boost::bind(&TabletImpl::LoadTableInternal, this, tid, pid, task_ptr, loader));
         } else {
-            task_pool_.AddTask(boost::bind(&TabletImpl::LoadDiskTableInternal, this, tid, pid, table_meta, task_ptr));
+            // the data of disk table is not loaded into memory
+            recovery_scheduler_.Submit(
+                tid, pid, GetRecoverPriority(table_meta), 0,
+                boost::bind(&TabletImpl::LoadDiskTableInternal, this, tid, pid, table_meta, task_ptr));
             PDLOG(INFO, "load table tid[%u] pid[%u] storage mode[%s]", tid, pid,
                   ::openmldb::common::StorageMode_Name(table_meta.storage_mode()).c_str());
         }
@@ -3209,7 +3573,9 @@ void TabletImpl::LoadTable(RpcController* controller, const ::openmldb::api::Loa
     SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
 }
 
-int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr) {
+int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr,
+                                  std::shared_ptr<SnapshotStreamLoader> loader) {
+    NumaDispatcher::PinScope pin_scope(numa_dispatcher_.get(), tid, pid);
     do {
         // load snapshot data
         std::shared_ptr<Table> table = GetTable(tid, pid);
@@ -3242,8 +3608,22 @@ int TabletImpl::LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::
         }
         std::string binlog_path = GetDBPath(db_root_path, tid, pid) + "/binlog/";
         ::openmldb::storage::Binlog binlog(replicator->GetLogPart(), binlog_path);
-        if (snapshot->Recover(table, snapshot_offset) &&
-            binlog.RecoverFromBinlog(table, snapshot_offset, latest_offset)) {
+        bool recovered = false;
+        if (loader) {
+            // the snapshot files are loaded while they are received, only the offsets are recovered from manifest.
+            // the table of loader begins recovering when it's created
+            recovered = loader->Wait() &&
+                        std::dynamic_pointer_cast<::openmldb::storage::MemTableSnapshot>(snapshot)->RecoverOffset(
+                            snapshot_offset);
+            PDLOG(INFO, "wait for the received snapshot to be loaded. loaded %lu records, ret %d. tid %u pid %u",
+                  loader->GetLoadedCnt(), recovered, tid, pid);
+        } else {
+            table->BeginRecover();
+            recovered = snapshot->Recover(table, snapshot_offset);
+        }
+        recovered = recovered && binlog.RecoverFromBinlog(table, snapshot_offset, latest_offset);
+        table->EndRecover();
+        if (recovered) {
             // recover aggregator if exists
             std::string aggr_path = GetDBPath(db_root_path, tid, pid) + "/aggr_info.txt";
             if (::openmldb::base::IsExists(aggr_path)) {
@@ -3434,6 +3814,7 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
             tables_[tid].erase(pid);
             replicators_[tid].erase(pid);
             snapshots_[tid].erase(pid);
+            table_map_version_.fetch_add(1, std::memory_order_release);
             if (tables_[tid].empty()) {
                 tables_.erase(tid);
             }
@@ -3444,6 +3825,12 @@ int32_t TabletImpl::DeleteTableInternal(uint32_t tid, uint32_t pid,
                 snapshots_.erase(tid);
             }
         }
+        if (numa_dispatcher_) {
+            numa_dispatcher_->UnbindPartition(tid, pid);
+        }
+        if (traverse_cursors_) {
+            traverse_cursors_->Erase(tid, pid);
+        }
         engine_->ClearCacheLocked("");
         if (replicator) {
             replicator->DelAllReplicateNode();
@@ -3774,10 +4161,12 @@ int32_t TabletImpl::GetSnapshotOffset(uint32_t tid, uint32_t pid, openmldb::comm
         PDLOG(WARNING, "parse manifest failed");
         return 0;
     }
-    std::string snapshot_file = db_path + "/snapshot/" + manifest.name();
-    if (!::openmldb::base::IsExists(snapshot_file)) {
-        PDLOG(WARNING, "snapshot file[%s] does not exist", snapshot_file.c_str());
-        return 0;
+    for (const auto& name : Snapshot::GetSnapshotFiles(manifest)) {
+        std::string snapshot_file = db_path + "/snapshot/" + name;
+        if (!::openmldb::base::IsExists(snapshot_file)) {
+            PDLOG(WARNING, "snapshot file[%s] does not exist", snapshot_file.c_str());
+            return 0;
+        }
     }
     offset = manifest.offset();
     term = manifest.term();
@@ -4091,7 +4480,155 @@ bool IsIOT(const ::openmldb::api::TableMeta* table_meta) {
     return false;
 }
 
-int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta, std::string& msg) {
+uint32_t TabletImpl::GetRecoverPriority(const ::openmldb::api::TableMeta& table_meta) {
+    uint32_t priority = 0;
+    if (!table_meta.has_mode() || table_meta.mode() == ::openmldb::api::TableMode::kTableLeader) {
+        priority += 2;
+    }
+    if (sp_cache_->IsTableUsed(table_meta.db(), table_meta.name())) {
+        priority += 1;
+    }
+    return priority;
+}
+
+uint64_t TabletImpl::EstimateRecoverSize(const std::string& db_path) {
+    uint64_t size = 0;
+    std::string snapshot_path = db_path + "/snapshot/";
+    ::openmldb::api::Manifest manifest;
+    if (Snapshot::GetLocalManifest(snapshot_path + "MANIFEST", manifest) == 0) {
+        std::vector<std::string> files;
+        if (manifest.has_image_name() && ::openmldb::base::IsExists(snapshot_path + manifest.image_name())) {
+            files.push_back(manifest.image_name());
+        } else {
+            files = Snapshot::GetSnapshotFiles(manifest);
+        }
+        for (const auto& file : files) {
+            uint64_t file_size = 0;
+            if (::openmldb::base::GetFileSize(snapshot_path + file, file_size)) {
+                size += file_size;
+            }
+        }
+    }
+    uint64_t binlog_size = 0;
+    if (::openmldb::base::IsExists(db_path + "/binlog/") &&
+        ::openmldb::base::GetDirSizeRecur(db_path + "/binlog/", binlog_size)) {
+        size += binlog_size;
+    }
+    return size;
+}
+
+void TabletImpl::AddStreamFile(uint32_t tid, uint32_t pid, const std::string& db_path, const std::string& file_name,
+                               uint64_t received_size) {
+    std::string key = std::to_string(tid) + "_" + std::to_string(pid);
+    std::shared_ptr<SnapshotStreamLoader> loader;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto iter = stream_loader_map_.find(key);
+        if (iter != stream_loader_map_.end()) {
+            loader = iter->second;
+            if (file_name == "table_meta.txt") {
+                stream_loader_map_.erase(iter);
+            }
+        }
+    }
+    if (file_name == "table_meta.txt") {
+        // table_meta.txt is sent first, the data loaded by the last transfer is discarded
+        if (loader) {
+            loader->Abort();
+        }
+        return;
+    }
+    if (!loader) {
+        std::string meta_path = db_path + "/table_meta.txt";
+        int fd = open(meta_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            PDLOG(WARNING, "[%s] does not exist, the snapshot is loaded after received. tid %u pid %u",
+                  meta_path.c_str(), tid, pid);
+            return;
+        }
+        ::openmldb::api::TableMeta table_meta;
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        if (!google::protobuf::TextFormat::Parse(&fileInput, &table_meta)) {
+            PDLOG(WARNING, "parse table_meta failed. tid %u pid %u", tid, pid);
+            return;
+        }
+        if (table_meta.storage_mode() != ::openmldb::common::kMemory || IsIOT(&table_meta)) {
+            return;
+        }
+        auto table = std::make_shared<MemTable>(table_meta);
+        if (!table->Init()) {
+            PDLOG(WARNING, "fail to init table for loading the received snapshot. tid %u pid %u", tid, pid);
+            return;
+        }
+        table->BeginRecover();
+        std::lock_guard<std::mutex> lock(mu_);
+        auto iter = stream_loader_map_.find(key);
+        if (iter == stream_loader_map_.end()) {
+            iter = stream_loader_map_.emplace(key, std::make_shared<SnapshotStreamLoader>(table)).first;
+            PDLOG(INFO, "start to load the snapshot while it's received. tid %u pid %u", tid, pid);
+        }
+        loader = iter->second;
+    }
+    // the aborted loader is kept until the next transfer or LoadTable, so the files after are not loaded
+    if (!loader->AddFile(file_name, db_path + "/snapshot/" + file_name + ".tmp", received_size)) {
+        PDLOG(WARNING, "stop loading the received snapshot at file %s. tid %u pid %u", file_name.c_str(), tid, pid);
+        loader->Abort();
+    }
+}
+
+std::shared_ptr<SnapshotStreamLoader> TabletImpl::GetStreamLoader(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stream_loader_map_.empty()) {
+        return nullptr;
+    }
+    auto iter = stream_loader_map_.find(std::to_string(tid) + "_" + std::to_string(pid));
+    if (iter == stream_loader_map_.end()) {
+        return nullptr;
+    }
+    return iter->second;
+}
+
+static bool IsSameSchema(const ::openmldb::api::TableMeta& lhs, const ::openmldb::api::TableMeta& rhs) {
+    auto serialize = [](const auto& fields) {
+        std::string value;
+        for (const auto& field : fields) {
+            value.append(field.SerializeAsString());
+        }
+        return value;
+    };
+    return lhs.seg_cnt() == rhs.seg_cnt() && lhs.compress_type() == rhs.compress_type() &&
+           serialize(lhs.column_desc()) == serialize(rhs.column_desc()) &&
+           serialize(lhs.added_column_desc()) == serialize(rhs.added_column_desc()) &&
+           serialize(lhs.column_key()) == serialize(rhs.column_key());
+}
+
+std::shared_ptr<SnapshotStreamLoader> TabletImpl::TakeStreamLoader(uint32_t tid, uint32_t pid,
+                                                                   const std::string& db_path,
+                                                                   const ::openmldb::api::TableMeta& table_meta) {
+    std::shared_ptr<SnapshotStreamLoader> loader;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto iter = stream_loader_map_.find(std::to_string(tid) + "_" + std::to_string(pid));
+        if (iter == stream_loader_map_.end()) {
+            return nullptr;
+        }
+        loader = iter->second;
+        stream_loader_map_.erase(iter);
+    }
+    ::openmldb::api::Manifest manifest;
+    if (!loader->IsReceived() || Snapshot::GetLocalManifest(db_path + "/snapshot/MANIFEST", manifest) != 0 ||
+        loader->GetFiles() != Snapshot::GetSnapshotFiles(manifest) ||
+        !IsSameSchema(*loader->GetTable()->GetTableMeta(), table_meta)) {
+        PDLOG(WARNING, "the loaded snapshot doesn't match, load it from files. tid %u pid %u", tid, pid);
+        loader->Abort();
+        return nullptr;
+    }
+    return loader;
+}
+
+int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta, std::string& msg,
+                                    std::shared_ptr<Table> loaded_table) {
     uint32_t tid = table_meta->tid();
     uint32_t pid = table_meta->pid();
     std::map<std::string, std::string> real_ep_map;
@@ -4111,6 +4648,34 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         msg.assign("fail to get table db root path");
         return -1;
     }
+    auto new_mem_table = [this, table_meta, tid, pid]() -> std::shared_ptr<Table> {
+        if (IsIOT(table_meta)) {
+            LOG(INFO) << "create iot table " << tid << "." << pid;
+            return std::make_shared<storage::IndexOrganizedTable>(*table_meta, catalog_);
+        }
+        return std::make_shared<MemTable>(*table_meta);
+    };
+    std::shared_ptr<Table> node_table;
+    if (numa_dispatcher_) {
+        numa_dispatcher_->BindPartition(tid, pid);
+        if (!loaded_table && table_meta->storage_mode() == openmldb::common::kMemory) {
+            if (GetTable(tid, pid)) {
+                PDLOG(WARNING, "table with tid[%u] and pid[%u] exists", tid, pid);
+                msg.assign("table exists");
+                return -1;
+            }
+            // the memory of the table is allocated on the node of the partition. the rpc thread is not pinned, the
+            // table is initialized by a worker of the node before locking the tables
+            node_table = new_mem_table();
+            bool init_ok = false;
+            numa_dispatcher_->RunOnNode(tid, pid, [&node_table, &init_ok] { init_ok = node_table->Init(); });
+            if (!init_ok) {
+                PDLOG(WARNING, "fail to init table. tid %u, pid %u", tid, pid);
+                msg.assign("fail to init table");
+                return -1;
+            }
+        }
+    }
     std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
     std::shared_ptr<Table> table = GetTableUnLock(tid, pid);
     if (table) {
@@ -4119,18 +4684,21 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
         return -1;
     }
     std::string table_db_path = GetDBPath(db_root_path, tid, pid);
-    if (table_meta->storage_mode() == openmldb::common::kMemory) {
-        if (IsIOT(table_meta)) {
-            LOG(INFO) << "create iot table " << tid << "." << pid;
-            table = std::make_shared<storage::IndexOrganizedTable>(*table_meta, catalog_);
-        } else {
-            table = std::make_shared<MemTable>(*table_meta);
-        }
+    if (node_table) {
+        table = node_table;
+    } else if (loaded_table) {
+        // the table has been initialized with the same schema, update the meta merged in LoadTable
+        table = loaded_table;
+        ::openmldb::api::TableMeta meta(*table_meta);
+        table->SetTableMeta(meta);
+        table->SetLeader(!table_meta->has_mode() || table_meta->mode() == ::openmldb::api::TableMode::kTableLeader);
+    } else if (table_meta->storage_mode() == openmldb::common::kMemory) {
+        table = new_mem_table();
     } else {
         table = std::make_shared<DiskTable>(*table_meta, table_db_path);
     }
 
-    if (!table->Init()) {
+    if (!loaded_table && !node_table && !table->Init()) {
         PDLOG(WARNING, "fail to init table. tid %u, pid %u", table_meta->tid(), table_meta->pid());
         msg.assign("fail to init table");
         return -1;
@@ -4176,6 +4744,7 @@ int TabletImpl::CreateTableInternal(const ::openmldb::api::TableMeta* table_meta
     tables_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), table));
     snapshots_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), snapshot));
     replicators_[table_meta->tid()].insert(std::make_pair(table_meta->pid(), replicator));
+    table_map_version_.fetch_add(1, std::memory_order_release);
     if (!table_meta->db().empty() && table_meta->mode() == ::openmldb::api::TableMode::kTableLeader) {
         if (catalog_->AddTable(*table_meta, table)) {
             LOG(INFO) << "add table " << table_meta->name() << " to catalog with db " << table_meta->db();
@@ -4297,6 +4866,26 @@ void TabletImpl::SetTaskStatus(std::shared_ptr<::openmldb::api::TaskInfo>& task_
     task_ptr->set_status(status);
 }
 
+void TabletImpl::SetTaskProgress(std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr, uint64_t processed_cnt,
+                                 uint64_t start_cnt, uint64_t start_time) {
+    if (!task_ptr) {
+        return;
+    }
+    uint64_t cost = ::baidu::common::timer::get_micros() / 1000 - start_time;
+    uint64_t cnt = processed_cnt - start_cnt;
+    std::lock_guard<std::mutex> lock(mu_);
+    task_ptr->set_processed_cnt(processed_cnt);
+    task_ptr->set_records_per_second(cost > 0 ? cnt * 1000 / cost : cnt);
+}
+
+uint64_t TabletImpl::GetTaskProgress(const std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr) {
+    if (!task_ptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    return task_ptr->processed_cnt();
+}
+
 int TabletImpl::GetTaskStatus(const std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr,
                               ::openmldb::api::TaskStatus* status) {
     if (!task_ptr) {
@@ -4360,8 +4949,15 @@ bool TabletImpl::IsExistTaskUnLock(const ::openmldb::api::TaskInfo& task) {
 }
 
 void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
+    // throttled while the task runs, the loops of the task report the busy time in slices
+    ::openmldb::storage::BackgroundThrottle throttle(
+        [this](uint64_t busy_us) { resource_governor_.ThrottleCpu(WorkClass::kBackground, busy_us); });
     std::shared_ptr<Table> table = GetTable(tid, pid);
     if (table) {
+        if (traverse_cursors_) {
+            // the traverse iterators must not live across the gc round
+            traverse_cursors_->StartGc(tid, pid);
+        }
         int32_t gc_interval = table->GetStorageMode() == common::kMemory ? FLAGS_gc_interval : FLAGS_disk_gc_interval;
         if (auto iot = std::dynamic_pointer_cast<storage::IndexOrganizedTable>(table); iot) {
             sdk::SQLRouterOptions options;
@@ -4650,26 +5246,25 @@ void TabletImpl::RefreshTableInfo() {
         engine_->ClearCacheLocked("");
     }
     // skip exist procedure, don`t need recompile
+    std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>> sp_infos;
     for (const auto& db_sp_map_kv : db_sp_map) {
         const auto& db = db_sp_map_kv.first;
         auto old_db_sp_map_it = old_db_sp_map.find(db);
-        if (old_db_sp_map_it != old_db_sp_map.end()) {
-            auto old_sp_map = old_db_sp_map_it->second;
-            for (const auto& sp_map_kv : db_sp_map_kv.second) {
-                const auto& sp_name = sp_map_kv.first;
-                auto old_sp_map_it = old_sp_map.find(sp_name);
-                if (old_sp_map_it != old_sp_map.end()) {
-                    continue;
-                } else {
-                    CreateProcedure(sp_map_kv.second);
-                }
+        for (const auto& sp_map_kv : db_sp_map_kv.second) {
+            const auto& sp_name = sp_map_kv.first;
+            if (old_db_sp_map_it != old_db_sp_map.end() &&
+                old_db_sp_map_it->second.find(sp_name) != old_db_sp_map_it->second.end()) {
+                continue;
             }
-        } else {
-            for (const auto& sp_map_kv : db_sp_map_kv.second) {
-                CreateProcedure(sp_map_kv.second);
+            // the procedure compiled with the same sql, e.g. by the CreateProcedure rpc, is still valid
+            auto cached_info = sp_cache_->FindSpProcedureInfo(db, sp_name);
+            if (cached_info.ok() && *cached_info && (*cached_info)->GetSql() == sp_map_kv.second->GetSql()) {
+                continue;
             }
+            sp_infos.push_back(sp_map_kv.second);
         }
     }
+    CreateProcedures(sp_infos);
 
     RefreshAggrCatalog();
 }
@@ -4990,80 +5585,96 @@ void TabletImpl::SendIndexDataInternal(std::shared_ptr<::openmldb::storage::Tabl
         return;
     }
     std::string index_path = GetDBPath(db_root_path, tid, pid) + "/index/";
-    for (const auto& kv : pid_endpoint_map) {
-        if (kv.first == pid) {
-            continue;
-        }
-        std::string index_file_name = absl::StrCat(pid, "_", kv.first, "_index.data");
-        std::string src_file = index_path + index_file_name;
-        if (!::openmldb::base::IsExists(src_file)) {
-            PDLOG(WARNING, "file %s does not exist. tid[%u] pid[%u]", src_file.c_str(), tid, pid);
-            continue;
-        }
-        if (kv.second == endpoint_) {
-            std::shared_ptr<Table> des_table = GetTable(tid, kv.first);
-            if (!table) {
-                PDLOG(WARNING, "table does not exist. tid[%u] pid[%u]", tid, kv.first);
-                SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                return;
-            }
-            std::string des_db_root_path;
-            if (!ChooseDBRootPath(tid, kv.first, table->GetStorageMode(), des_db_root_path)) {
-                PDLOG(WARNING, "fail to find db root path for table tid %u pid %u storage_mode %s", tid, kv.first,
-                      common::StorageMode_Name(table->GetStorageMode()));
-                SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                return;
-            }
-            std::string des_index_path = GetDBPath(des_db_root_path, tid, kv.first) + "/index/";
-            if (!::openmldb::base::IsExists(des_index_path) && !::openmldb::base::MkdirRecur(des_index_path)) {
-                PDLOG(WARNING, "mkdir failed. tid[%u] pid[%u] path[%s]", tid, pid, des_index_path.c_str());
-                SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                return;
+    // the files of different partitions are sent in parallel
+    std::atomic<bool> failed(false);
+    {
+        uint32_t thread_num = std::max(std::min(FLAGS_index_data_thread_num,
+                                                static_cast<uint32_t>(pid_endpoint_map.size())), 1u);
+        ::openmldb::base::TaskPool pool(thread_num, pid_endpoint_map.size());
+        for (const auto& kv : pid_endpoint_map) {
+            if (kv.first == pid) {
+                continue;
             }
-            if (db_root_path == des_db_root_path) {
-                if (!::openmldb::base::Rename(src_file, des_index_path + index_file_name)) {
-                    PDLOG(WARNING, "rename dir failed. tid[%u] pid[%u] file[%s]", tid, pid, index_file_name.c_str());
-                    SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                    return;
+            pool.AddTask([this, &table, &db_root_path, &index_path, &failed, &kv] {
+                if (!SendIndexFile(table, db_root_path, index_path, kv.first, kv.second)) {
+                    failed.store(true, std::memory_order_relaxed);
                 }
-                PDLOG(INFO, "rename file %s success. tid[%u] pid[%u]", index_file_name.c_str(), tid, pid);
-            } else {
-                if (!::openmldb::base::CopyFile(src_file, des_index_path + index_file_name)) {
-                    PDLOG(WARNING, "copy failed. tid[%u] pid[%u] file[%s]", tid, pid, index_file_name.c_str());
-                    SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                    return;
-                }
-                PDLOG(INFO, "copy file %s success. tid[%u] pid[%u]", index_file_name.c_str(), tid, pid);
+            });
+        }
+        pool.Stop();
+    }
+    SetTaskStatus(task_ptr, failed.load(std::memory_order_relaxed) ? ::openmldb::api::TaskStatus::kFailed
+                                                                   : ::openmldb::api::TaskStatus::kDone);
+}
+
+bool TabletImpl::SendIndexFile(const std::shared_ptr<::openmldb::storage::Table>& table,
+                               const std::string& db_root_path, const std::string& index_path, uint32_t des_pid,
+                               const std::string& endpoint) {
+    uint32_t tid = table->GetId();
+    uint32_t pid = table->GetPid();
+    std::string index_file_name = absl::StrCat(pid, "_", des_pid, "_index.data");
+    std::string src_file = index_path + index_file_name;
+    if (!::openmldb::base::IsExists(src_file)) {
+        PDLOG(WARNING, "file %s does not exist. tid[%u] pid[%u]", src_file.c_str(), tid, pid);
+        return true;
+    }
+    if (endpoint == endpoint_) {
+        std::shared_ptr<Table> des_table = GetTable(tid, des_pid);
+        if (!des_table) {
+            PDLOG(WARNING, "table does not exist. tid[%u] pid[%u]", tid, des_pid);
+            return false;
+        }
+        std::string des_db_root_path;
+        if (!ChooseDBRootPath(tid, des_pid, table->GetStorageMode(), des_db_root_path)) {
+            PDLOG(WARNING, "fail to find db root path for table tid %u pid %u storage_mode %s", tid, des_pid,
+                  common::StorageMode_Name(table->GetStorageMode()));
+            return false;
+        }
+        std::string des_index_path = GetDBPath(des_db_root_path, tid, des_pid) + "/index/";
+        if (!::openmldb::base::IsExists(des_index_path) && !::openmldb::base::MkdirRecur(des_index_path)) {
+            PDLOG(WARNING, "mkdir failed. tid[%u] pid[%u] path[%s]", tid, pid, des_index_path.c_str());
+            return false;
+        }
+        if (db_root_path == des_db_root_path) {
+            if (!::openmldb::base::Rename(src_file, des_index_path + index_file_name)) {
+                PDLOG(WARNING, "rename dir failed. tid[%u] pid[%u] file[%s]", tid, pid, index_file_name.c_str());
+                return false;
             }
+            PDLOG(INFO, "rename file %s success. tid[%u] pid[%u]", index_file_name.c_str(), tid, pid);
         } else {
-            std::string real_endpoint = kv.second;
-            if (FLAGS_use_name) {
-                auto tmp_map = std::atomic_load_explicit(&real_ep_map_, std::memory_order_acquire);
-                auto iter = tmp_map->find(kv.second);
-                if (iter == tmp_map->end()) {
-                    PDLOG(WARNING, "name %s not found in real_ep_map. tid[%u] pid[%u]", kv.second.c_str(), tid, pid);
-                    break;
-                }
-                real_endpoint = iter->second;
-            }
-            FileSender sender(tid, kv.first, table->GetStorageMode(), real_endpoint);
-            if (!sender.Init()) {
-                PDLOG(WARNING, "Init FileSender failed. tid[%u] pid[%u] des_pid[%u] endpoint[%s]", tid, pid, kv.first,
-                      kv.second.c_str());
-                SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                return;
-            }
-            if (sender.SendFile(index_file_name, std::string("index"), index_path + index_file_name) < 0) {
-                PDLOG(WARNING, "send file %s failed. tid[%u] pid[%u] des_pid[%u]", index_file_name.c_str(), tid, pid,
-                      kv.first);
-                SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kFailed);
-                return;
+            if (!::openmldb::base::CopyFile(src_file, des_index_path + index_file_name)) {
+                PDLOG(WARNING, "copy failed. tid[%u] pid[%u] file[%s]", tid, pid, index_file_name.c_str());
+                return false;
             }
-            PDLOG(INFO, "send file %s to endpoint %s success. tid[%u] pid[%u] des_pid[%u]", index_file_name.c_str(),
-                  kv.second.c_str(), tid, pid, kv.first);
+            PDLOG(INFO, "copy file %s success. tid[%u] pid[%u]", index_file_name.c_str(), tid, pid);
         }
+        return true;
     }
-    SetTaskStatus(task_ptr, ::openmldb::api::TaskStatus::kDone);
+    std::string real_endpoint = endpoint;
+    if (FLAGS_use_name) {
+        auto tmp_map = std::atomic_load_explicit(&real_ep_map_, std::memory_order_acquire);
+        auto iter = tmp_map->find(endpoint);
+        if (iter == tmp_map->end()) {
+            PDLOG(WARNING, "name %s not found in real_ep_map. tid[%u] pid[%u]", endpoint.c_str(), tid, pid);
+            return false;
+        }
+        real_endpoint = iter->second;
+    }
+    FileSender sender(tid, des_pid, table->GetStorageMode(), real_endpoint);
+    sender.SetResourceGovernor(&resource_governor_);
+    if (!sender.Init()) {
+        PDLOG(WARNING, "Init FileSender failed. tid[%u] pid[%u] des_pid[%u] endpoint[%s]", tid, pid, des_pid,
+              endpoint.c_str());
+        return false;
+    }
+    if (sender.SendFile(index_file_name, std::string("index"), index_path + index_file_name) < 0) {
+        PDLOG(WARNING, "send file %s failed. tid[%u] pid[%u] des_pid[%u]", index_file_name.c_str(), tid, pid,
+              des_pid);
+        return false;
+    }
+    PDLOG(INFO, "send file %s to endpoint %s success. tid[%u] pid[%u] des_pid[%u]", index_file_name.c_str(),
+          endpoint.c_str(), tid, pid, des_pid);
+    return true;
 }
 
 void TabletImpl::ExtractIndexDataInternal(std::shared_ptr<::openmldb::storage::Table> table,
@@ -5100,7 +5711,11 @@ void TabletImpl::ExtractIndexDataInternal(std::shared_ptr<::openmldb::storage::T
             whs[i] = std::make_shared<::openmldb::log::WriteHandle>("off", index_file_name, fd);
         }
     }
-    auto status = snapshot->ExtractIndexData(table, column_keys, whs, offset, dump_data);
+    uint64_t start_time = ::baidu::common::timer::get_micros() / 1000;
+    auto status = snapshot->ExtractIndexData(table, column_keys, whs, offset, dump_data,
+                                             [this, &task, start_time](uint64_t read_cnt) {
+                                                 SetTaskProgress(task, read_cnt, 0, start_time);
+                                             });
     if (status.OK()) {
         PDLOG(INFO, "extract index on table tid[%u] pid[%u] succeed", tid, pid);
         SetTaskStatus(task, ::openmldb::api::kDone);
@@ -5209,8 +5824,23 @@ void TabletImpl::LoadIndexDataInternal(uint32_t tid, uint32_t pid, uint32_t cur_
         SetTaskStatus(task, ::openmldb::api::TaskStatus::kFailed);
         return;
     }
-    auto seq_file = std::unique_ptr<::openmldb::log::SequentialFile>(::openmldb::log::NewSeqFile(index_file_path, fd));
+    auto seq_file = std::unique_ptr<::openmldb::log::SequentialFile>(
+        ::openmldb::log::NewReadAheadSeqFile(index_file_path, fd, FLAGS_snapshot_read_ahead_size));
     ::openmldb::log::Reader reader(seq_file.get(), nullptr, false, 0, false);
+    // the entries are appended to binlog in order and put into table by the workers in batches.
+    // the puts before a delete are waited for, so the delete is not overwritten
+    uint32_t thread_num = std::max(FLAGS_index_data_thread_num, 1u);
+    auto pool = std::make_unique<::openmldb::base::TaskPool>(thread_num, thread_num * 2);
+    using Batch = std::vector<::openmldb::api::LogEntry>;
+    auto batch = std::make_shared<Batch>();
+    auto put_batch = [&table](const std::shared_ptr<Batch>& entries) {
+        for (const auto& entry : *entries) {
+            table->Put(entry);
+        }
+    };
+    uint64_t base_cnt = GetTaskProgress(task);
+    // the entries are appended before they are put, the rows of table can't be pinned until all of them are put
+    std::shared_lock<std::shared_mutex> write_lock(replicator->GetWriteMutex());
     std::string buffer;
     uint64_t succ_cnt = 0;
     uint64_t failed_cnt = 0;
@@ -5231,13 +5861,33 @@ void TabletImpl::LoadIndexDataInternal(uint32_t tid, uint32_t pid, uint32_t cur_
         ::openmldb::api::LogEntry entry;
         entry.ParseFromString(std::string(record.data(), record.size()));
         if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            if (!batch->empty()) {
+                pool->AddTask([&put_batch, batch] { put_batch(batch); });
+                batch = std::make_shared<Batch>();
+            }
+            pool->Stop();
+            pool = std::make_unique<::openmldb::base::TaskPool>(thread_num, thread_num * 2);
             table->Delete(entry);
+            replicator->AppendEntry(entry);
         } else {
-            table->Put(entry);
+            replicator->AppendEntry(entry);
+            batch->push_back(std::move(entry));
+            if (batch->size() >= LOAD_INDEX_BATCH) {
+                pool->AddTask([&put_batch, batch] { put_batch(batch); });
+                batch = std::make_shared<Batch>();
+            }
         }
-        replicator->AppendEntry(entry);
         succ_cnt++;
+        if (succ_cnt % LOAD_INDEX_PROGRESS_INTERVAL == 0) {
+            SetTaskProgress(task, base_cnt + succ_cnt, base_cnt, cur_time);
+        }
+    }
+    if (!batch->empty()) {
+        pool->AddTask([&put_batch, batch] { put_batch(batch); });
     }
+    pool->Stop();
+    write_lock.unlock();
+    SetTaskProgress(task, base_cnt + succ_cnt, base_cnt, cur_time);
     if (cur_pid == partition_num - 1 || (cur_pid + 1 == pid && pid == partition_num - 1)) {
         if (FLAGS_recycle_bin_enabled) {
             std::string recycle_bin_root_path;
@@ -5513,6 +6163,9 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
 
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, session.GetCompileInfo(),
                                             batch_session.GetCompileInfo());
+    if (result_cache_) {
+        ResolveProcedurePartitions(*sp_info_impl);
+    }
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
@@ -5529,6 +6182,11 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
     auto is_deployment_procedure = sp_info.ok() && sp_info.value()->GetType() == hybridse::sdk::kReqDeployment;
 
     sp_cache_->DropSQLProcedureCacheEntry(db_name, sp_name);
+    if (result_cache_) {
+        result_cache_->Erase(db_name, sp_name);
+        std::lock_guard<std::mutex> lock(procedure_partitions_mu_);
+        procedure_partitions_.erase(std::make_pair(db_name, sp_name));
+    }
     if (!catalog_->DropProcedure(db_name, sp_name)) {
         LOG(WARNING) << "drop procedure " << db_name << "." << sp_name << " in catalog failed";
     }
@@ -5565,7 +6223,7 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     int32_t ret = 0;
     if (request.has_task_id()) {
         ret = session.Run(request.task_id(), row, &output);
-    } else {
+    } else if (!RunCoalescedRequest(request, row, &output)) {
         ret = session.Run(row, &output);
     }
     if (ret != 0) {
@@ -5597,6 +6255,162 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     response.set_code(::openmldb::base::kOk);
 }
 
+bool TabletImpl::RunCoalescedRequest(const openmldb::api::QueryRequest& request, const ::hybridse::codec::Row& row,
+                                     ::hybridse::codec::Row* output) {
+    if (!request_coalescer_ || !request.is_procedure() || request.is_debug()) {
+        return false;
+    }
+    hybridse::base::Status status;
+    auto compile_info = sp_cache_->GetBatchRequestInfo(request.db(), request.sp_name(), status);
+    if (!status.isOK() || !compile_info) {
+        return false;
+    }
+    // the rows are run as they are, so the common columns can't be split out
+    const auto& batch_request_info = compile_info->GetBatchRequestInfo();
+    if (!batch_request_info.common_column_indices.empty() ||
+        !batch_request_info.output_common_column_indices.empty()) {
+        return false;
+    }
+    const std::string& sp_name = request.sp_name();
+    // the procedure created again gets another compile info, so its rows are not run with the old one
+    std::string key = absl::StrCat(request.db(), ".", sp_name, ".", reinterpret_cast<uintptr_t>(compile_info.get()));
+    auto runner = [&compile_info, &sp_name](const std::vector<::hybridse::codec::Row>& rows,
+                                            std::vector<::hybridse::codec::Row>* outputs) {
+        ::hybridse::vm::BatchRequestRunSession session;
+        session.SetCompileInfo(compile_info);
+        session.SetSpName(sp_name);
+        if (session.Run(rows, *outputs) != 0) {
+            return false;
+        }
+        for (const auto& output : *outputs) {
+            if (output.GetRowPtrCnt() != 1) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return request_coalescer_->Run(key, row, runner, output);
+}
+
+void TabletImpl::RunCachedRequestQuery(RpcController* ctrl, const openmldb::api::QueryRequest& request,
+                                       ::hybridse::vm::RequestRunSession& session,
+                                       openmldb::api::QueryResponse& response, butil::IOBuf& buf) {
+    const std::string& db = request.db();
+    const std::string& sp_name = request.sp_name();
+    auto sp_info = sp_cache_->FindSpProcedureInfo(db, sp_name);
+    if (!sp_info.ok()) {
+        RunRequestQuery(ctrl, request, session, response, buf);
+        return;
+    }
+    std::string row;
+    dynamic_cast<brpc::Controller*>(ctrl)->request_attachment().copy_to(&row, request.row_size(), 0);
+    // the version is got before running, so the rows written meanwhile make the result invalid
+    uint64_t version = GetProcedureDataVersion(*sp_info.value());
+    std::string result;
+    bool hit = result_cache_->Get(db, sp_name, row, version, &result);
+    if (IsCollectDeployStatsEnabled()) {
+        auto st = deploy_collector_->CollectResultCache(db, sp_name, hit);
+    }
+    if (hit) {
+        buf.append(result);
+        response.set_schema(session.GetEncodedSchema());
+        response.set_byte_size(result.size());
+        response.set_count(1);
+        response.set_row_slices(1);
+        response.set_code(::openmldb::base::kOk);
+        return;
+    }
+    size_t offset = buf.size();
+    RunRequestQuery(ctrl, request, session, response, buf);
+    if (response.code() == ::openmldb::base::kOk) {
+        buf.copy_to(&result, buf.size() - offset, offset);
+        result_cache_->Put(db, sp_name, row, version, result);
+    }
+}
+
+std::shared_ptr<const TabletImpl::ProcedurePartitions> TabletImpl::ResolveProcedurePartitions(
+    const hybridse::sdk::ProcedureInfo& sp_info) {
+    const auto& dbs = sp_info.GetDbs();
+    const auto& tables = sp_info.GetTables();
+    auto resolved = std::make_shared<ProcedurePartitions>();
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        resolved->table_map_version = table_map_version_.load(std::memory_order_relaxed);
+        for (const auto& kv : tables_) {
+            if (kv.second.empty()) {
+                continue;
+            }
+            const auto& table = kv.second.begin()->second;
+            bool used = false;
+            for (size_t i = 0; i < tables.size() && i < dbs.size(); i++) {
+                if (tables[i] == table->GetName() && dbs[i] == table->GetDB()) {
+                    used = true;
+                    break;
+                }
+            }
+            if (!used) {
+                continue;
+            }
+            for (const auto& pkv : kv.second) {
+                resolved->partitions.push_back({kv.first, pkv.first, GetReplicatorUnLock(kv.first, pkv.first)});
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(procedure_partitions_mu_);
+    procedure_partitions_[std::make_pair(sp_info.GetDbName(), sp_info.GetSpName())] = resolved;
+    return resolved;
+}
+
+uint64_t TabletImpl::GetProcedureDataVersion(const hybridse::sdk::ProcedureInfo& sp_info) {
+    std::shared_ptr<const ProcedurePartitions> resolved;
+    {
+        std::lock_guard<std::mutex> lock(procedure_partitions_mu_);
+        auto it = procedure_partitions_.find(std::make_pair(sp_info.GetDbName(), sp_info.GetSpName()));
+        if (it != procedure_partitions_.end()) {
+            resolved = it->second;
+        }
+    }
+    if (!resolved || resolved->table_map_version != table_map_version_.load(std::memory_order_acquire)) {
+        resolved = ResolveProcedurePartitions(sp_info);
+    }
+    // the offsets are read without locking the tables
+    uint64_t version = 0;
+    for (const auto& partition : resolved->partitions) {
+        uint64_t offset = partition.replicator ? partition.replicator->GetOffset() : 0;
+        for (uint64_t value :
+             {static_cast<uint64_t>(partition.tid), static_cast<uint64_t>(partition.pid), offset}) {
+            version ^= value + 0x9e3779b97f4a7c15 + (version << 6) + (version >> 2);
+        }
+    }
+    return version;
+}
+
+void TabletImpl::CreateProcedures(const std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>>& sp_infos) {
+    uint32_t thread_num = std::min(static_cast<size_t>(FLAGS_procedure_compile_thread_num), sp_infos.size());
+    if (thread_num <= 1) {
+        for (const auto& sp_info : sp_infos) {
+            CreateProcedure(sp_info);
+        }
+        return;
+    }
+    // each compilation has its own jit, so the procedures are compiled independently
+    absl::Time start = absl::Now();
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([this, &sp_infos, &next] {
+            for (size_t idx = next.fetch_add(1); idx < sp_infos.size(); idx = next.fetch_add(1)) {
+                CreateProcedure(sp_infos[idx]);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    PDLOG(INFO, "compile %lu procedures with %u threads in %ld ms", sp_infos.size(), thread_num,
+          absl::ToInt64Milliseconds(absl::Now() - start));
+}
+
 void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
     const std::string& db_name = sp_info->GetDbName();
     const std::string& sp_name = sp_info->GetSpName();
@@ -5633,6 +6447,11 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
     }
     sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
                                             batch_session.GetCompileInfo());
+    if (result_cache_) {
+        // the procedure may be created again with another sql
+        result_cache_->Erase(db_name, sp_name);
+        ResolveProcedurePartitions(*sp_info);
+    }
 
     LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
 }
@@ -42,7 +42,14 @@
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
 #include "tablet/file_receiver.h"
+#include "tablet/numa_dispatcher.h"
+#include "tablet/procedure_result_cache.h"
+#include "tablet/recovery_scheduler.h"
+#include "tablet/request_coalescer.h"
+#include "tablet/resource_governor.h"
+#include "tablet/snapshot_stream_loader.h"
 #include "tablet/sp_cache.h"
+#include "tablet/traverse_cursor.h"
 #include "vm/engine.h"
 #include "zk/zk_client.h"
 
@@ -148,7 +155,7 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                       ::openmldb::api::GeneralResponse* response, Closure* done);
 
     void SendData(RpcController* controller, const ::openmldb::api::SendDataRequest* request,
-                  ::openmldb::api::GeneralResponse* response, Closure* done);
+                  ::openmldb::api::SendDataResponse* response, Closure* done);
 
     void GetTaskStatus(RpcController* controller, const ::openmldb::api::TaskStatusRequest* request,
                        ::openmldb::api::TaskStatusResponse* response, Closure* done);
@@ -312,7 +319,15 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void GcTableSnapshot(uint32_t tid, uint32_t pid);
 
-    int CreateTableInternal(const ::openmldb::api::TableMeta* table_meta, std::string& msg);  // NOLINT
+    // the table is created from table_meta, or loaded_table is taken if it's set
+    int CreateTableInternal(const ::openmldb::api::TableMeta* table_meta, std::string& msg,  // NOLINT
+                            std::shared_ptr<Table> loaded_table = nullptr);
+
+    // write the entries sent by the leader to the binlog and the table of the follower
+    void ApplyEntries(uint32_t tid, uint32_t pid,
+                      const ::google::protobuf::RepeatedPtrField<::openmldb::api::LogEntry>& entries,
+                      const std::shared_ptr<Table>& table, const std::shared_ptr<LogReplicator>& replicator,
+                      ::openmldb::api::AppendEntriesResponse* response);
 
     void MakeSnapshotInternal(uint32_t tid, uint32_t pid, uint64_t end_offset,
                               std::shared_ptr<::openmldb::api::TaskInfo> task, bool is_force);
@@ -329,6 +344,10 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                                const std::map<uint32_t, std::string>& pid_endpoint_map,
                                std::shared_ptr<::openmldb::api::TaskInfo> task);
 
+    // send the index file of des_pid to the endpoint, move it if the partition is on this tablet
+    bool SendIndexFile(const std::shared_ptr<::openmldb::storage::Table>& table, const std::string& db_root_path,
+                       const std::string& index_path, uint32_t des_pid, const std::string& endpoint);
+
     void LoadIndexDataInternal(uint32_t tid, uint32_t pid, uint32_t cur_pid, uint32_t partition_num, uint64_t last_time,
                                std::shared_ptr<::openmldb::api::TaskInfo> task);
 
@@ -359,7 +378,20 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     int32_t DeleteTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr);
 
-    int LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr);
+    // the snapshot data is taken from loader if it's set
+    int LoadTableInternal(uint32_t tid, uint32_t pid, std::shared_ptr<::openmldb::api::TaskInfo> task_ptr,
+                          std::shared_ptr<SnapshotStreamLoader> loader);
+    // the leader partitions and the partitions used by deployments are recovered first
+    uint32_t GetRecoverPriority(const ::openmldb::api::TableMeta& table_meta);
+    // the bytes of snapshot and binlog to be loaded into memory
+    uint64_t EstimateRecoverSize(const std::string& db_path);
+    // load the snapshot file being received into the table created from the received table meta
+    void AddStreamFile(uint32_t tid, uint32_t pid, const std::string& db_path, const std::string& file_name,
+                       uint64_t received_size);
+    std::shared_ptr<SnapshotStreamLoader> GetStreamLoader(uint32_t tid, uint32_t pid);
+    // take the loader out, return nullptr if the loaded files or the schema doesn't match the snapshot to load
+    std::shared_ptr<SnapshotStreamLoader> TakeStreamLoader(uint32_t tid, uint32_t pid, const std::string& db_path,
+                                                           const ::openmldb::api::TableMeta& table_meta);
     int LoadDiskTableInternal(uint32_t tid, uint32_t pid, const ::openmldb::api::TableMeta& table_meta,
                               std::shared_ptr<::openmldb::api::TaskInfo> task_ptr);
     int WriteTableMeta(const std::string& path, const ::openmldb::api::TableMeta* table_meta);
@@ -376,6 +408,13 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     int GetTaskStatus(const std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr, ::openmldb::api::TaskStatus* status);
 
+    // record the processed count of task and its throughput since start_time in milliseconds,
+    // when start_cnt records had been processed
+    void SetTaskProgress(std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr,  // NOLINT
+                         uint64_t processed_cnt, uint64_t start_cnt, uint64_t start_time);
+
+    uint64_t GetTaskProgress(const std::shared_ptr<::openmldb::api::TaskInfo>& task_ptr);
+
     bool IsExistTaskUnLock(const ::openmldb::api::TaskInfo& task);
 
     int CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt);
@@ -437,8 +476,35 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void RunRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
                          ::hybridse::vm::RequestRunSession& session,                  // NOLINT
                          openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+    // run the row with the concurrent rows of the same procedure in batch request mode. return false if the row is
+    // not run, e.g. coalescing is disabled or the batch fails
+    bool RunCoalescedRequest(const openmldb::api::QueryRequest& request, const ::hybridse::codec::Row& row,
+                             ::hybridse::codec::Row* output);
+    // run the deployment in request mode with the result cache
+    void RunCachedRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
+                               ::hybridse::vm::RequestRunSession& session,                  // NOLINT
+                               openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+    // the local partitions of the tables used by a procedure, they are resolved when the procedure is created and
+    // resolved again once the partitions of the tablet change
+    struct ProcedurePartitions {
+        struct Partition {
+            uint32_t tid;
+            uint32_t pid;
+            std::shared_ptr<LogReplicator> replicator;
+        };
+        // the table_map_version_ when they are resolved
+        uint64_t table_map_version = 0;
+        std::vector<Partition> partitions;
+    };
+    std::shared_ptr<const ProcedurePartitions> ResolveProcedurePartitions(
+        const hybridse::sdk::ProcedureInfo& sp_info);
+    // the version of the data in the local partitions of the tables used by the procedure, it's changed once any
+    // of the partitions is written
+    uint64_t GetProcedureDataVersion(const hybridse::sdk::ProcedureInfo& sp_info);
 
     void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
+    // compile the procedures concurrently with at most procedure_compile_thread_num threads
+    void CreateProcedures(const std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>>& sp_infos);
     base::Status CheckTable(uint32_t tid, uint32_t pid, bool check_leader, const std::shared_ptr<Table>& table);
 
     // refresh the pre-aggr tables info
@@ -453,6 +519,11 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                                 uint32_t partition_num);
 
     void UpdateMemoryUsage();
+    // update the budget of the background work by the online latency periodically
+    void AdjustResourceGovernor();
+    void ExpireTraverseCursor();
+    // expose the statistics of the compiling cache of the engine as bvars with the prefix
+    void ExposeEngineCacheStat(const std::string& prefix);
 
  private:
     Tables tables_;
@@ -467,9 +538,18 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     ThreadPool task_pool_;
     ThreadPool io_pool_;
     ThreadPool snapshot_pool_;
+    ThreadPool binlog_apply_pool_;
+    RecoveryScheduler recovery_scheduler_;
+    ResourceGovernor resource_governor_;
+    // nullptr if numa mode is disabled
+    std::unique_ptr<NumaDispatcher> numa_dispatcher_;
+    // nullptr if the traverse cursors are disabled
+    std::unique_ptr<TraverseCursorManager> traverse_cursors_;
     std::map<uint64_t, std::list<std::shared_ptr<::openmldb::api::TaskInfo>>> task_map_;
     std::set<std::string> sync_snapshot_set_;
     std::map<std::string, std::shared_ptr<FileReceiver>> file_receiver_map_;
+    // tid_pid -> the loader of the snapshot being received
+    std::map<std::string, std::shared_ptr<SnapshotStreamLoader>> stream_loader_map_;
     BulkLoadMgr bulk_load_mgr_;
     std::map<::openmldb::common::StorageMode, std::vector<std::string>> mode_root_paths_;
     std::map<::openmldb::common::StorageMode, std::vector<std::string>> mode_recycle_root_paths_;
@@ -479,11 +559,22 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<::openmldb::catalog::TabletCatalog> catalog_;
     // thread safe
     std::unique_ptr<::hybridse::vm::Engine> engine_;
+    // declared after engine_ so they're released before engine_
+    std::vector<std::unique_ptr<bvar::Variable>> engine_cache_vars_;
     std::shared_ptr<::hybridse::vm::LocalTablet> local_tablet_;
     std::string zk_cluster_;
     std::string zk_path_;
     std::string endpoint_;
     std::shared_ptr<SpCache> sp_cache_;
+    // nullptr if the result cache is disabled
+    std::unique_ptr<ProcedureResultCache> result_cache_;
+    // increased under spin_mutex_ once a partition is added to or removed from tables_
+    std::atomic<uint64_t> table_map_version_{0};
+    std::mutex procedure_partitions_mu_;
+    // (db, procedure name) -> the local partitions of the procedure, only kept if the result cache is enabled
+    std::map<std::pair<std::string, std::string>, std::shared_ptr<const ProcedurePartitions>> procedure_partitions_;
+    // nullptr if request coalescing is disabled
+    std::unique_ptr<RequestCoalescer> request_coalescer_;
     std::string notify_path_;
     std::string sp_root_path_;
     std::string globalvar_changed_notify_path_;
@@ -32,6 +32,7 @@
 #include "base/kv_iterator.h"
 #include "base/strings.h"
 #include "boost/lexical_cast.hpp"
+#include "bthread/countdown_event.h"
 #include "codec/codec.h"
 #include "codec/row_codec.h"
 #include "codec/schema_codec.h"
@@ -82,6 +83,19 @@ class MockClosure : public ::google::protobuf::Closure {
     void Run() {}
 };
 
+// the closure of the rpc which may be done asynchronously
+class WaitClosure : public ::google::protobuf::Closure {
+ public:
+    void Run() override { event_.signal(); }
+    void Wait() {
+        event_.wait();
+        event_.reset(1);
+    }
+
+ private:
+    bthread::CountdownEvent event_{1};
+};
+
 void RemoveData(const std::string& path) {
     ::openmldb::base::RemoveDir(path + "/data");
     ::openmldb::base::RemoveDir(path);
@@ -2506,7 +2520,7 @@ TEST_P(TabletImplTest, LoadWithIncompleteBinlog) {
             binlog_path = FLAGS_hdd_root_path + "/" + std::to_string(tid) + "_0/binlog";
         }
 
-        ::openmldb::base::GetFileName(binlog_path, vec);
+        ::openmldb::test::GetBinlogFileName(binlog_path, vec);
         ASSERT_EQ(4, (signed)vec.size());
         std::sort(vec.begin(), vec.end());
         std::string file_name = binlog_path + "/00000001.log";
@@ -5324,6 +5338,104 @@ TEST_P(TabletImplTest, PutCompress) {
     }
 }
 
+TEST_P(TabletImplTest, AppendEntriesCompress) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    tablet.Init("");
+    MockClosure closure;
+    uint32_t id = counter++;
+    {
+        ::openmldb::api::CreateTableRequest request;
+        ::openmldb::api::TableMeta* table_meta = request.mutable_table_meta();
+        table_meta->set_name("t0");
+        table_meta->set_tid(id);
+        table_meta->set_pid(0);
+        table_meta->set_storage_mode(storage_mode);
+        table_meta->set_mode(::openmldb::api::TableMode::kTableFollower);
+        AddDefaultSchema(0, 0, ::openmldb::type::TTLType::kAbsoluteTime, table_meta);
+        ::openmldb::api::CreateTableResponse response;
+        tablet.CreateTable(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+    }
+    {
+        // leader proposes snappy when matching log offset
+        ::openmldb::api::AppendEntriesRequest request;
+        request.set_tid(id);
+        request.set_pid(0);
+        request.set_pre_log_index(0);
+        request.set_compress_type(::openmldb::type::CompressType::kSnappy);
+        ::openmldb::api::AppendEntriesResponse response;
+        tablet.AppendEntries(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(0, (int64_t)response.log_offset());
+        ASSERT_EQ(::openmldb::type::CompressType::kSnappy, response.compress_type());
+    }
+    {
+        ::openmldb::api::LogEntryBatch batch;
+        for (int i = 0; i < 10; i++) {
+            auto entry = batch.add_entries();
+            entry->set_log_index(i + 1);
+            entry->set_ts(9527 + i);
+            entry->set_value(::openmldb::test::EncodeKV("key", "value" + std::to_string(i)));
+            auto dim = entry->add_dimensions();
+            dim->set_key("key");
+            dim->set_idx(0);
+        }
+        std::string raw;
+        ASSERT_TRUE(batch.SerializeToString(&raw));
+        std::string compressed;
+        ::snappy::Compress(raw.data(), raw.size(), &compressed);
+        ::openmldb::api::AppendEntriesRequest request;
+        request.set_tid(id);
+        request.set_pid(0);
+        request.set_pre_log_index(0);
+        request.set_compress_type(::openmldb::type::CompressType::kSnappy);
+        request.set_compressed_entries(compressed);
+        ::openmldb::api::AppendEntriesResponse response;
+        // the compressed entries are applied in the thread pool
+        WaitClosure wait_closure;
+        tablet.AppendEntries(NULL, &request, &response, &wait_closure);
+        wait_closure.Wait();
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(10, (int64_t)response.log_offset());
+
+        request.set_compressed_entries("bad data");
+        tablet.AppendEntries(NULL, &request, &response, &wait_closure);
+        wait_closure.Wait();
+        ASSERT_EQ(122, response.code());
+
+        // the batch resent by the leader is applied concurrently with the stale one, the rows are put once
+        request.set_compressed_entries(compressed);
+        ::openmldb::api::AppendEntriesResponse resent_response;
+        WaitClosure resent_closure;
+        tablet.AppendEntries(NULL, &request, &response, &wait_closure);
+        tablet.AppendEntries(NULL, &request, &resent_response, &resent_closure);
+        ::openmldb::api::AppendEntriesRequest raw_request;
+        raw_request.set_tid(id);
+        raw_request.set_pid(0);
+        raw_request.set_pre_log_index(0);
+        raw_request.mutable_entries()->CopyFrom(batch.entries());
+        ::openmldb::api::AppendEntriesResponse raw_response;
+        tablet.AppendEntries(NULL, &raw_request, &raw_response, &closure);
+        wait_closure.Wait();
+        resent_closure.Wait();
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(0, resent_response.code());
+        ASSERT_EQ(0, raw_response.code());
+        ASSERT_EQ(10, (int64_t)resent_response.log_offset());
+    }
+    {
+        ::openmldb::api::CountRequest request;
+        request.set_tid(id);
+        request.set_pid(0);
+        request.set_key("key");
+        ::openmldb::api::CountResponse response;
+        tablet.Count(NULL, &request, &response, &closure);
+        ASSERT_EQ(0, response.code());
+        ASSERT_EQ(10, (int32_t)response.count());
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(TabletMemAndHDD, TabletImplTest,
                          ::testing::Values(::openmldb::common::kMemory, /*::openmldb::common::kSSD,*/
                                            ::openmldb::common::kHDD));
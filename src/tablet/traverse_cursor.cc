@@ -0,0 +1,106 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/traverse_cursor.h"
+
+#include <utility>
+#include <vector>
+
+namespace openmldb {
+namespace tablet {
+
+TraverseCursorManager::TraverseCursorManager(uint32_t max_cursor_num, uint64_t idle_timeout_ms)
+    : max_cursor_num_(max_cursor_num), idle_timeout_(idle_timeout_ms) {}
+
+uint64_t TraverseCursorManager::Put(std::unique_ptr<TraverseCursor> cursor) {
+    // the dropped cursors are released out of the lock
+    std::vector<std::unique_ptr<TraverseCursor>> dropped;
+    std::lock_guard<std::mutex> lock(mu_);
+    auto round_it = gc_rounds_.find({cursor->tid, cursor->pid});
+    if (round_it != gc_rounds_.end() && round_it->second != cursor->gc_round) {
+        dropped.push_back(std::move(cursor));
+        return 0;
+    }
+    auto now = Clock::now();
+    ExpireIdleLocked(now);
+    while (!cursors_.empty() && cursors_.size() >= max_cursor_num_) {
+        dropped.push_back(std::move(cursors_.begin()->second.cursor));
+        cursors_.erase(cursors_.begin());
+    }
+    uint64_t id = next_id_++;
+    cursors_.emplace(id, Entry{std::move(cursor), now});
+    return id;
+}
+
+std::unique_ptr<TraverseCursor> TraverseCursorManager::Take(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = cursors_.find(id);
+    if (it == cursors_.end()) {
+        return {};
+    }
+    std::unique_ptr<TraverseCursor> cursor;
+    if (Clock::now() - it->second.access_time <= idle_timeout_) {
+        cursor = std::move(it->second.cursor);
+    }
+    cursors_.erase(it);
+    return cursor;
+}
+
+void TraverseCursorManager::Erase(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    EraseLocked(tid, pid);
+}
+
+uint64_t TraverseCursorManager::GetGcRound(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = gc_rounds_.find({tid, pid});
+    return it == gc_rounds_.end() ? 0 : it->second;
+}
+
+void TraverseCursorManager::StartGc(uint32_t tid, uint32_t pid) {
+    std::lock_guard<std::mutex> lock(mu_);
+    gc_rounds_[{tid, pid}]++;
+    EraseLocked(tid, pid);
+}
+
+void TraverseCursorManager::EraseLocked(uint32_t tid, uint32_t pid) {
+    for (auto it = cursors_.begin(); it != cursors_.end();) {
+        if (it->second.cursor->tid == tid && it->second.cursor->pid == pid) {
+            it = cursors_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TraverseCursorManager::ExpireIdle() {
+    std::lock_guard<std::mutex> lock(mu_);
+    ExpireIdleLocked(Clock::now());
+}
+
+void TraverseCursorManager::ExpireIdleLocked(Clock::time_point now) {
+    while (!cursors_.empty() && now - cursors_.begin()->second.access_time > idle_timeout_) {
+        cursors_.erase(cursors_.begin());
+    }
+}
+
+uint32_t TraverseCursorManager::GetSize() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return cursors_.size();
+}
+
+}  // namespace tablet
+}  // namespace openmldb
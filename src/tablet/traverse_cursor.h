@@ -0,0 +1,96 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+
+#include "storage/iterator.h"
+
+namespace openmldb {
+namespace storage {
+class Table;
+}
+
+namespace tablet {
+
+// the state of an unfinished traverse, the iterator is positioned at the first record not returned yet
+struct TraverseCursor {
+    uint32_t tid = 0;
+    uint32_t pid = 0;
+    uint32_t idx = 0;
+    // keep the table alive while the iterator refers to its data
+    std::shared_ptr<storage::Table> table;
+    std::unique_ptr<storage::TableIterator> it;
+    std::string last_pk;
+    uint64_t last_time = 0;
+    uint32_t ts_pos = 0;
+    // the gc round of the partition when the iterator is created, see TraverseCursorManager::StartGc
+    uint64_t gc_round = 0;
+};
+
+// TraverseCursorManager keeps the iterators of the unfinished traverses between the requests, so the next request
+// continues from the iterator instead of seeking the last pk again. A cursor is owned by one request at a time,
+// Take removes it from the manager and Put gives it back with a new id. The cursors not used for idle_timeout_ms
+// are dropped, and the oldest one is dropped if there are more than max_cursor_num cursors.
+// The nodes removed by a gc round are freed in the next one, so an iterator must not live across a whole gc round.
+// StartGc drops the cursors of the partition, and the cursors created before it are not accepted by Put any more
+class TraverseCursorManager {
+ public:
+    TraverseCursorManager(uint32_t max_cursor_num, uint64_t idle_timeout_ms);
+    TraverseCursorManager(const TraverseCursorManager&) = delete;
+    TraverseCursorManager& operator=(const TraverseCursorManager&) = delete;
+
+    // return the id of the cursor, 0 if the cursor is dropped as a gc round of its partition started after it's created
+    uint64_t Put(std::unique_ptr<TraverseCursor> cursor);
+    // nullptr if the cursor is not found or expired
+    std::unique_ptr<TraverseCursor> Take(uint64_t id);
+    // drop the cursors of the partition
+    void Erase(uint32_t tid, uint32_t pid);
+    // call it before creating the iterator, it's saved in TraverseCursor::gc_round
+    uint64_t GetGcRound(uint32_t tid, uint32_t pid);
+    // call it before a gc round of the partition
+    void StartGc(uint32_t tid, uint32_t pid);
+    void ExpireIdle();
+    uint32_t GetSize();
+
+ private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry {
+        std::unique_ptr<TraverseCursor> cursor;
+        Clock::time_point access_time;
+    };
+    void ExpireIdleLocked(Clock::time_point now);
+    void EraseLocked(uint32_t tid, uint32_t pid);
+
+    uint32_t max_cursor_num_;
+    std::chrono::milliseconds idle_timeout_;
+    std::mutex mu_;
+    uint64_t next_id_ = 1;
+    // the ids grow with the access time, so the first one is the oldest
+    std::map<uint64_t, Entry> cursors_;
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> gc_rounds_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
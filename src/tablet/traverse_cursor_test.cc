@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/traverse_cursor.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "base/glog_wrapper.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+namespace openmldb::tablet {
+
+class TraverseCursorTest : public ::testing::Test {};
+
+std::unique_ptr<TraverseCursor> MakeCursor(uint32_t tid, uint32_t pid, const std::string& pk) {
+    auto cursor = std::make_unique<TraverseCursor>();
+    cursor->tid = tid;
+    cursor->pid = pid;
+    cursor->last_pk = pk;
+    return cursor;
+}
+
+TEST_F(TraverseCursorTest, PutAndTake) {
+    TraverseCursorManager manager(10, 60000);
+    uint64_t id1 = manager.Put(MakeCursor(1, 0, "pk1"));
+    uint64_t id2 = manager.Put(MakeCursor(1, 1, "pk2"));
+    ASSERT_NE(0u, id1);
+    ASSERT_NE(id1, id2);
+    ASSERT_EQ(2u, manager.GetSize());
+    auto cursor = manager.Take(id1);
+    ASSERT_TRUE(cursor);
+    ASSERT_EQ("pk1", cursor->last_pk);
+    // a cursor is taken only once
+    ASSERT_FALSE(manager.Take(id1));
+    ASSERT_FALSE(manager.Take(100));
+    uint64_t id3 = manager.Put(std::move(cursor));
+    ASSERT_NE(id1, id3);
+    ASSERT_EQ(2u, manager.GetSize());
+    manager.Erase(1, 1);
+    ASSERT_FALSE(manager.Take(id2));
+    ASSERT_TRUE(manager.Take(id3));
+    ASSERT_EQ(0u, manager.GetSize());
+}
+
+TEST_F(TraverseCursorTest, DropOldest) {
+    TraverseCursorManager manager(2, 60000);
+    uint64_t id1 = manager.Put(MakeCursor(1, 0, "pk1"));
+    uint64_t id2 = manager.Put(MakeCursor(1, 0, "pk2"));
+    uint64_t id3 = manager.Put(MakeCursor(1, 0, "pk3"));
+    ASSERT_EQ(2u, manager.GetSize());
+    ASSERT_FALSE(manager.Take(id1));
+    ASSERT_TRUE(manager.Take(id2));
+    ASSERT_TRUE(manager.Take(id3));
+}
+
+TEST_F(TraverseCursorTest, ExpireIdle) {
+    TraverseCursorManager manager(10, 50);
+    uint64_t id1 = manager.Put(MakeCursor(1, 0, "pk1"));
+    uint64_t id2 = manager.Put(MakeCursor(1, 0, "pk2"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(manager.Take(id1));
+    ASSERT_EQ(1u, manager.GetSize());
+    manager.ExpireIdle();
+    ASSERT_EQ(0u, manager.GetSize());
+    ASSERT_FALSE(manager.Take(id2));
+}
+
+TEST_F(TraverseCursorTest, StartGc) {
+    TraverseCursorManager manager(10, 60000);
+    ASSERT_EQ(0u, manager.GetGcRound(1, 0));
+    uint64_t id1 = manager.Put(MakeCursor(1, 0, "pk1"));
+    uint64_t id2 = manager.Put(MakeCursor(1, 1, "pk2"));
+    // a cursor taken before the gc round is not accepted after it
+    auto cursor = manager.Take(id2);
+    ASSERT_TRUE(cursor);
+    auto in_flight = MakeCursor(1, 0, "pk3");
+    manager.StartGc(1, 0);
+    ASSERT_EQ(1u, manager.GetGcRound(1, 0));
+    ASSERT_EQ(0u, manager.GetGcRound(1, 1));
+    ASSERT_FALSE(manager.Take(id1));
+    ASSERT_EQ(0u, manager.Put(std::move(in_flight)));
+    ASSERT_NE(0u, manager.Put(std::move(cursor)));
+    auto new_cursor = MakeCursor(1, 0, "pk4");
+    new_cursor->gc_round = manager.GetGcRound(1, 0);
+    uint64_t id3 = manager.Put(std::move(new_cursor));
+    ASSERT_NE(0u, id3);
+    ASSERT_EQ(2u, manager.GetSize());
+    ASSERT_TRUE(manager.Take(id3));
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -25,6 +25,7 @@
 #include "absl/cleanup/cleanup.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "base/file_util.h"
 #include "brpc/server.h"
 #include "codec/sdk_codec.h"
 #include "gflags/gflags.h"
@@ -281,6 +282,16 @@ std::string GetExeDir() {
     return std::string(path);
 }
 
+void GetBinlogFileName(const std::string& binlog_path, std::vector<std::string>& vec) {  // NOLINT
+    std::vector<std::string> files;
+    ::openmldb::base::GetFileName(binlog_path, files);
+    for (const auto& file : files) {
+        if (file.size() > 4 && file.compare(file.size() - 4, 4, ".log") == 0) {
+            vec.push_back(file);
+        }
+    }
+}
+
 std::string GetParentDir(const std::string& path) {
     if (path.empty()) {
         return "";
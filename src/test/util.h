@@ -98,6 +98,9 @@ void ExpectResultSetStrEq(const std::vector<std::vector<CellExpectInfo>>& expect
 
 std::string GetExeDir();
 
+// the binlog dir has the sparse index files of binlog too, only list the binlog files
+void GetBinlogFileName(const std::string& binlog_path, std::vector<std::string>& vec);  // NOLINT
+
 std::string GetParentDir(const std::string& path);
 
 api::TableMeta CreateTableMeta(const std::string& name, uint32_t tid, uint32_t pid,
@@ -54,10 +54,12 @@ void LogExporter::ReadManifest() {
     if (::openmldb::storage::Snapshot::GetLocalManifest(manifest_path, manifest)) {
         return;
     }
-    std::string snapshot_name = manifest.name();
-    snapshot_path_ = table_dir_path_ + "/snapshot/" + snapshot_name;
+    for (const auto& snapshot_name : ::openmldb::storage::Snapshot::GetSnapshotFiles(manifest)) {
+        snapshot_paths_.push_back(table_dir_path_ + "/snapshot/" + snapshot_name);
+        PDLOG(INFO, "Snapshot's path: %s.", snapshot_paths_.back().c_str());
+    }
     offset_ = manifest.offset();
-    PDLOG(INFO, "Snapshot's offset: %lu, path: %s.", offset_, snapshot_path_.c_str());
+    PDLOG(INFO, "Snapshot's offset: %lu.", offset_);
 }
 
 void LogExporter::ExportTable() {
@@ -70,10 +72,13 @@ void LogExporter::ExportTable() {
         if (ptr->d_name[0] == '.')
             continue;
         std::string log = log_dir + ptr->d_name;
+        // skip the sparse index of binlog
+        if (log.size() <= 4 || log.substr(log.size() - 4) != ".log")
+            continue;
         file_path.emplace_back(log);
     }
-    if (snapshot_path_.length()) {
-        ReadSnapshot();
+    for (const auto& snapshot_path : snapshot_paths_) {
+        ReadSnapshot(snapshot_path);
     }
     (void) closedir(dir);
     // Sorts binlog files and performs binary search
@@ -171,17 +176,17 @@ void LogExporter::ReadLog(const std::string &log_path) {
     offset_ += success_cnt;
 }
 
-void LogExporter::ReadSnapshot() {
-    FILE* fd_r = fopen(snapshot_path_.c_str(), "rb");
+void LogExporter::ReadSnapshot(const std::string& snapshot_path) {
+    FILE* fd_r = fopen(snapshot_path.c_str(), "rb");
     if (fd_r == NULL) {
-        PDLOG(ERROR, "fopen failed: %s", snapshot_path_.c_str());
+        PDLOG(ERROR, "fopen failed: %s", snapshot_path.c_str());
         return;
     }
-    SequentialFile* rf = NewSeqFile(snapshot_path_, fd_r);
+    SequentialFile* rf = NewSeqFile(snapshot_path, fd_r);
     std::string scratch;
     bool is_compress = false;
-    if (snapshot_path_.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
-        snapshot_path_.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
+    if (snapshot_path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
+        snapshot_path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
         is_compress = true;
     }
     Reader reader(rf, NULL, true, 0, is_compress);
@@ -197,6 +202,10 @@ void LogExporter::ReadSnapshot() {
         }
         ::openmldb::api::LogEntry entry;
         entry.ParseFromString(value.ToString());
+        // Skip the delete entries of snapshot deltas
+        if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            continue;
+        }
 
         // Determine if there is a dimension with an idx of 0 in the dimensions.
         // If so, parse the value, else skip it
@@ -49,7 +49,7 @@ class LogExporter {
 
     Schema GetSchema() const { return schema_; }
 
-    std::string GetSnapshotPath() { return snapshot_path_; }
+    const std::vector<std::string>& GetSnapshotPaths() const { return snapshot_paths_; }
 
     int GetOffset() const { return offset_; }
 
@@ -57,14 +57,14 @@ class LogExporter {
     std::string table_dir_path_;
     std::ofstream& table_cout_;
     uint64_t offset_;
-    std::string snapshot_path_;
+    std::vector<std::string> snapshot_paths_;
     Schema schema_;
 
     uint64_t GetLogStartOffset(std::string&);
 
     void ReadLog(const std::string&);
 
-    void ReadSnapshot();
+    void ReadSnapshot(const std::string& snapshot_path);
 
     void WriteToFile(RowView&);
 };